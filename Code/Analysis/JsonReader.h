@@ -0,0 +1,239 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <format>
+#include <variant>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+
+
+class JsonError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+
+// A parsed JSON value. Objects keep their keys sorted, which is fine for reading
+// result files.
+class JsonValue {
+public:
+	using Array = std::vector<JsonValue>;
+	using Object = std::map<std::string, JsonValue, std::less<>>;
+
+	JsonValue() = default;
+	JsonValue(bool value) : value(value) {}
+	JsonValue(double value) : value(value) {}
+	JsonValue(std::string value) : value(std::move(value)) {}
+	JsonValue(Array value) : value(std::make_shared<Array>(std::move(value))) {}
+	JsonValue(Object value) : value(std::make_shared<Object>(std::move(value))) {}
+
+	bool isNull() const { return std::holds_alternative<std::monostate>(this->value); }
+	bool isNumber() const { return std::holds_alternative<double>(this->value); }
+	bool isString() const { return std::holds_alternative<std::string>(this->value); }
+	bool isArray() const { return std::holds_alternative<std::shared_ptr<Array>>(this->value); }
+	bool isObject() const { return std::holds_alternative<std::shared_ptr<Object>>(this->value); }
+
+	double number(double fallback = 0.0) const
+	{
+		return this->isNumber() ? std::get<double>(this->value) : fallback;
+	}
+
+	bool boolean(bool fallback = false) const
+	{
+		return std::holds_alternative<bool>(this->value) ? std::get<bool>(this->value) : fallback;
+	}
+
+	std::string string(const std::string& fallback = {}) const
+	{
+		return this->isString() ? std::get<std::string>(this->value) : fallback;
+	}
+
+	const Array& array() const
+	{
+		static const Array empty;
+		return this->isArray() ? *std::get<std::shared_ptr<Array>>(this->value) : empty;
+	}
+
+	const Object& object() const
+	{
+		static const Object empty;
+		return this->isObject() ? *std::get<std::shared_ptr<Object>>(this->value) : empty;
+	}
+
+	// The member with the given key, or null
+	const JsonValue& operator[](std::string_view key) const
+	{
+		static const JsonValue null;
+		auto& object = this->object();
+		auto member = object.find(key);
+		return member != object.end() ? member->second : null;
+	}
+
+	std::variant<std::monostate, bool, double, std::string, std::shared_ptr<Array>, std::shared_ptr<Object>> value;
+};
+
+
+// Recursive descent parser for the JSON files written by ResultWriter
+class JsonReader {
+public:
+	static JsonValue parse(std::string_view text)
+	{
+		JsonReader reader(text);
+		auto value = reader.parseValue();
+		reader.skipWhitespace();
+		if (reader.position != text.size()) {
+			reader.fail("unexpected characters after the value");
+		}
+		return value;
+	}
+
+	explicit JsonReader(std::string_view text) :
+		text(text)
+	{
+	}
+
+	JsonValue parseValue()
+	{
+		this->skipWhitespace();
+		switch (this->peek()) {
+		case '{': return this->parseObject();
+		case '[': return this->parseArray();
+		case '"': return this->parseString();
+		case 't': this->expect("true"); return JsonValue(true);
+		case 'f': this->expect("false"); return JsonValue(false);
+		case 'n': this->expect("null"); return JsonValue();
+		default: return this->parseNumber();
+		}
+	}
+
+	JsonValue parseObject()
+	{
+		JsonValue::Object object;
+		this->expect("{");
+		this->skipWhitespace();
+		if (this->peek() == '}') {
+			this->position++;
+			return object;
+		}
+		while (true) {
+			this->skipWhitespace();
+			auto key = this->parseString();
+			this->skipWhitespace();
+			this->expect(":");
+			object[key] = this->parseValue();
+			this->skipWhitespace();
+			if (this->peek() == ',') {
+				this->position++;
+				continue;
+			}
+			this->expect("}");
+			return object;
+		}
+	}
+
+	JsonValue parseArray()
+	{
+		JsonValue::Array array;
+		this->expect("[");
+		this->skipWhitespace();
+		if (this->peek() == ']') {
+			this->position++;
+			return array;
+		}
+		while (true) {
+			array.push_back(this->parseValue());
+			this->skipWhitespace();
+			if (this->peek() == ',') {
+				this->position++;
+				continue;
+			}
+			this->expect("]");
+			return array;
+		}
+	}
+
+	std::string parseString()
+	{
+		this->expect("\"");
+		std::string s;
+		while (true) {
+			auto c = this->next();
+			if (c == '"') {
+				return s;
+			}
+			if (c != '\\') {
+				s += c;
+				continue;
+			}
+			switch (auto escaped = this->next()) {
+			case 'n': s += '\n'; break;
+			case 'r': s += '\r'; break;
+			case 't': s += '\t'; break;
+			case 'b': s += '\b'; break;
+			case 'f': s += '\f'; break;
+			case 'u': {
+				// only code points below 0x80 are written by ResultWriter
+				auto hex = this->text.substr(this->position, 4);
+				unsigned codePoint = 0;
+				std::from_chars(hex.data(), hex.data() + hex.size(), codePoint, 16);
+				this->position += 4;
+				s += static_cast<char>(codePoint < 0x80 ? codePoint : '?');
+				break;
+			}
+			default: s += escaped; break;
+			}
+		}
+	}
+
+	JsonValue parseNumber()
+	{
+		auto begin = this->text.data() + this->position;
+		double value = 0.0;
+		auto [end, error] = std::from_chars(begin, this->text.data() + this->text.size(), value);
+		if (error != std::errc() || end == begin) {
+			this->fail("expected a value");
+		}
+		this->position += end - begin;
+		return value;
+	}
+
+	void skipWhitespace()
+	{
+		while (this->position < this->text.size() && std::string_view(" \t\r\n").find(this->text[this->position]) != std::string_view::npos) {
+			this->position++;
+		}
+	}
+
+	char peek() const
+	{
+		return this->position < this->text.size() ? this->text[this->position] : '\0';
+	}
+
+	char next()
+	{
+		if (this->position >= this->text.size()) {
+			this->fail("unexpected end of input");
+		}
+		return this->text[this->position++];
+	}
+
+	void expect(std::string_view token)
+	{
+		if (this->text.substr(this->position, token.size()) != token) {
+			this->fail(std::format("expected '{}'", token));
+		}
+		this->position += token.size();
+	}
+
+	[[noreturn]] void fail(const std::string& message) const
+	{
+		throw JsonError(std::format("JSON parse error at offset {}: {}", this->position, message));
+	}
+
+	std::string_view text;
+	size_t position{ 0 };
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <Analysis/JsonReader.h>
+#include <Statistics.h>
+
+#include <string>
+#include <vector>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <charconv>
+#include <filesystem>
+#include <string_view>
+
+
+// The per-batch timings of one benchmark run, from any of the result file formats
+struct RunData {
+	std::filesystem::path path;
+	std::string title;						// device and driver, or the first line of a legacy file
+	std::string parameters;					// run configuration, if the file has one
+	std::vector<double> completionTimes;	// ms per batch
+	std::vector<double> submitTimes;		// ms per batch, empty for legacy files
+	std::vector<double> coverage;			// percentage of the image resident after each batch
+
+	// name of the run in tables and plot legends
+	std::string name() const
+	{
+		return this->path.stem().string();
+	}
+};
+
+
+// Least squares fit of completion time (ms) over coverage (%)
+inline LinearFit getCoverageFit(const RunData& run)
+{
+	return fitLine(run.coverage, run.completionTimes);
+}
+
+
+class RunLoader {
+public:
+	static RunData load(const std::filesystem::path& path, uint32_t legacyBatchSize = 16)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error(std::format("could not open {}", path.string()));
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		auto text = stream.str();
+
+		RunData run;
+		run.path = path;
+		if (path.extension() == ".json") {
+			loadJson(run, text);
+		}
+		else if (path.extension() == ".csv") {
+			loadCsv(run, text);
+		}
+		else {
+			loadText(run, text, legacyBatchSize);
+		}
+		if (run.completionTimes.empty()) {
+			throw std::runtime_error(std::format("{}: no timings found", path.string()));
+		}
+		return run;
+	}
+
+	static bool parseDouble(std::string_view s, double& value)
+	{
+		while (!s.empty() && (s.back() == '\r' || s.back() == ' ' || s.back() == '\t')) {
+			s.remove_suffix(1);
+		}
+		auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+		return error == std::errc() && end == s.data() + s.size() && !s.empty();
+	}
+
+	static std::vector<std::string_view> split(std::string_view s, char separator)
+	{
+		std::vector<std::string_view> fields;
+		while (true) {
+			auto next = s.find(separator);
+			fields.push_back(s.substr(0, next));
+			if (next == std::string_view::npos) {
+				return fields;
+			}
+			s = s.substr(next + 1);
+		}
+	}
+
+	// The original format: a title line, then one completion time per line. Every
+	// batch bound legacyBatchSize tiles and the whole image was covered at the end.
+	// Lines that are not a single number, e.g. the tables of merged multi-process
+	// results, are skipped.
+	static void loadText(RunData& run, std::string_view text, uint32_t legacyBatchSize)
+	{
+		bool first = true;
+		for (auto line : split(text, '\n')) {
+			if (first) {
+				run.title = std::string(line.substr(0, line.find_last_not_of("\r\n ") + 1));
+				first = false;
+				continue;
+			}
+			double value;
+			if (parseDouble(line, value)) {
+				run.completionTimes.push_back(value);
+			}
+		}
+		auto batches = run.completionTimes.size();
+		for (size_t batch = 0; batch < batches; batch++) {
+			run.coverage.push_back(100.0 * (batch + 1) / batches);
+		}
+		run.parameters = std::format("legacy, batch{}", legacyBatchSize);
+	}
+
+	static void loadJson(RunData& run, std::string_view text)
+	{
+		auto json = JsonReader::parse(text);
+		auto& device = json["device"];
+		run.title = std::format("{}, Driver version: {}", device["name"].string(), device["driverVersion"].string());
+		if (!json["label"].string().empty()) {
+			run.title += std::format(" ({})", json["label"].string());
+		}
+
+		auto& configuration = json["configuration"];
+		for (auto& [key, value] : configuration.object()) {
+			if (!run.parameters.empty()) {
+				run.parameters += ", ";
+			}
+			if (value.isArray()) {
+				auto& extent = value.array();
+				run.parameters += std::format("{} {}x{}x{}", key,
+					extent.size() > 0 ? extent[0].number() : 0.0,
+					extent.size() > 1 ? extent[1].number() : 0.0,
+					extent.size() > 2 ? extent[2].number() : 0.0);
+			}
+			else if (value.isString()) {
+				run.parameters += std::format("{} {}", key, value.string());
+			}
+			else if (value.isNumber()) {
+				run.parameters += std::format("{} {}", key, value.number());
+			}
+			else {
+				run.parameters += std::format("{} {}", key, value.boolean() ? "on" : "off");
+			}
+		}
+
+		for (auto& batch : json["batches"].array()) {
+			run.completionTimes.push_back(batch["completionTime"].number());
+			run.submitTimes.push_back(batch["submitTime"].number());
+			run.coverage.push_back(batch["coverage"].number());
+		}
+	}
+
+	static void loadCsv(RunData& run, std::string_view text)
+	{
+		std::vector<std::string_view> columns;
+		for (auto line : split(text, '\n')) {
+			if (line.starts_with("# device: ")) {
+				run.title = std::string(line.substr(10, line.find_last_not_of("\r\n ") - 9));
+				continue;
+			}
+			if (line.starts_with("# parameters: ")) {
+				run.parameters = std::string(line.substr(14, line.find_last_not_of("\r\n ") - 13));
+				continue;
+			}
+			if (line.empty() || line.starts_with('#')) {
+				continue;
+			}
+			auto fields = split(line, ',');
+			if (columns.empty()) {
+				columns = fields;
+				continue;
+			}
+			auto field = [&](std::string_view name) {
+				double value = 0.0;
+				for (size_t i = 0; i < columns.size() && i < fields.size(); i++) {
+					if (columns[i].starts_with(name)) {
+						parseDouble(fields[i], value);
+					}
+				}
+				return value;
+			};
+			run.completionTimes.push_back(field("completionTime"));
+			run.submitTimes.push_back(field("submitTime"));
+			run.coverage.push_back(field("coverage"));
+		}
+	}
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cmath>
+#include <array>
+#include <string>
+#include <vector>
+#include <format>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <string_view>
+
+
+// Line plot of one or more series, written as SVG. Values above yMax are drawn at
+// the top edge, so that a few outliers do not flatten the rest of the plot.
+class SvgPlot {
+public:
+	static constexpr double width = 800.0;
+	static constexpr double height = 600.0;
+	static constexpr double left = 80.0;
+	static constexpr double right = 20.0;
+	static constexpr double top = 50.0;
+	static constexpr double bottom = 60.0;
+	static constexpr std::array colors{ "#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd", "#8c564b", "#e377c2", "#7f7f7f", "#bcbd22", "#17becf" };
+
+	struct Series {
+		std::string name;
+		std::vector<double> x;
+		std::vector<double> y;
+	};
+
+	static std::string escape(std::string_view s)
+	{
+		std::string escaped;
+		for (auto c : s) {
+			switch (c) {
+			case '&': escaped += "&amp;"; break;
+			case '<': escaped += "&lt;"; break;
+			case '>': escaped += "&gt;"; break;
+			case '"': escaped += "&quot;"; break;
+			default: escaped += c; break;
+			}
+		}
+		return escaped;
+	}
+
+	// 1, 2 or 5 times a power of ten, so that range is divided into about count steps
+	static double getTickStep(double range, int count)
+	{
+		if (range <= 0.0) {
+			return 1.0;
+		}
+		auto step = range / count;
+		auto magnitude = std::pow(10.0, std::floor(std::log10(step)));
+		auto normalized = step / magnitude;
+		return magnitude * (normalized < 1.5 ? 1.0 : normalized < 3.5 ? 2.0 : normalized < 7.5 ? 5.0 : 10.0);
+	}
+
+	void write(const std::filesystem::path& path) const
+	{
+		double xMin = 0.0;
+		double xMax = 0.0;
+		double yMax = this->yMax;
+		for (auto& series : this->series) {
+			for (auto x : series.x) {
+				xMax = std::max(xMax, x);
+			}
+			if (this->yMax <= 0.0) {
+				for (auto y : series.y) {
+					yMax = std::max(yMax, y);
+				}
+			}
+		}
+		xMax = std::max(xMax, xMin + 1.0);
+		yMax = (yMax > 0.0) ? yMax : 1.0;
+
+		auto plotWidth = width - left - right;
+		auto plotHeight = height - top - bottom;
+		auto toX = [&](double x) { return left + (x - xMin) / (xMax - xMin) * plotWidth; };
+		auto toY = [&](double y) { return top + plotHeight - std::min(y, yMax) / yMax * plotHeight; };
+
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			throw std::runtime_error(std::format("could not open {} for writing", path.string()));
+		}
+		file << std::format(R"(<svg xmlns="http://www.w3.org/2000/svg" width="{}" height="{}" font-family="Arial, sans-serif" font-size="12">)", width, height) << "\n";
+		file << std::format(R"(<rect width="{}" height="{}" fill="white"/>)", width, height) << "\n";
+		file << std::format(R"(<text x="{}" y="30" font-size="16" font-weight="bold" text-anchor="middle">{}</text>)", width / 2, escape(this->title)) << "\n";
+
+		// grid and tick labels
+		auto xStep = getTickStep(xMax - xMin, 10);
+		for (auto x = xMin; x <= xMax + xStep * 1e-6; x += xStep) {
+			file << std::format(R"(<line x1="{0:.1f}" y1="{1}" x2="{0:.1f}" y2="{2}" stroke="#e0e0e0"/>)", toX(x), top, top + plotHeight) << "\n";
+			file << std::format(R"(<text x="{:.1f}" y="{}" text-anchor="middle">{:g}</text>)", toX(x), top + plotHeight + 18, x) << "\n";
+		}
+		auto yStep = getTickStep(yMax, 8);
+		for (auto y = 0.0; y <= yMax + yStep * 1e-6; y += yStep) {
+			file << std::format(R"(<line x1="{}" y1="{:.1f}" x2="{}" y2="{:.1f}" stroke="#e0e0e0"/>)", left, toY(y), left + plotWidth, toY(y)) << "\n";
+			file << std::format(R"(<text x="{}" y="{:.1f}" text-anchor="end">{:g}</text>)", left - 6, toY(y) + 4, y) << "\n";
+		}
+		file << std::format(R"(<rect x="{}" y="{}" width="{}" height="{}" fill="none" stroke="black"/>)", left, top, plotWidth, plotHeight) << "\n";
+		file << std::format(R"(<text x="{}" y="{}" text-anchor="middle">{}</text>)", left + plotWidth / 2, height - 15, escape(this->xLabel)) << "\n";
+		file << std::format(R"svg(<text x="20" y="{0}" text-anchor="middle" transform="rotate(-90 20 {0})">{1}</text>)svg", top + plotHeight / 2, escape(this->yLabel)) << "\n";
+
+		for (size_t s = 0; s < this->series.size(); s++) {
+			auto& series = this->series[s];
+			auto color = colors[s % colors.size()];
+			file << std::format(R"(<polyline fill="none" stroke="{}" stroke-width="1.5" points=")", color);
+			for (size_t i = 0; i < std::min(series.x.size(), series.y.size()); i++) {
+				file << std::format("{:.1f},{:.1f} ", toX(series.x[i]), toY(series.y[i]));
+			}
+			file << "\"/>\n";
+
+			// legend
+			if (this->series.size() > 1) {
+				auto y = top + 15 + 16 * s;
+				file << std::format(R"(<line x1="{}" y1="{}" x2="{}" y2="{}" stroke="{}" stroke-width="3"/>)", left + 10, y - 4, left + 30, y - 4, color) << "\n";
+				file << std::format(R"(<text x="{}" y="{}">{}</text>)", left + 36, y, escape(series.name)) << "\n";
+			}
+		}
+		file << "</svg>" << std::endl;
+	}
+
+	std::string title;
+	std::string xLabel;
+	std::string yLabel;
+	double yMax{ 0.0 };		// 0 for the largest value
+	std::vector<Series> series;
+};
@@ -0,0 +1,243 @@
+#include <Analysis/JsonReader.h>
+#include <Analysis/RunData.h>
+#include <Analysis/SvgPlot.h>
+#include <JsonWriter.h>
+#include <Statistics.h>
+
+#include <tuple>
+#include <vector>
+#include <format>
+#include <optional>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+
+static constexpr const char* usage =
+	"Usage: SparseAnalysis [options] FILE...\n"
+	"Reads SparseTexture result files (.txt, .json or .csv), prints per-run statistics\n"
+	"and the slope of completion time over coverage, and compares every run with the\n"
+	"first one, the baseline.\n"
+	"  --svg                 write a plot of completion time per batch next to every input file\n"
+	"  --compare FILE        write a plot of all runs over coverage to FILE (.svg)\n"
+	"  --diff FILE           write the comparison with the baseline to FILE (.json)\n"
+	"  --threshold PERCENT   exit with code 2 if the mean or p99 completion time of any run\n"
+	"                        is more than PERCENT above the baseline\n"
+	"  --y-max MS            clip plots at MS                   (default p99.9 of all runs)\n"
+	"  --legacy-batch N      tiles per batch in .txt files      (default 16)\n"
+	"  --help                print this message\n";
+
+
+struct AnalysisConfig {
+	std::vector<std::filesystem::path> files;
+	bool svg{ false };
+	std::filesystem::path compare;
+	std::filesystem::path diff;
+	double threshold{ -1.0 };
+	double yMax{ 0.0 };
+	uint32_t legacyBatchSize{ 16 };
+	bool help{ false };
+};
+
+static double parseDouble(std::string_view s)
+{
+	double value = 0.0;
+	if (!RunLoader::parseDouble(s, value)) {
+		throw std::runtime_error(std::format("expected a number, got: {}", s));
+	}
+	return value;
+}
+
+static AnalysisConfig parseArguments(int argc, const char* argv[])
+{
+	AnalysisConfig config;
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg(argv[i]);
+		auto value = [&]() {
+			if (i + 1 >= argc) {
+				throw std::runtime_error(std::format("missing value for option {}", arg));
+			}
+			return std::string_view(argv[++i]);
+		};
+		if (arg == "--help" || arg == "-h") {
+			config.help = true;
+		}
+		else if (arg == "--svg") {
+			config.svg = true;
+		}
+		else if (arg == "--compare") {
+			config.compare = value();
+		}
+		else if (arg == "--diff") {
+			config.diff = value();
+		}
+		else if (arg == "--threshold") {
+			config.threshold = parseDouble(value());
+		}
+		else if (arg == "--y-max") {
+			config.yMax = parseDouble(value());
+		}
+		else if (arg == "--legacy-batch") {
+			config.legacyBatchSize = static_cast<uint32_t>(parseDouble(value()));
+		}
+		else if (arg.starts_with("--")) {
+			throw std::runtime_error(std::format("unknown option: {}\n{}", arg, usage));
+		}
+		else {
+			config.files.emplace_back(arg);
+		}
+	}
+	return config;
+}
+
+// relative change in percent
+static double getChange(double value, double baseline)
+{
+	return baseline != 0.0 ? 100.0 * (value - baseline) / baseline : 0.0;
+}
+
+int main(int argc, const char* argv[])
+{
+	try {
+		auto config = parseArguments(argc, argv);
+		if (config.help || config.files.empty()) {
+			std::cout << usage;
+			return config.help ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		std::vector<RunData> runs;
+		for (auto& file : config.files) {
+			runs.push_back(RunLoader::load(file, config.legacyBatchSize));
+		}
+
+		std::cout << std::format("{:<48} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9} {:>11} {:>6}",
+			"run", "batches", "mean", "p50", "p90", "p99", "max", "ms/%cover", "r2") << std::endl;
+		for (auto& run : runs) {
+			Statistics statistics(run.completionTimes);
+			auto fit = getCoverageFit(run);
+			std::cout << std::format("{:<48} {:>7} {:>9.4f} {:>9.4f} {:>9.4f} {:>9.4f} {:>9.4f} {:>11.6f} {:>6.3f}",
+				run.name().substr(0, 48), statistics.count(), statistics.mean(), statistics.median(),
+				statistics.percentile(90.0), statistics.percentile(99.0), statistics.max(), fit.slope, fit.r2) << std::endl;
+		}
+
+		// a few outliers, e.g. the first bind, would otherwise flatten the plots
+		auto yMax = config.yMax;
+		if (yMax <= 0.0) {
+			for (auto& run : runs) {
+				yMax = std::max(yMax, Statistics(run.completionTimes).percentile(99.9));
+			}
+		}
+
+		if (config.svg) {
+			for (auto& run : runs) {
+				SvgPlot plot{
+					.title = run.title,
+					.xLabel = "Batch",
+					.yLabel = "Completion time (ms)",
+					.yMax = yMax,
+				};
+				std::vector<double> batches(run.completionTimes.size());
+				for (size_t i = 0; i < batches.size(); i++) {
+					batches[i] = double(i + 1);
+				}
+				plot.series.push_back({ .name = run.name(), .x = batches, .y = run.completionTimes });
+				auto path = run.path;
+				path.replace_extension(".svg");
+				plot.write(path);
+				std::cout << "Wrote plot to: " << path << std::endl;
+			}
+		}
+
+		if (!config.compare.empty()) {
+			SvgPlot plot{
+				.title = "Completion time over coverage",
+				.xLabel = "Coverage (%)",
+				.yLabel = "Completion time (ms)",
+				.yMax = yMax,
+			};
+			for (auto& run : runs) {
+				plot.series.push_back({ .name = run.name(), .x = run.coverage, .y = run.completionTimes });
+			}
+			plot.write(config.compare);
+			std::cout << "Wrote comparison plot to: " << config.compare << std::endl;
+		}
+
+		// every run against the first one
+		auto& baseline = runs.front();
+		Statistics baselineStatistics(baseline.completionTimes);
+		auto baselineFit = getCoverageFit(baseline);
+		bool regression = false;
+
+		std::ofstream diffFile;
+		std::optional<JsonWriter> json;
+		if (!config.diff.empty()) {
+			diffFile.open(config.diff);
+			if (!diffFile.is_open()) {
+				throw std::runtime_error(std::format("could not open {} for writing", config.diff.string()));
+			}
+			json.emplace(diffFile);
+			json->beginObject();
+			json->value("baseline", baseline.path.string());
+			json->value("threshold", config.threshold);
+			json->beginArray("runs");
+		}
+
+		if (runs.size() > 1) {
+			std::cout << std::endl << "Compared with " << baseline.name() << ":" << std::endl;
+		}
+		for (size_t r = 1; r < runs.size(); r++) {
+			auto& run = runs[r];
+			Statistics statistics(run.completionTimes);
+			auto fit = getCoverageFit(run);
+			auto meanChange = getChange(statistics.mean(), baselineStatistics.mean());
+			auto p99Change = getChange(statistics.percentile(99.0), baselineStatistics.percentile(99.0));
+			auto regressed = config.threshold >= 0.0 && (meanChange > config.threshold || p99Change > config.threshold);
+			regression |= regressed;
+
+			std::cout << std::format("  {}: mean {:+.1f}%, p50 {:+.1f}%, p99 {:+.1f}%, max {:+.1f}%, slope {:.6f} vs {:.6f} ms/%{}",
+				run.name(), meanChange,
+				getChange(statistics.median(), baselineStatistics.median()), p99Change,
+				getChange(statistics.max(), baselineStatistics.max()),
+				fit.slope, baselineFit.slope,
+				regressed ? "  REGRESSION" : "") << std::endl;
+
+			if (json) {
+				json->beginObject();
+				json->value("run", run.path.string());
+				json->value("title", run.title);
+				json->value("parameters", run.parameters);
+				for (auto [key, value, base] : {
+					std::tuple{ "mean", statistics.mean(), baselineStatistics.mean() },
+					std::tuple{ "p50", statistics.median(), baselineStatistics.median() },
+					std::tuple{ "p90", statistics.percentile(90.0), baselineStatistics.percentile(90.0) },
+					std::tuple{ "p99", statistics.percentile(99.0), baselineStatistics.percentile(99.0) },
+					std::tuple{ "max", statistics.max(), baselineStatistics.max() },
+					std::tuple{ "slope", fit.slope, baselineFit.slope } }) {
+					json->beginObject(key);
+					json->value("value", value);
+					json->value("baseline", base);
+					json->value("change", getChange(value, base));
+					json->endObject();
+				}
+				json->value("regression", regressed);
+				json->endObject();
+			}
+		}
+
+		if (json) {
+			json->endArray();
+			json->value("regression", regression);
+			json->endObject();
+			std::cout << "Wrote comparison to: " << config.diff << std::endl;
+		}
+		return regression ? 2 : EXIT_SUCCESS;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
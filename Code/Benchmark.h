@@ -0,0 +1,1158 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <TilePool.h>
+#include <ResidencyManager.h>
+#include <BindCoalescer.h>
+#include <BindSparseBatch.h>
+#include <BindScheduler.h>
+#include <OverlapWorkload.h>
+#include <TileUploader.h>
+#include <Workload.h>
+
+#include <cmath>
+#include <array>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <format>
+#include <optional>
+#include <iostream>
+#include <algorithm>
+
+
+// One vkQueueBindSparse, of bindInfos batches
+struct BatchTiming {
+	double submitTime{ 0.0 };		// ms spent in vkQueueBindSparse
+	double completionTime{ 0.0 };	// ms from submission until the fence was seen signaled
+	size_t tilesBound{ 0 };			// tiles bound including this batch
+	size_t tilesUnbound{ 0 };		// tiles evicted including this batch
+	size_t bindEntries{ 0 };		// bind entries in this batch, fewer than tiles when coalescing
+	double imageCoverage{ 0.0 };	// percentage of the tiles of the image bound last resident after the batch
+	bool afterWork{ false };		// submitted right after dummy work waiting for the previous batch
+	bool compaction{ false };		// rebinds of tiles moved to compact the pool
+};
+
+// One compaction of the tile pool
+struct CompactionTiming {
+	double time{ 0.0 };				// ms from the start of the moves until the emptied blocks were released
+	size_t tilesMoved{ 0 };
+	uint32_t blocksReleased{ 0 };	// emptied by the moves, or empty already
+	VkDeviceSize bytesReleased{ 0 };
+	double fragmentationBefore{ 0.0 };
+	double fragmentationAfter{ 0.0 };
+};
+
+struct BenchmarkResult {
+	std::vector<BatchTiming> batches;
+	std::vector<FrameTiming> frames;		// with a frame budget
+	double totalTime{ 0.0 };		// ms from the first submission until the last completion
+	double churnStartTime{ -1.0 };	// ms from the first submission until the first eviction, negative if nothing was evicted
+	size_t churnStartTiles{ 0 };	// tiles bound before the first eviction
+	size_t tileCount{ 0 };			// distinct tiles requested, of mip level 0 and, with the mip chain, coarser levels
+	double workTime{ 0.0 };			// mean ms of the dummy work alone, with overlapping work
+	std::vector<double> tileLatencies;	// ms from request until the upload completed of every bound tile, with uploads
+	VkDeviceSize uploadBytes{ 0 };	// with uploads
+	double readTime{ 0.0 };			// ms the binding thread spent reading tiles from the volume or waiting for reads
+	size_t nullTilesResident{ 0 };	// tiles bound to the null page at the end of the run, with null tiles
+	size_t promotions{ 0 };			// null tiles rebound to a private page when written
+	VkDeviceSize tileSize{ 0 };		// bytes of memory per tile
+	uint64_t tileTexels{ 0 };		// texels per tile
+	VkDeviceSize poolLimit{ 0 };	// bytes the pool may allocate, after the memory budget
+	VkDeviceSize peakPoolSize{ 0 };	// most bytes the pool held at once
+	uint32_t blocksAllocated{ 0 };	// pool blocks allocated during the run, none up front
+	uint32_t blocksReleased{ 0 };	// pool blocks released during the run, by compactions too
+	uint32_t allocationFailures{ 0 };	// pool blocks the device had no memory for
+	std::vector<CompactionTiming> compactions;
+
+	size_t tilesBound() const
+	{
+		return this->batches.empty() ? 0 : this->batches.back().tilesBound;
+	}
+
+	size_t tilesUnbound() const
+	{
+		return this->batches.empty() ? 0 : this->batches.back().tilesUnbound;
+	}
+
+	// fraction of frames that stayed within the frame budget
+	double budgetHitRate() const
+	{
+		auto hits = std::ranges::count_if(this->frames, [](auto& frame) { return frame.budgetHit; });
+		return this->frames.empty() ? 0.0 : double(hits) / this->frames.size();
+	}
+
+	double tilesPerFrame() const
+	{
+		size_t tiles = 0;
+		for (auto& frame : this->frames) {
+			tiles += frame.tilesBound;
+		}
+		return this->frames.empty() ? 0.0 : double(tiles) / this->frames.size();
+	}
+
+	// The extra completion time of batches submitted right after dummy work, over the
+	// time of the work alone: about 1 if the queue executes binds only after the work
+	// before them, about 0 if it executes them concurrently
+	double serialization() const
+	{
+		double afterWork = 0.0;
+		double alone = 0.0;
+		size_t afterWorkCount = 0;
+		for (auto& batch : this->batches) {
+			(batch.afterWork ? afterWork : alone) += batch.completionTime;
+			afterWorkCount += batch.afterWork ? 1 : 0;
+		}
+		auto aloneCount = this->batches.size() - afterWorkCount;
+		return (this->workTime > 0.0 && afterWorkCount > 0 && aloneCount > 0) ?
+			(afterWork / afterWorkCount - alone / aloneCount) / this->workTime : 0.0;
+	}
+
+	// upload throughput over the whole run, which includes waiting for binds
+	double uploadMegabytesPerSecond() const
+	{
+		return this->totalTime > 0.0 ? double(this->uploadBytes) / (1 << 20) / (this->totalTime / 1000.0) : 0.0;
+	}
+
+	double bindsPerSecond() const
+	{
+		return this->totalTime > 0.0 ? this->tilesBound() / (this->totalTime / 1000.0) : 0.0;
+	}
+
+	// bytes of memory bound per second, which compares formats with tiles of different sizes
+	double bytesPerSecond() const
+	{
+		return this->bindsPerSecond() * double(this->tileSize);
+	}
+
+	double texelsPerSecond() const
+	{
+		return this->bindsPerSecond() * double(this->tileTexels);
+	}
+
+	// memory the tiles bound to the null page would take with pages of their own, less the null page
+	VkDeviceSize nullMemorySaved() const
+	{
+		return this->nullTilesResident > 0 ? (this->nullTilesResident - 1) * this->tileSize : 0;
+	}
+
+	size_t tilesMoved() const
+	{
+		size_t tiles = 0;
+		for (auto& compaction : this->compactions) {
+			tiles += compaction.tilesMoved;
+		}
+		return tiles;
+	}
+
+	// ms spent compacting, waiting for the moves included
+	double compactionTime() const
+	{
+		double time = 0.0;
+		for (auto& compaction : this->compactions) {
+			time += compaction.time;
+		}
+		return time;
+	}
+
+	VkDeviceSize compactionBytesReleased() const
+	{
+		VkDeviceSize bytes = 0;
+		for (auto& compaction : this->compactions) {
+			bytes += compaction.bytesReleased;
+		}
+		return bytes;
+	}
+
+	// binds per second once the pool is full and every bind evicts another tile
+	double churnBindsPerSecond() const
+	{
+		auto churnTime = this->totalTime - this->churnStartTime;
+		return (this->churnStartTime >= 0.0 && churnTime > 0.0) ?
+			(this->tilesBound() - this->churnStartTiles) / (churnTime / 1000.0) : 0.0;
+	}
+};
+
+
+// Binds the tiles of mip level 0 of sparse 2D, 2D array or 3D images, or the tile sized
+// ranges of a sparse buffer, in the order of the configured access pattern, batchSize
+// tiles per vkQueueBindSparse, and times every batch from its submission to its
+// completion. Tiles are multiples of the sparse image granularity reported by the
+// driver, and their pages come from a TilePool. The BenchmarkParameters select how the
+// binds are submitted (synchronously, or in flight on fences or a timeline semaphore,
+// in one or more bind infos, coalesced or not), whether a ResidencyManager evicts tiles
+// once the pool is full, and what runs alongside the binds: a frame budget, dummy work,
+// uploads of the tile contents from a volume, and the maintenance of an elastic pool.
+class SparseBindBenchmark {
+public:
+	SparseBindBenchmark(
+		std::shared_ptr<VulkanDevice> device,
+		std::shared_ptr<VulkanQueue> queue,
+		const BenchmarkParameters& parameters,
+		std::shared_ptr<VulkanQueue> workQueue = nullptr,
+		std::shared_ptr<VulkanQueue> transferQueue = nullptr) :
+		device(std::move(device)),
+		queue(std::move(queue)),
+		parameters(parameters)
+	{
+		auto& physicalDevice = this->device->physicalDevice;
+
+		VulkanImage::Config imageConfig{
+			.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT,
+			.imageType = getVkImageType(this->parameters.imageType),
+			.format = this->parameters.format,
+			.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+		if (this->isAliased()) {
+			imageConfig.flags |= VK_IMAGE_CREATE_SPARSE_ALIASED_BIT;
+		}
+
+		this->imageFormatProperties = physicalDevice->getPhysicalDeviceImageFormatProperties(
+			imageConfig.format,
+			imageConfig.imageType,
+			imageConfig.tiling,
+			imageConfig.usage,
+			imageConfig.flags);
+
+		for (auto& properties : physicalDevice->getSparseImageFormatProperties(
+			imageConfig.format,
+			imageConfig.imageType,
+			VK_SAMPLE_COUNT_1_BIT,
+			imageConfig.usage,
+			imageConfig.tiling)) {
+			if (properties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) {
+				this->sparseImageFormatProperties = properties;
+			}
+		}
+		auto& granularity = this->sparseImageFormatProperties.imageGranularity;
+		if (granularity.width * granularity.height * granularity.depth == 0) {
+			throw Exception(std::format("{} does not support sparse residency for {} images.",
+				getFormatName(imageConfig.format), getImageTypeName(this->parameters.imageType)));
+		}
+
+		// the granularity differs between formats and image types, so the tile extent is
+		// rounded up to it, and a sweep over formats binds the smallest tiles that fit each
+		auto& tileExtent = this->parameters.tileExtent;
+		if (tileExtent.width == 0) {
+			tileExtent = granularity;
+		}
+		if (this->parameters.imageType != ImageType::Image3D) {
+			tileExtent.depth = 1;
+		}
+		tileExtent = VkExtent3D{
+			(tileExtent.width + granularity.width - 1) / granularity.width * granularity.width,
+			(tileExtent.height + granularity.height - 1) / granularity.height * granularity.height,
+			(tileExtent.depth + granularity.depth - 1) / granularity.depth * granularity.depth,
+		};
+
+		// the depth of a 2D array counts its layers
+		auto& imageFormatProperties = this->imageFormatProperties;
+		this->imageExtent = VkExtent3D{
+			std::min(imageFormatProperties.maxExtent.width, this->parameters.imageExtent.width),
+			std::min(imageFormatProperties.maxExtent.height, this->parameters.imageExtent.height),
+			std::min(this->isLayered() ? imageFormatProperties.maxArrayLayers : imageFormatProperties.maxExtent.depth,
+				this->parameters.imageExtent.depth),
+		};
+
+		if (this->isLayered() && this->parameters.mipChain) {
+			// every layer has a mip tail of its own, and the levels keep the layer count
+			throw Exception("the mip chain is not supported for 2D arrays.");
+		}
+
+		if (this->parameters.images > 1) {
+			// the residency manager, the mip tail and the uploader handle a single image
+			if (this->parameters.resource != ResourceType::Image || this->parameters.residencyMode != ResidencyMode::Fill ||
+				this->parameters.mipChain || this->parameters.upload) {
+				throw Exception("several images are only supported for image resources with fill residency, without the mip chain and uploads.");
+			}
+			this->splitExtent();
+		}
+
+		auto imageSize = static_cast<VkDeviceSize>(this->parameters.images) *
+			getFormatInfo(this->parameters.format).getSize(this->imageExtent);
+
+		if (imageSize > physicalDevice->getSparseAddressSpaceSize()) {
+			throw Exception("not enough sparse address space for image size.");
+		}
+
+		auto maxExtent = std::max(this->imageExtent.width, std::max(this->imageExtent.height, this->isLayered() ? 1u : this->imageExtent.depth));
+		auto numLevels = std::floor(std::log2(maxExtent)) + 1;
+		this->mipLevels = static_cast<uint32_t>(numLevels);
+		imageConfig.extent = this->imageExtent;
+		imageConfig.mipLevels = this->mipLevels;
+		if (this->isLayered()) {
+			imageConfig.extent.depth = 1;
+			imageConfig.arrayLayers = this->imageExtent.depth;
+		}
+
+		if (!transferQueue) {
+			transferQueue = this->queue;
+		}
+		if (this->parameters.upload && transferQueue->queueFamilyIndex != this->queue->queueFamilyIndex) {
+			// the image is written on the transfer queue, and would be sampled on another one
+			imageConfig.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			imageConfig.queueFamilyIndices = { this->queue->queueFamilyIndex, transferQueue->queueFamilyIndex };
+		}
+
+		if (this->parameters.resource == ResourceType::Image) {
+			this->createImage(imageConfig);
+		}
+		else {
+			if (!physicalDevice->physicalDeviceFeatures.sparseResidencyBuffer) {
+				throw Exception(std::format("{} does not support sparse residency for buffers.", physicalDevice->deviceName()));
+			}
+			this->createBuffer();
+		}
+
+		// with a memory budget, the pool is limited to a fraction of the memory that
+		// VK_EXT_memory_budget, or else the heap size, says is left on the heap
+		this->poolLimit = this->parameters.memoryPoolSize;
+		if (this->parameters.memoryBudget > 0.0) {
+			auto heapIndex = physicalDevice->getMemoryHeapIndex(this->memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			this->memoryBudget = physicalDevice->getMemoryBudget(heapIndex);
+			this->memoryAvailable = this->memoryBudget ? this->memoryBudget->available() : physicalDevice->getMemoryHeapSize(heapIndex);
+			this->poolLimit = std::min(this->poolLimit, static_cast<VkDeviceSize>(this->parameters.memoryBudget * this->memoryAvailable));
+			if (this->poolLimit < this->tileSize) {
+				throw Exception(std::format("the memory budget of {} bytes leaves no room for a tile.", this->poolLimit));
+			}
+		}
+
+		// all blocks are allocated up front, so that vkAllocateMemory is not part of the bind
+		// timings, except for the elastic pool, which is about the cost of allocating them
+		auto blockSize = this->parameters.memoryBlockSize ? this->parameters.memoryBlockSize : this->parameters.memoryPoolSize;
+		this->tilePool = std::make_shared<TilePool>(this->device, TilePool::Config{
+			.pageSize = this->tileSize,
+			.blockSize = std::min(blockSize, this->poolLimit),
+			.maxSize = this->poolLimit,
+			.memoryRequirements = this->memoryRequirements,
+		});
+		if (!this->parameters.elasticPool) {
+			this->tilePool->reserve(this->poolLimit);
+		}
+
+		if (this->parameters.residencyMode == ResidencyMode::Churn) {
+			this->residencyManager = std::make_unique<ResidencyManager>(
+				this->tilePool, this->imageExtent, tileExtent, static_cast<uint32_t>(this->layout->levels.size()),
+				this->parameters.batchSize, this->isLayered());
+		}
+
+		if ((this->parameters.elasticPool || this->parameters.compactThreshold > 0.0) && !this->residencyManager) {
+			throw Exception("the elastic pool and compaction need the residency manager, and churn residency.");
+		}
+
+		if (this->parameters.nullTiles > 0.0) {
+			if (!this->residencyManager) {
+				throw Exception("null tiles are tracked by the residency manager, and need churn residency.");
+			}
+			// uniform tiles are not read from anywhere, and a write would go to the shared page
+			if (this->parameters.upload) {
+				throw Exception("null tiles are not uploaded, and are not supported with uploads.");
+			}
+			this->residencyManager->nullPage = this->tilePool->allocate();
+			if (!this->residencyManager->nullPage) {
+				throw Exception("the memory pool has no page left for the null page.");
+			}
+		}
+
+		if (this->parameters.mipChain && this->image) {
+			this->createMipTailBinds();
+		}
+
+		// a churn batch holds binds and unbinds, the first one the mip tail too
+		this->bindBatch.reserve(this->parameters.bindInfos, this->images.size(),
+			this->parameters.bindInfos * (2 * size_t(this->parameters.batchSize)) + this->mipTailBinds.size());
+
+		if (this->parameters.timeline) {
+			if (!this->device->physicalDevice->timelineSemaphore) {
+				throw Exception(std::format("{} does not support timeline semaphores.", this->device->physicalDevice->deviceName()));
+			}
+			this->bindTimeline = std::make_shared<VulkanSemaphore>(this->device);
+		}
+		else {
+			for (uint32_t i = 0; i < this->getInFlight(); i++) {
+				this->fences.push_back(std::make_shared<VulkanFence>(this->device));
+			}
+		}
+
+		if (this->parameters.overlap != OverlapMode::None) {
+			if (this->parameters.overlap == OverlapMode::Same) {
+				workQueue = this->queue;
+			}
+			else if (!workQueue || workQueue == this->queue) {
+				throw Exception("overlap on another queue needs a second queue, and the device has none left.");
+			}
+			this->workload = std::make_shared<OverlapWorkload>(this->device, workQueue, this->parameters.overlapWorkSize);
+		}
+
+		if (this->parameters.upload) {
+			if (!this->image) {
+				throw Exception("uploads copy to the tiles of an image, and are not supported in buffer mode.");
+			}
+			// the tiles of a submission are copied together, so staging has to hold them all
+			auto tileBytes = getFormatInfo(this->parameters.format).getSize(tileExtent);
+			auto submissionBytes = tileBytes * this->parameters.batchSize * this->parameters.bindInfos;
+			if (this->parameters.stagingSize < submissionBytes) {
+				throw Exception(std::format("the staging ring of {} bytes is smaller than the {} bytes of tiles of a submission.",
+					this->parameters.stagingSize, submissionBytes));
+			}
+			std::shared_ptr<BrickedVolumeReader> reader;
+			if (!this->parameters.volume.empty()) {
+				reader = std::make_shared<BrickedVolumeReader>(this->parameters.volume, this->parameters.volumeReader, this->parameters.ioThreads);
+				this->checkVolume(reader->header);
+			}
+			this->uploader = std::make_shared<TileUploader>(this->device, transferQueue, this->image->image,
+				getFormatInfo(this->parameters.format), this->parameters.stagingSize, reader);
+		}
+	}
+
+	// Splits the extent along the axis with the most tiles into parameters.images images,
+	// which hold the tiles of the extent between them
+	void splitExtent()
+	{
+		auto& tileExtent = this->parameters.tileExtent;
+		std::array<uint32_t*, 3> extents{ &this->imageExtent.width, &this->imageExtent.height, &this->imageExtent.depth };
+		std::array<uint32_t, 3> tileExtents{ tileExtent.width, tileExtent.height, tileExtent.depth };
+		std::array<uint32_t, 3> tiles{};
+		for (size_t axis = 0; axis < 3; axis++) {
+			tiles[axis] = *extents[axis] / tileExtents[axis];
+		}
+		auto axis = static_cast<size_t>(std::ranges::max_element(tiles) - tiles.begin());
+		if (tiles[axis] < this->parameters.images || tiles[axis] % this->parameters.images != 0) {
+			throw Exception(std::format("the {} tiles along the longest axis do not split into {} images.",
+				tiles[axis], this->parameters.images));
+		}
+		*extents[axis] = tiles[axis] / this->parameters.images * tileExtents[axis];
+	}
+
+	// The volume has to hold every tile the run requests
+	void checkVolume(const BrickedVolumeHeader& header) const
+	{
+		auto& tileExtent = this->parameters.tileExtent;
+		auto mipLevels = this->parameters.mipChain ? static_cast<uint32_t>(this->layout->levels.size()) : 1;
+		if (header.extent.width != this->imageExtent.width || header.extent.height != this->imageExtent.height ||
+			header.extent.depth != this->imageExtent.depth ||
+			header.tileExtent.width != tileExtent.width || header.tileExtent.height != tileExtent.height ||
+			header.tileExtent.depth != tileExtent.depth ||
+			header.format != this->parameters.format || header.mipLevels < mipLevels) {
+			throw Exception(std::format("volume {} is {}x{}x{} in tiles of {}x{}x{} {} with {} mip levels, the image {}x{}x{} in tiles of {}x{}x{} {} with {}.",
+				this->parameters.volume.string(),
+				header.extent.width, header.extent.height, header.extent.depth,
+				header.tileExtent.width, header.tileExtent.height, header.tileExtent.depth,
+				getFormatName(header.format), header.mipLevels,
+				this->imageExtent.width, this->imageExtent.height, this->imageExtent.depth,
+				tileExtent.width, tileExtent.height, tileExtent.depth,
+				getFormatName(this->parameters.format), mipLevels));
+		}
+	}
+
+	// A 2D array, whose extent depth counts its layers, which tiles are one layer of
+	bool isLayered() const
+	{
+		return this->parameters.imageType == ImageType::Array2D;
+	}
+
+	// Tiles sharing the null page read the same memory consistently only from resources
+	// created with the aliased flag, which needs the sparseResidencyAliased feature
+	bool isAliased() const
+	{
+		return this->parameters.nullTiles > 0.0 && this->device->physicalDevice->physicalDeviceFeatures.sparseResidencyAliased;
+	}
+
+	// A number from 0 to 1 per tile and seed, so that every run picks the same tiles
+	static double hashTile(uint32_t tile, uint64_t seed)
+	{
+		// splitmix64
+		auto z = (uint64_t(tile) + seed) * 0x9e3779b97f4a7c15;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		z ^= z >> 31;
+		return double(z >> 11) * 0x1.0p-53;
+	}
+
+	// Whether the tile with the index of the page table is uniform, and bound to the null page
+	bool isNullTile(uint32_t tile) const
+	{
+		return hashTile(tile, 0) < this->parameters.nullTiles;
+	}
+
+	// Whether the null tile is written after its bind, and promoted to a private page
+	bool isWrittenTile(uint32_t tile) const
+	{
+		return hashTile(tile, 1) < this->parameters.nullWrites;
+	}
+
+	uint32_t getInFlight() const
+	{
+		return (this->parameters.bindMode == BindMode::Async) ? this->parameters.inFlight : 1;
+	}
+
+	void createImage(const VulkanImage::Config& imageConfig)
+	{
+		auto& granularity = this->sparseImageFormatProperties.imageGranularity;
+		auto& tileExtent = this->parameters.tileExtent;
+
+		this->image = std::make_shared<VulkanImage>(this->device, imageConfig);
+		this->images = { this->image };
+		for (uint32_t i = 1; i < this->parameters.images; i++) {
+			this->images.push_back(std::make_shared<VulkanImage>(this->device, imageConfig));
+		}
+
+		this->memoryRequirements = this->device->getMemoryRequirements(this->image->image);
+		for (auto& requirements : this->device->getSparseMemoryRequirements(this->image->image)) {
+			if (requirements.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) {
+				this->sparseMemoryRequirements = requirements;
+			}
+		}
+		if (this->sparseMemoryRequirements.imageMipTailFirstLod == 0) {
+			throw Exception("mip level 0 is in the mip tail, the image is smaller than the sparse image granularity.");
+		}
+		this->layout = std::make_unique<SparsePageTable>(this->imageExtent, tileExtent, this->sparseMemoryRequirements.imageMipTailFirstLod,
+			this->isLayered());
+
+		// one block of memoryRequirements.alignment bytes per granularity sized region
+		auto tileBlocks = VkDeviceSize(tileExtent.width / granularity.width) *
+			VkDeviceSize(tileExtent.height / granularity.height) * VkDeviceSize(tileExtent.depth / granularity.depth);
+		this->tileSize = tileBlocks * this->memoryRequirements.alignment;
+	}
+
+	// A buffer with one tile sized range per tile of the levels an image with the same
+	// granularity would not put in its mip tail, the levels at least one block in size.
+	void createBuffer()
+	{
+		auto& granularity = this->sparseImageFormatProperties.imageGranularity;
+		auto& tileExtent = this->parameters.tileExtent;
+
+		uint32_t levels = 0;
+		while (levels < this->mipLevels &&
+			(this->imageExtent.width >> levels) >= granularity.width &&
+			(this->imageExtent.height >> levels) >= granularity.height &&
+			(this->isLayered() || (this->imageExtent.depth >> levels) >= granularity.depth)) {
+			levels++;
+		}
+		if (levels == 0) {
+			throw Exception("the image is smaller than the sparse image granularity.");
+		}
+		this->layout = std::make_unique<SparsePageTable>(this->imageExtent, tileExtent, levels, this->isLayered());
+
+		this->tileSize = getFormatInfo(this->parameters.format).getSize(tileExtent);
+		this->buffer = std::make_shared<VulkanBuffer>(this->device, VulkanBuffer::Config{
+			.flags = VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT |
+				VkBufferCreateFlags(this->isAliased() ? VK_BUFFER_CREATE_SPARSE_ALIASED_BIT : 0),
+			.size = VkDeviceSize(this->layout->tileCount) * this->tileSize,
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		});
+
+		this->memoryRequirements = this->device->getMemoryRequirements(this->buffer->buffer);
+		if (this->tileSize % std::max<VkDeviceSize>(this->memoryRequirements.alignment, 1) != 0) {
+			throw Exception(std::format("tile size {} is not a multiple of the sparse buffer alignment {}.",
+				this->tileSize, this->memoryRequirements.alignment));
+		}
+	}
+
+	// The range of the buffer of a tile bind of the image
+	VkSparseMemoryBind getBufferBind(const VkSparseImageMemoryBind& bind) const
+	{
+		auto& tileExtent = this->parameters.tileExtent;
+		TileCoordinate tile{
+			.x = uint32_t(bind.offset.x) / tileExtent.width,
+			.y = uint32_t(bind.offset.y) / tileExtent.height,
+			.z = bind.subresource.arrayLayer + uint32_t(bind.offset.z) / tileExtent.depth,
+			.mipLevel = bind.subresource.mipLevel,
+		};
+		return VkSparseMemoryBind{
+			.resourceOffset = VkDeviceSize(this->layout->getTileIndex(tile)) * this->tileSize,
+			.size = this->tileSize,
+			.memory = bind.memory,
+			.memoryOffset = bind.memoryOffset,
+			.flags = 0,
+		};
+	}
+
+	// Opaque binds of the mip tail of the color aspect and, if the format has one, of the
+	// metadata aspect, to a dedicated allocation, since the tail is smaller than a tile.
+	// The mip chain is not bound in 2D arrays, so the image has a single layer, and a
+	// single mip tail per aspect.
+	void createMipTailBinds()
+	{
+		VkMemoryRequirements mipTailMemoryRequirements = this->memoryRequirements;
+		mipTailMemoryRequirements.size = 0;
+		for (auto& requirements : this->device->getSparseMemoryRequirements(this->image->image)) {
+			auto& aspectMask = requirements.formatProperties.aspectMask;
+			if (!(aspectMask & (VK_IMAGE_ASPECT_COLOR_BIT | VK_IMAGE_ASPECT_METADATA_BIT)) || requirements.imageMipTailSize == 0) {
+				continue;
+			}
+			this->mipTailBinds.push_back(VkSparseMemoryBind{
+				.resourceOffset = requirements.imageMipTailOffset,
+				.size = requirements.imageMipTailSize,
+				.memory = VK_NULL_HANDLE,
+				.memoryOffset = mipTailMemoryRequirements.size,
+				.flags = VkSparseMemoryBindFlags((aspectMask & VK_IMAGE_ASPECT_METADATA_BIT) ? VK_SPARSE_MEMORY_BIND_METADATA_BIT : 0),
+			});
+			auto alignment = std::max<VkDeviceSize>(this->memoryRequirements.alignment, 1);
+			mipTailMemoryRequirements.size += (requirements.imageMipTailSize + alignment - 1) / alignment * alignment;
+		}
+		if (this->mipTailBinds.empty()) {
+			return;
+		}
+		this->mipTailMemory = std::make_shared<VulkanMemory>(this->device, mipTailMemoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		for (auto& bind : this->mipTailBinds) {
+			bind.memory = this->mipTailMemory->memory;
+		}
+	}
+
+	// Binds and unbinds warmup batches of tiles of mip level 0 before the timed run, so
+	// that its first batches do not pay for cold driver paths and caches. Every batch is
+	// unbound right after it completed, and its pages are returned to the pool, so the
+	// run starts from the same state as without warm-up.
+	void warmUp()
+	{
+		if (this->parameters.warmup == 0) {
+			return;
+		}
+		TraceScope scope("warm-up");
+		auto& tileExtent = this->parameters.tileExtent;
+		auto& level = this->layout->levels.front();
+		auto levelTiles = level.tileGrid.width * level.tileGrid.height * level.tileGrid.depth;
+		VulkanFence fence(this->device);
+		std::vector<VkSparseImageMemoryBind> binds;
+		std::vector<VkSparseMemoryBind> bufferBinds;
+		std::vector<TilePage> pages;
+
+		auto submit = [&]() {
+			this->bindBatch.beginBindInfo();
+			if (this->buffer) {
+				bufferBinds.clear();
+				for (auto& bind : binds) {
+					bufferBinds.push_back(this->getBufferBind(bind));
+				}
+				this->bindBatch.addBufferBinds(this->buffer->buffer, bufferBinds);
+			}
+			else {
+				this->bindBatch.addImageBinds(this->image->image, binds);
+			}
+			this->bindBatch.submit(*this->queue, fence.fence);
+			this->bindBatch.clear();
+			fence.waitAndReset();
+		};
+
+		uint32_t tile = 0;
+		for (uint32_t batch = 0; batch < this->parameters.warmup; batch++) {
+			binds.clear();
+			pages.clear();
+			for (uint32_t i = 0; i < this->parameters.batchSize; i++) {
+				auto page = this->tilePool->allocate();
+				if (!page) {
+					break;
+				}
+				pages.push_back(*page);
+				binds.push_back(getTileBind(this->imageExtent, tileExtent,
+					this->layout->getTileCoordinate(tile++ % levelTiles), page->memory, page->offset, this->isLayered()));
+			}
+			submit();
+			for (auto& bind : binds) {
+				bind.memory = VK_NULL_HANDLE;
+				bind.memoryOffset = 0;
+			}
+			submit();
+			for (auto& page : pages) {
+				this->tilePool->free(page);
+			}
+		}
+	}
+
+	BenchmarkResult run(bool progress = true)
+	{
+		TraceScope scope("run");
+		auto& tileExtent = this->parameters.tileExtent;
+
+		VkExtent3D tileGrid{
+			this->imageExtent.width / tileExtent.width,
+			this->imageExtent.height / tileExtent.height,
+			this->imageExtent.depth / tileExtent.depth,
+		};
+		if (tileGrid.width * tileGrid.height * tileGrid.depth == 0) {
+			throw Exception("tile extent is larger than the image extent.");
+		}
+		auto requests = createWorkloadGenerator(this->parameters.pattern)->generate(tileGrid);
+
+		BenchmarkResult result;
+		result.tileCount = size_t(tileGrid.width) * tileGrid.height * tileGrid.depth;
+		if (this->parameters.mipChain) {
+			auto levelZeroRequests = std::ranges::count_if(requests, [](auto& request) { return !request.release; });
+			requests = addMipChain(requests, *this->layout);
+			result.tileCount += std::ranges::count_if(requests, [](auto& request) { return !request.release; }) - levelZeroRequests;
+		}
+		auto imageTileCount = result.tileCount;
+		if (this->parameters.images > 1) {
+			requests = spreadOverImages(requests, this->parameters.images, this->parameters.imageOrder);
+			result.tileCount *= this->parameters.images;
+		}
+		std::vector<VkSparseImageMemoryBind> sparseImageMemoryBinds;
+		sparseImageMemoryBinds.reserve(this->parameters.batchSize);
+		// with several images, the image of every bind, and the binds of one image of a batch
+		std::vector<uint32_t> bindImages;
+		bindImages.reserve(this->parameters.batchSize);
+		std::vector<VkSparseImageMemoryBind> imageBinds;
+		imageBinds.reserve(this->parameters.batchSize);
+		std::vector<size_t> imageTilesBound(this->parameters.images, 0);
+		uint32_t lastImage = 0;
+		// in churn mode a batch holds binds and unbinds
+		std::vector<VkSparseMemoryBind> bufferBinds;
+		bufferBinds.reserve(2 * size_t(this->parameters.batchSize));
+
+		// every batch and every forced flush of a release is at most one submission
+		auto releases = std::ranges::count_if(requests, [](auto& request) { return request.release; });
+		result.batches.reserve(requests.size() / this->parameters.batchSize + releases + 1);
+
+		if (this->workload) {
+			result.workTime = this->workload->measure();
+		}
+		this->warmUp();
+
+		// submissions go to a single queue and complete in order, so the fence of submission
+		// n is fences[n % inFlight], and it is free once submission n - inFlight completed.
+		// In timeline mode submission n is complete once the semaphore reaches timelineValues[n % inFlight].
+		const size_t inFlight = this->getInFlight();
+		std::vector<Timer> timers(inFlight);
+		std::vector<uint64_t> timelineValues(inFlight);
+		uint64_t timelineValue = 0;
+		size_t completed = 0;
+
+		// waits for or polls the completion of a submission
+		auto isComplete = [&](size_t batch, bool block) {
+			if (this->bindTimeline) {
+				auto value = timelineValues[batch % inFlight];
+				if (block) {
+					this->bindTimeline->wait(value);
+					return true;
+				}
+				return this->bindTimeline->getValue() >= value;
+			}
+			auto& fence = this->fences[batch % inFlight];
+			if (block) {
+				fence->wait();
+			}
+			else if (!fence->isSignaled()) {
+				return false;
+			}
+			fence->reset();
+			return true;
+		};
+
+		auto complete = [&](bool block) {
+			while (completed < result.batches.size() && isComplete(completed, block)) {
+				result.batches[completed].completionTime = timers[completed % inFlight].getElapsedTimeMilliseconds();
+				completed++;
+				block = false;
+			}
+		};
+
+		Timer totalTimer;
+		size_t tilesBound = 0;
+		size_t tilesUnbound = 0;
+		bool mipTailBound = false;
+
+		BindCoalescer coalescer(tileExtent, this->tileSize);
+
+		// with uploads, the time every tile whose bind is queued was requested, until it is uploaded
+		std::deque<TileUploader::Clock::time_point> requestTimes;
+
+		// set while the binds of a compaction are submitted
+		bool compacting = false;
+		auto blockAllocations = this->tilePool->blockAllocations;
+		auto blockReleases = this->tilePool->blockReleases;
+
+		// submits the collected bind infos with a single vkQueueBindSparse
+		auto submitBindInfos = [&]() {
+			if (this->bindBatch.empty()) {
+				return;
+			}
+			if (result.batches.size() - completed == inFlight) {
+				complete(true);
+			}
+			auto batch = result.batches.size();
+			auto& timer = timers[batch % inFlight];
+			auto bindEntries = this->bindBatch.bindCount();
+
+			// traced around the timed call, so that tracing does not add to the submit time
+			double submitTime = 0.0;
+			{
+				TraceScope scope("vkQueueBindSparse", bindEntries);
+				timer = Timer();
+				this->bindBatch.submit(*this->queue, this->bindTimeline ? VK_NULL_HANDLE : this->fences[batch % inFlight]->fence);
+				submitTime = timer.getElapsedTimeMilliseconds();
+			}
+			result.batches.push_back({
+				.submitTime = submitTime,
+				.tilesBound = tilesBound,
+				.tilesUnbound = tilesUnbound,
+				.bindEntries = bindEntries,
+				.imageCoverage = (this->parameters.images > 1) ?
+					100.0 * imageTilesBound[lastImage] / imageTileCount :
+					100.0 * (double(tilesBound) - double(tilesUnbound)) / imageTileCount,
+				.afterWork = this->workload && batch % 2 == 1,
+				.compaction = compacting,
+			});
+			this->bindBatch.clear();
+			timelineValues[batch % inFlight] = timelineValue;
+
+			if (this->workload && batch % 2 == 0) {
+				this->workload->submit(this->bindTimeline->semaphore, timelineValue);
+			}
+			if (this->uploader) {
+				this->uploader->submit(this->bindTimeline->semaphore, timelineValue);
+			}
+
+			// sync mode waits for every bind, async mode only collects binds that already completed
+			complete(this->parameters.bindMode == BindMode::Sync);
+		};
+
+		// Adds a bind info with binds, which holds bound tiles and unbound tiles, and
+		// submits once there are bindInfos of them
+		auto submit = [&](std::vector<VkSparseImageMemoryBind>& binds, size_t bound, size_t unbound) {
+			if (unbound > 0 && result.churnStartTime < 0.0) {
+				result.churnStartTime = totalTimer.getElapsedTimeMilliseconds();
+				result.churnStartTiles = tilesBound;
+			}
+			tilesBound += bound;
+			tilesUnbound += unbound;
+
+			// requested tiles get their contents, in the order of their requests. Promoted and
+			// moved tiles would keep theirs, and without residency all binds are requests.
+			if (this->uploader) {
+				auto stage = [&](const VkSparseImageMemoryBind& bind) {
+					this->uploader->addTile(bind, requestTimes.front());
+					requestTimes.pop_front();
+				};
+				if (this->residencyManager) {
+					for (auto index : this->residencyManager->requestBinds) {
+						stage(binds[index]);
+					}
+				}
+				else {
+					for (auto& bind : binds) {
+						stage(bind);
+					}
+				}
+			}
+
+			this->bindBatch.beginBindInfo();
+			if (this->bindTimeline) {
+				if (timelineValue > 0) {
+					this->bindBatch.addWait(this->bindTimeline->semaphore, timelineValue);
+				}
+				this->bindBatch.addSignal(this->bindTimeline->semaphore, ++timelineValue);
+			}
+			// a copy into a page that is unbound or rebound, that is promoted or moved, must complete first
+			if (this->uploader && this->uploader->value > 0 && binds.size() > bound) {
+				this->bindBatch.addWait(this->uploader->semaphore->semaphore, this->uploader->value);
+			}
+			// buffer binds are translated from the image binds of the same tiles
+			if (this->buffer) {
+				bufferBinds.clear();
+				for (auto& bind : binds) {
+					bufferBinds.push_back(this->getBufferBind(bind));
+				}
+				if (this->parameters.coalesce) {
+					coalescer.coalesce(bufferBinds);
+				}
+				this->bindBatch.addBufferBinds(this->buffer->buffer, bufferBinds);
+			}
+			else if (this->images.size() > 1) {
+				for (uint32_t image = 0; image < this->images.size(); image++) {
+					imageBinds.clear();
+					for (size_t i = 0; i < binds.size(); i++) {
+						if (bindImages[i] == image) {
+							imageBinds.push_back(binds[i]);
+						}
+					}
+					if (imageBinds.empty()) {
+						continue;
+					}
+					if (this->parameters.coalesce) {
+						coalescer.coalesce(imageBinds, true);
+					}
+					this->bindBatch.addImageBinds(this->images[image]->image, imageBinds);
+				}
+			}
+			else {
+				// evicted tiles hand their own page to other tiles, so with residency only unbinds are merged
+				if (this->parameters.coalesce) {
+					coalescer.coalesce(binds, !this->residencyManager);
+				}
+				this->bindBatch.addImageBinds(this->image->image, binds);
+			}
+			// the mip tail is bound once, with the first batch
+			if (!mipTailBound) {
+				if (this->image) {
+					this->bindBatch.addImageOpaqueBinds(this->image->image, this->mipTailBinds);
+				}
+				mipTailBound = true;
+			}
+
+			if (this->bindBatch.bindInfoCount() == this->parameters.bindInfos) {
+				submitBindInfos();
+			}
+		};
+
+		// once the pool is full, pages are aliased like in the original benchmark, so
+		// coverage can exceed the pool size
+		auto allocatePage = [&](size_t bind) {
+			auto page = this->tilePool->allocate();
+			return page ? *page : this->tilePool->getPage(static_cast<uint32_t>(bind % this->tilePool->pageCount()));
+		};
+
+		auto flushResidency = [&]() {
+			auto& residency = *this->residencyManager;
+			// promoted and moved tiles were already resident
+			submit(residency.binds, residency.bindCount - residency.promoteCount - residency.moveCount, residency.unbindCount);
+			residency.flush();
+		};
+
+		// null tiles written since their bind was queued, promoted to a private page once it was submitted
+		std::vector<uint32_t> written;
+		auto promoteWritten = [&]() {
+			if (written.empty()) {
+				return;
+			}
+			auto& residency = *this->residencyManager;
+			submitBindInfos();
+			for (auto tile : written) {
+				residency.promote(tile);
+				if (residency.bindCount == this->parameters.batchSize) {
+					flushResidency();
+				}
+			}
+			written.clear();
+		};
+
+		// submits everything queued
+		auto flush = [&]() {
+			if (!sparseImageMemoryBinds.empty()) {
+				submit(sparseImageMemoryBinds, sparseImageMemoryBinds.size(), 0);
+				sparseImageMemoryBinds.clear();
+				bindImages.clear();
+			}
+			if (this->residencyManager && !this->residencyManager->binds.empty()) {
+				flushResidency();
+			}
+			promoteWritten();
+			if (this->residencyManager && !this->residencyManager->binds.empty()) {
+				flushResidency();
+			}
+			submitBindInfos();
+		};
+
+		// waits until everything queued so far completed, so that no tile is moved before
+		// its bind completed, and no block is released while a page of it is still bound
+		// or still written by an upload
+		auto drain = [&]() {
+			flush();
+			while (completed < result.batches.size()) {
+				complete(true);
+			}
+			if (this->uploader) {
+				this->uploader->wait();
+			}
+		};
+
+		// Moves the tiles of the sparsest blocks to the others once the fraction of free pages
+		// in the partially used blocks exceeds the threshold, and releases the emptied blocks
+		// and the empty ones. Only the rebinds are timed, the contents of the moved tiles are
+		// not copied. The spare block of the elastic pool alone does not start a compaction.
+		const uint32_t spareBlocks = this->parameters.elasticPool ? 1 : 0;
+		auto compact = [&]() {
+			auto& pool = *this->tilePool;
+			auto& residency = *this->residencyManager;
+			auto fragmentation = pool.getStatistics().fragmentation(pool.pagesPerBlock);
+			if (fragmentation <= this->parameters.compactThreshold) {
+				return;
+			}
+			// retiring only stops allocation from the blocks, nothing is waited for unless there is something to release
+			auto retired = pool.retireSparseBlocks(residency.getNullPageBlock());
+			if (retired.empty() && pool.getEmptyBlockCount() <= spareBlocks) {
+				return;
+			}
+			TraceScope scope("compact");
+			drain();
+			Timer timer;
+			// empty blocks would take the moved tiles instead of the fuller ones
+			CompactionTiming compaction{ .blocksReleased = pool.trim(0), .fragmentationBefore = fragmentation };
+			compacting = true;
+			for (auto tile : residency.getRetiredTiles()) {
+				compaction.tilesMoved += residency.move(tile) ? 1 : 0;
+				if (residency.bindCount == this->parameters.batchSize) {
+					flushResidency();
+				}
+			}
+			drain();
+			compacting = false;
+			compaction.blocksReleased += pool.trim(0);
+			compaction.bytesReleased = compaction.blocksReleased * pool.blockSize;
+			compaction.time = timer.getElapsedTimeMilliseconds();
+			compaction.fragmentationAfter = pool.getStatistics().fragmentation(pool.pagesPerBlock);
+			result.compactions.push_back(compaction);
+		};
+
+		// Compacts the pool, and lets the elastic pool, which allocates its blocks as it runs
+		// out of pages, give the blocks that became empty back, all but one spare. Both wait
+		// for every submission to complete first, since released memory must not be bound
+		// anymore.
+		auto maintainPool = [&]() {
+			if (this->parameters.compactThreshold > 0.0) {
+				compact();
+			}
+			if (this->parameters.elasticPool && this->tilePool->getEmptyBlockCount() > spareBlocks) {
+				drain();
+				this->tilePool->trim(spareBlocks);
+			}
+		};
+
+		// requests or releases a tile, and returns whether a bind was queued
+		size_t bind = 0;
+		auto process = [&](const TileRequest& request) {
+			if (this->residencyManager) {
+				auto& residency = *this->residencyManager;
+				auto tile = residency.pageTable.getTileIndex(request.tile);
+				if (request.release) {
+					// a bind and an unbind of the same tile must not be in the same submission
+					if (residency.isPending(tile)) {
+						flushResidency();
+						submitBindInfos();
+					}
+					residency.release(tile);
+					return false;
+				}
+				// nor an unbind and a bind of it, when it comes back right after its release or eviction
+				if (residency.isReleasePending(tile)) {
+					flushResidency();
+					submitBindInfos();
+				}
+				auto nullTile = this->parameters.nullTiles > 0.0 && this->isNullTile(tile);
+				auto bound = residency.request(tile, nullTile);
+				if (bound && this->uploader) {
+					requestTimes.push_back(TileUploader::Clock::now());
+				}
+				if (bound && nullTile && this->isWrittenTile(tile)) {
+					written.push_back(tile);
+				}
+				if (residency.bindCount == this->parameters.batchSize) {
+					flushResidency();
+					promoteWritten();
+					maintainPool();
+				}
+				return bound;
+			}
+
+			// without residency tracking tiles stay bound until their page is aliased
+			if (request.release) {
+				return false;
+			}
+			if (this->uploader) {
+				requestTimes.push_back(TileUploader::Clock::now());
+			}
+			auto page = allocatePage(bind++);
+			sparseImageMemoryBinds.push_back(getTileBind(this->imageExtent, tileExtent, request.tile, page.memory, page.offset, this->isLayered()));
+			bindImages.push_back(request.image);
+			imageTilesBound[request.image]++;
+			lastImage = request.image;
+
+			if (sparseImageMemoryBinds.size() == this->parameters.batchSize) {
+				submit(sparseImageMemoryBinds, sparseImageMemoryBinds.size(), 0);
+				sparseImageMemoryBinds.clear();
+				bindImages.clear();
+			}
+			return true;
+		};
+
+		if (progress) {
+			std::cout << "Timing binds";
+		}
+		if (this->parameters.frameBudget > 0.0) {
+			// coarser levels first, since nothing can be sampled before they are resident
+			BindScheduler scheduler(this->parameters.frameBudget, this->parameters.batchSize);
+			for (auto& request : requests) {
+				scheduler.push(request, request.tile.mipLevel);
+			}
+			result.frames.reserve(requests.size());
+			while (!scheduler.empty()) {
+				if (progress && result.frames.size() % 100 == 0) {
+					std::cout << ".";
+				}
+				result.frames.push_back(scheduler.runFrame(process, [&]() {
+					flush();
+					while (completed < result.batches.size()) {
+						complete(true);
+					}
+				}));
+			}
+		}
+		else {
+			for (size_t r = 0; r < requests.size(); r++) {
+				if (progress && r % std::max<size_t>(requests.size() / 10, 1) == 0) {
+					std::cout << ".";
+				}
+				process(requests[r]);
+			}
+		}
+
+		flush();
+		// the tiles released last can leave the pool fragmented
+		if (this->residencyManager) {
+			maintainPool();
+		}
+		while (completed < result.batches.size()) {
+			complete(true);
+		}
+		if (this->workload) {
+			this->workload->wait();
+		}
+		if (this->uploader) {
+			result.tileLatencies = this->uploader->getLatencies();
+			result.uploadBytes = this->uploader->bytes;
+			result.readTime = this->uploader->readTime;
+		}
+		result.totalTime = totalTimer.getElapsedTimeMilliseconds();
+		result.tileSize = this->tileSize;
+		result.tileTexels = uint64_t(tileExtent.width) * tileExtent.height * tileExtent.depth;
+		if (this->residencyManager) {
+			result.nullTilesResident = this->residencyManager->sharedCount;
+			result.promotions = this->residencyManager->promotionCount;
+		}
+		result.poolLimit = this->poolLimit;
+		result.peakPoolSize = this->tilePool->peakBlocks * this->tilePool->blockSize;
+		result.blocksAllocated = this->tilePool->blockAllocations - blockAllocations;
+		result.blocksReleased = this->tilePool->blockReleases - blockReleases;
+		result.allocationFailures = this->tilePool->allocationFailures;
+		return result;
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	std::shared_ptr<VulkanQueue> queue{ nullptr };
+	std::shared_ptr<VulkanImage> image{ nullptr };		// in image mode
+	std::vector<std::shared_ptr<VulkanImage>> images;	// in image mode, image first
+	std::shared_ptr<VulkanBuffer> buffer{ nullptr };	// in buffer mode
+	std::unique_ptr<SparsePageTable> layout{ nullptr };	// numbering of the tiles of all levels, the buffer layout in buffer mode
+	std::shared_ptr<TilePool> tilePool{ nullptr };
+	std::unique_ptr<ResidencyManager> residencyManager{ nullptr };
+	std::shared_ptr<VulkanMemory> mipTailMemory{ nullptr };
+	std::vector<VkSparseMemoryBind> mipTailBinds;
+	BindSparseBatch bindBatch;
+	std::vector<std::shared_ptr<VulkanFence>> fences;		// without timeline
+	std::shared_ptr<VulkanSemaphore> bindTimeline{ nullptr };	// in timeline mode
+	std::shared_ptr<OverlapWorkload> workload{ nullptr };		// with overlap
+	std::shared_ptr<TileUploader> uploader{ nullptr };			// with uploads
+	BenchmarkParameters parameters;
+	VkImageFormatProperties imageFormatProperties{};
+	VkSparseImageFormatProperties sparseImageFormatProperties{};
+	VkMemoryRequirements memoryRequirements{};
+	VkSparseImageMemoryRequirements sparseMemoryRequirements{};
+	VkExtent3D imageExtent{ 0, 0, 0 };
+	uint32_t mipLevels{ 0 };
+	VkDeviceSize tileSize{ 0 };
+	VkDeviceSize poolLimit{ 0 };				// bytes the pool may allocate
+	std::optional<VulkanPhysicalDevice::MemoryBudget> memoryBudget;	// of the heap of the pool, with a memory budget and VK_EXT_memory_budget
+	VkDeviceSize memoryAvailable{ 0 };			// bytes left on the heap of the pool, with a memory budget
+};
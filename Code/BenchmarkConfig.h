@@ -0,0 +1,1148 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <DeviceSelection.h>
+
+#include <array>
+#include <vector>
+#include <format>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+
+
+struct FormatInfo {
+	const char* name;
+	VkFormat format;
+	uint32_t texelSize;			// bytes per texel, or per block of texels of block-compressed formats
+	uint32_t blockWidth{ 1 };	// texels per block of block-compressed formats
+	uint32_t blockHeight{ 1 };
+
+	bool isCompressed() const
+	{
+		return this->blockWidth > 1 || this->blockHeight > 1;
+	}
+
+	// bytes of the texels of an extent, with partial blocks at its edges
+	VkDeviceSize getSize(VkExtent3D extent) const
+	{
+		return VkDeviceSize(this->texelSize) *
+			VkDeviceSize((extent.width + this->blockWidth - 1) / this->blockWidth) *
+			VkDeviceSize((extent.height + this->blockHeight - 1) / this->blockHeight) * extent.depth;
+	}
+};
+
+inline constexpr std::array formatInfos{
+	FormatInfo{ "R8_UNORM", VK_FORMAT_R8_UNORM, 1 },
+	FormatInfo{ "R8_SNORM", VK_FORMAT_R8_SNORM, 1 },
+	FormatInfo{ "R8_UINT", VK_FORMAT_R8_UINT, 1 },
+	FormatInfo{ "R8G8_UNORM", VK_FORMAT_R8G8_UNORM, 2 },
+	FormatInfo{ "R16_UNORM", VK_FORMAT_R16_UNORM, 2 },
+	FormatInfo{ "R16_SNORM", VK_FORMAT_R16_SNORM, 2 },
+	FormatInfo{ "R16_UINT", VK_FORMAT_R16_UINT, 2 },
+	FormatInfo{ "R16_SFLOAT", VK_FORMAT_R16_SFLOAT, 2 },
+	FormatInfo{ "R8G8B8A8_UNORM", VK_FORMAT_R8G8B8A8_UNORM, 4 },
+	FormatInfo{ "R8G8B8A8_SRGB", VK_FORMAT_R8G8B8A8_SRGB, 4 },
+	FormatInfo{ "R32_UINT", VK_FORMAT_R32_UINT, 4 },
+	FormatInfo{ "R32_SFLOAT", VK_FORMAT_R32_SFLOAT, 4 },
+	FormatInfo{ "R16G16B16A16_SFLOAT", VK_FORMAT_R16G16B16A16_SFLOAT, 8 },
+	FormatInfo{ "R32G32B32A32_SFLOAT", VK_FORMAT_R32G32B32A32_SFLOAT, 16 },
+	FormatInfo{ "BC1_RGB_UNORM_BLOCK", VK_FORMAT_BC1_RGB_UNORM_BLOCK, 8, 4, 4 },
+	FormatInfo{ "BC1_RGBA_UNORM_BLOCK", VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 4 },
+	FormatInfo{ "BC3_UNORM_BLOCK", VK_FORMAT_BC3_UNORM_BLOCK, 16, 4, 4 },
+	FormatInfo{ "BC4_UNORM_BLOCK", VK_FORMAT_BC4_UNORM_BLOCK, 8, 4, 4 },
+	FormatInfo{ "BC5_UNORM_BLOCK", VK_FORMAT_BC5_UNORM_BLOCK, 16, 4, 4 },
+	FormatInfo{ "BC6H_UFLOAT_BLOCK", VK_FORMAT_BC6H_UFLOAT_BLOCK, 16, 4, 4 },
+	FormatInfo{ "BC7_UNORM_BLOCK", VK_FORMAT_BC7_UNORM_BLOCK, 16, 4, 4 },
+	FormatInfo{ "BC7_SRGB_BLOCK", VK_FORMAT_BC7_SRGB_BLOCK, 16, 4, 4 },
+};
+
+inline const FormatInfo& getFormatInfo(VkFormat format)
+{
+	for (auto& formatInfo : formatInfos) {
+		if (formatInfo.format == format) {
+			return formatInfo;
+		}
+	}
+	throw Exception(std::format("unsupported format: {}", string_VkFormat(format)));
+}
+
+inline std::string getFormatName(VkFormat format)
+{
+	return getFormatInfo(format).name;
+}
+
+inline VkFormat parseFormat(std::string_view name)
+{
+	if (name.starts_with("VK_FORMAT_")) {
+		name.remove_prefix(std::string_view("VK_FORMAT_").size());
+	}
+	for (auto& formatInfo : formatInfos) {
+		// the _BLOCK suffix of block-compressed formats is optional, e.g. BC7_UNORM
+		std::string_view formatName(formatInfo.name);
+		if (name == formatName || (formatName.ends_with("_BLOCK") && name == formatName.substr(0, formatName.size() - 6))) {
+			return formatInfo.format;
+		}
+	}
+	throw Exception(std::format("unknown format: {}", name));
+}
+
+
+enum class BindMode {
+	Sync,		// wait for the fence after every bind
+	Async,		// keep up to inFlight binds in flight
+};
+
+inline std::string getBindModeName(BindMode mode)
+{
+	switch (mode) {
+	case BindMode::Sync: return "sync";
+	case BindMode::Async: return "async";
+	}
+	return "unknown";
+}
+
+inline BindMode parseBindMode(std::string_view name)
+{
+	if (name == "sync") {
+		return BindMode::Sync;
+	}
+	if (name == "async") {
+		return BindMode::Async;
+	}
+	throw Exception(std::format("unknown mode: {}", name));
+}
+
+
+enum class ResidencyMode {
+	Fill,		// bind every tile once, aliasing pages once the pool is full
+	Churn,		// evict the least recently used tiles once the pool is full
+};
+
+inline std::string getResidencyModeName(ResidencyMode mode)
+{
+	switch (mode) {
+	case ResidencyMode::Fill: return "fill";
+	case ResidencyMode::Churn: return "churn";
+	}
+	return "unknown";
+}
+
+inline ResidencyMode parseResidencyMode(std::string_view name)
+{
+	if (name == "fill") {
+		return ResidencyMode::Fill;
+	}
+	if (name == "churn") {
+		return ResidencyMode::Churn;
+	}
+	throw Exception(std::format("unknown residency mode: {}", name));
+}
+
+
+enum class ResourceType {
+	Image,		// sparse image, bound with VkSparseImageMemoryBind
+	Buffer,		// sparse buffer of the same size, bound with VkSparseMemoryBind
+};
+
+inline std::string getResourceTypeName(ResourceType type)
+{
+	switch (type) {
+	case ResourceType::Image: return "image";
+	case ResourceType::Buffer: return "buffer";
+	}
+	return "unknown";
+}
+
+inline ResourceType parseResourceType(std::string_view name)
+{
+	if (name == "image") {
+		return ResourceType::Image;
+	}
+	if (name == "buffer") {
+		return ResourceType::Buffer;
+	}
+	throw Exception(std::format("unknown resource type: {}", name));
+}
+
+
+enum class ImageType {
+	Image2D,	// the width and height of the extent
+	Array2D,	// a 2D array with a layer per depth slice of the extent, tiles one layer deep
+	Image3D,
+};
+
+inline constexpr std::array imageTypeNames{ "2d", "2d-array", "3d" };
+
+inline std::string getImageTypeName(ImageType type)
+{
+	return imageTypeNames[static_cast<size_t>(type)];
+}
+
+inline ImageType parseImageType(std::string_view name)
+{
+	for (size_t i = 0; i < imageTypeNames.size(); i++) {
+		if (name == imageTypeNames[i]) {
+			return static_cast<ImageType>(i);
+		}
+	}
+	throw Exception(std::format("unknown image type: {}", name));
+}
+
+inline VkImageType getVkImageType(ImageType type)
+{
+	return (type == ImageType::Image3D) ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+}
+
+
+enum class OverlapMode {
+	None,		// binds only
+	Same,		// dummy work on the sparse binding queue after every other bind
+	Other,		// dummy work on another queue after every other bind
+};
+
+inline constexpr std::array overlapModeNames{ "none", "same", "other" };
+
+inline std::string getOverlapModeName(OverlapMode mode)
+{
+	return overlapModeNames[static_cast<size_t>(mode)];
+}
+
+inline OverlapMode parseOverlapMode(std::string_view name)
+{
+	for (size_t i = 0; i < overlapModeNames.size(); i++) {
+		if (name == overlapModeNames[i]) {
+			return static_cast<OverlapMode>(i);
+		}
+	}
+	throw Exception(std::format("unknown overlap mode: {}", name));
+}
+
+
+enum class VolumeReaderMode {
+	Mmap,		// copy tiles from the mapped file on the binding thread
+	Threads,	// read tiles on a pool of threads
+};
+
+inline constexpr std::array volumeReaderModeNames{ "mmap", "threads" };
+
+inline std::string getVolumeReaderModeName(VolumeReaderMode mode)
+{
+	return volumeReaderModeNames[static_cast<size_t>(mode)];
+}
+
+inline VolumeReaderMode parseVolumeReaderMode(std::string_view name)
+{
+	for (size_t i = 0; i < volumeReaderModeNames.size(); i++) {
+		if (name == volumeReaderModeNames[i]) {
+			return static_cast<VolumeReaderMode>(i);
+		}
+	}
+	throw Exception(std::format("unknown volume reader: {}", name));
+}
+
+
+enum class ImageOrder {
+	RoundRobin,		// one request of every image in turn
+	Sequential,		// all requests of an image before the next image
+};
+
+inline constexpr std::array imageOrderNames{ "round-robin", "sequential" };
+
+inline std::string getImageOrderName(ImageOrder order)
+{
+	return imageOrderNames[static_cast<size_t>(order)];
+}
+
+inline ImageOrder parseImageOrder(std::string_view name)
+{
+	for (size_t i = 0; i < imageOrderNames.size(); i++) {
+		if (name == imageOrderNames[i]) {
+			return static_cast<ImageOrder>(i);
+		}
+	}
+	throw Exception(std::format("unknown image order: {}", name));
+}
+
+
+enum class AccessPattern {
+	Linear,		// x outermost, z innermost
+	Morton,		// Z-order curve
+	Random,		// uniformly random order
+	Slab,		// z slice by z slice
+	Camera,		// tiles in the view of a camera flying through the volume
+};
+
+inline constexpr std::array accessPatternNames{ "linear", "morton", "random", "slab", "camera" };
+
+inline std::string getAccessPatternName(AccessPattern pattern)
+{
+	return accessPatternNames[static_cast<size_t>(pattern)];
+}
+
+inline AccessPattern parseAccessPattern(std::string_view name)
+{
+	for (size_t i = 0; i < accessPatternNames.size(); i++) {
+		if (name == accessPatternNames[i]) {
+			return static_cast<AccessPattern>(i);
+		}
+	}
+	throw Exception(std::format("unknown access pattern: {}", name));
+}
+
+
+enum class OutputFormat {
+	Text,		// header line and one completion time per line
+	Json,
+	Csv,
+};
+
+inline OutputFormat parseOutputFormat(std::string_view name)
+{
+	if (name == "txt" || name == "text") {
+		return OutputFormat::Text;
+	}
+	if (name == "json") {
+		return OutputFormat::Json;
+	}
+	if (name == "csv") {
+		return OutputFormat::Csv;
+	}
+	throw Exception(std::format("unknown output format: {}", name));
+}
+
+
+enum class LatencyModel {
+	Constant,		// every vkQueueBindSparse costs the same
+	Linear,			// the cost grows with the number of resident sparse blocks on the device
+	GlobalLock,		// binds and submits of all threads and devices serialize on one driver lock
+};
+
+inline constexpr std::array latencyModelNames{ "constant", "linear", "lock" };
+
+inline std::string getLatencyModelName(LatencyModel model)
+{
+	return latencyModelNames[static_cast<size_t>(model)];
+}
+
+inline LatencyModel parseLatencyModel(std::string_view name)
+{
+	for (size_t i = 0; i < latencyModelNames.size(); i++) {
+		if (name == latencyModelNames[i]) {
+			return static_cast<LatencyModel>(i);
+		}
+	}
+	throw Exception(std::format("unknown latency model: {}", name));
+}
+
+
+// The simulated driver that replaces Vulkan on machines without a GPU, see SimulatedDriver.h
+struct SimulationConfig {
+	std::vector<LatencyModel> latencyModels;	// one simulated device per model, empty to use Vulkan
+	double bindLatency{ 50.0 };					// microseconds per vkQueueBindSparse
+	double entryLatency{ 1.0 };					// microseconds per bind entry
+	double residentLatency{ 0.01 };				// microseconds per resident sparse block, linear model only
+	double submitLatency{ 10.0 };				// microseconds per VkSubmitInfo
+	double transferRate{ 100.0 };				// GB/s of vkCmdFillBuffer and vkCmdCopyBufferToImage
+	VkDeviceSize memorySize{ VkDeviceSize(16) << 30 };
+	VkDeviceSize memoryUsedElsewhere{ 0 };		// device local memory of other processes, left out of the memory budget
+	VkDeviceSize sparseAddressSpaceSize{ VkDeviceSize(1) << 40 };
+
+	bool enabled() const
+	{
+		return !this->latencyModels.empty();
+	}
+};
+
+
+// One point in the benchmark parameter space
+struct BenchmarkParameters {
+	VkExtent3D imageExtent{ 4096, 4096, 1024 };
+	VkExtent3D tileExtent{ 64, 64, 64 };	// 0x0x0 for the sparse image granularity of the format
+	uint32_t batchSize{ 16 };
+	uint32_t bindInfos{ 1 };				// batches per vkQueueBindSparse, each its own VkBindSparseInfo
+	VkFormat format{ VK_FORMAT_R8_SNORM };
+	ImageType imageType{ ImageType::Image3D };
+	ResourceType resource{ ResourceType::Image };
+	uint32_t images{ 1 };				// sparse images the extent is split into, along the axis with the most tiles
+	ImageOrder imageOrder{ ImageOrder::RoundRobin };	// order the images are bound in
+	VkDeviceSize memoryPoolSize{ VkDeviceSize(1) << 30 };
+	VkDeviceSize memoryBlockSize{ 0 };	// size of each device memory block in the pool, 0 for a single block
+	double memoryBudget{ 0.0 };			// fraction of the memory budget left on the heap the pool may use, 0 for no limit
+	bool elasticPool{ false };			// allocate blocks when the pool runs out of pages and release empty ones, implies churn
+	double compactThreshold{ 0.0 };		// pool fragmentation that triggers a compaction, 0 for none, implies churn
+	BindMode bindMode{ BindMode::Sync };
+	uint32_t inFlight{ 1 };
+	ResidencyMode residencyMode{ ResidencyMode::Fill };
+	AccessPattern pattern{ AccessPattern::Linear };
+	double nullTiles{ 0.0 };			// fraction of tiles that are uniform and share one null page, implies churn
+	double nullWrites{ 0.0 };			// fraction of the null tiles written after their bind, which get a private page
+	bool coalesce{ false };				// merge adjacent tiles with contiguous memory into larger binds
+	bool mipChain{ false };				// bind the coarser mip levels of every tile and the mip tail
+	double frameBudget{ 0.0 };			// ms of binding per frame for the scheduler, 0 to bind batchSize tiles at a time
+	bool timeline{ false };				// chain the bind infos with a timeline semaphore instead of fences
+	OverlapMode overlap{ OverlapMode::None };	// dummy work waiting for the binds, implies timeline
+	VkDeviceSize overlapWorkSize{ VkDeviceSize(64) << 20 };	// bytes filled by the dummy work
+	bool upload{ false };				// copy the contents of every bound tile to the image, implies timeline
+	VkDeviceSize stagingSize{ VkDeviceSize(64) << 20 };	// bytes of the staging ring for uploads
+	std::filesystem::path volume;		// bricked volume the uploads read tiles from, implies upload
+	VolumeReaderMode volumeReader{ VolumeReaderMode::Mmap };
+	uint32_t ioThreads{ 4 };			// reader threads of the threads volume reader
+	uint32_t threads{ 0 };				// worker threads binding concurrently, 0 for the single threaded benchmark
+	QueueFamilySelection queueFamily;	// of the sparse binding queue
+	uint32_t warmup{ 0 };				// untimed batches bound and unbound before the run
+	uint32_t repetitions{ 1 };			// runs, each with a fresh image and pool
+	int32_t pinCpu{ -1 };				// the CPU the binding thread is pinned to, workers to the next ones, -1 for none
+
+	// Short, file name friendly description, e.g. "4096x4096x1024 tile64x64x64 batch16 R8_SNORM pool1024MiB"
+	std::string name() const
+	{
+		auto tile = (this->tileExtent.width == 0) ? std::string("auto") : std::format("{}x{}x{}",
+			this->tileExtent.width, this->tileExtent.height, this->tileExtent.depth);
+		auto name = std::format("{}x{}x{} tile{} batch{} {} pool{}MiB",
+			this->imageExtent.width, this->imageExtent.height, this->imageExtent.depth,
+			tile,
+			this->batchSize,
+			getFormatName(this->format),
+			this->memoryPoolSize >> 20);
+
+		if (this->imageType != ImageType::Image3D) {
+			name += " " + getImageTypeName(this->imageType);
+		}
+		if (this->resource == ResourceType::Buffer) {
+			name += " buffer";
+		}
+		if (this->images > 1) {
+			name += std::format(" images{}", this->images);
+			if (this->imageOrder != ImageOrder::RoundRobin) {
+				name += " " + getImageOrderName(this->imageOrder);
+			}
+		}
+		if (this->bindInfos > 1) {
+			name += std::format(" infos{}", this->bindInfos);
+		}
+		if (this->memoryBlockSize > 0) {
+			name += std::format(" block{}MiB", this->memoryBlockSize >> 20);
+		}
+		if (this->memoryBudget > 0.0) {
+			name += std::format(" mem-budget{}", this->memoryBudget);
+		}
+		if (this->elasticPool) {
+			name += " elastic";
+		}
+		if (this->compactThreshold > 0.0) {
+			name += std::format(" compact{}", this->compactThreshold);
+		}
+		if (this->bindMode == BindMode::Async) {
+			name += std::format(" async{}", this->inFlight);
+		}
+		if (this->residencyMode == ResidencyMode::Churn) {
+			name += " churn";
+		}
+		if (this->pattern != AccessPattern::Linear) {
+			name += " " + getAccessPatternName(this->pattern);
+		}
+		if (this->nullTiles > 0.0) {
+			name += std::format(" null{}", this->nullTiles);
+			if (this->nullWrites > 0.0) {
+				name += std::format(" writes{}", this->nullWrites);
+			}
+		}
+		if (this->coalesce) {
+			name += " coalesced";
+		}
+		if (this->mipChain) {
+			name += " mipchain";
+		}
+		if (this->frameBudget > 0.0) {
+			name += std::format(" budget{}ms", this->frameBudget);
+		}
+		if (this->overlap != OverlapMode::None) {
+			name += std::format(" overlap-{}{}MiB", getOverlapModeName(this->overlap), this->overlapWorkSize >> 20);
+		}
+		else if (this->timeline && !this->upload) {
+			name += " timeline";
+		}
+		if (this->upload) {
+			name += std::format(" upload{}MiB", this->stagingSize >> 20);
+		}
+		if (!this->volume.empty()) {
+			name += (this->volumeReader == VolumeReaderMode::Threads) ?
+				std::format(" readers{}", this->ioThreads) : " " + getVolumeReaderModeName(this->volumeReader);
+		}
+		if (this->threads > 0) {
+			name += std::format(" threads{}", this->threads);
+		}
+		if (this->queueFamily != QueueFamilySelection{}) {
+			name += " family-" + this->queueFamily.name();
+		}
+		if (this->warmup > 0) {
+			name += std::format(" warmup{}", this->warmup);
+		}
+		if (this->repetitions > 1) {
+			name += std::format(" reps{}", this->repetitions);
+		}
+		return name;
+	}
+};
+
+
+// Benchmark configuration from the command line and/or a config file. Every option
+// takes a comma separated list of values, and the benchmark runs once for every
+// combination of values (the cartesian product).
+//
+// Command line:  SparseTexture --extent 4096x4096x1024,2048x2048x2048 --batch 1,16,64
+// Config file:   SparseTexture --config sweep.cfg, where sweep.cfg contains lines like
+//                  batch = 1, 16, 64
+//                  # comment
+class BenchmarkConfig {
+public:
+	static constexpr const char* usage =
+		"Usage: SparseTexture [options]\n"
+		"Every option accepts a comma separated list of values. The benchmark is run\n"
+		"for every combination of values, except --output, which lists all formats to write,\n"
+		"and --device and --simulate, which list the devices to run on.\n"
+		"  --extent WxHxD        sparse image extent                (default 4096x4096x1024)\n"
+		"  --tile WxHxD          tile extent, N for NxNxN, or auto for the sparse image\n"
+		"                        granularity of the format, rounded up to a multiple of it,\n"
+		"                        one texel deep in 2D images        (default 64x64x64)\n"
+		"  --batch N             tiles bound per vkQueueBindSparse  (default 16)\n"
+		"  --bind-infos N        batches per vkQueueBindSparse, each its own\n"
+		"                        VkBindSparseInfo                   (default 1)\n"
+		"  --format NAME         image format, e.g. R8_SNORM, R16_UNORM, R8G8B8A8_UNORM or\n"
+		"                        the block-compressed BC1_RGBA_UNORM, BC4_UNORM and BC7_UNORM\n"
+		"                                                           (default R8_SNORM)\n"
+		"  --image-type TYPE     3d, 2d (width and height of the extent) or 2d-array (a layer\n"
+		"                        per depth slice of the extent)     (default 3d)\n"
+		"  --resource TYPE       image, or buffer for a sparse buffer of the same size,\n"
+		"                        one range of tile size per tile    (default image)\n"
+		"  --images N            split the extent into N sparse images of the same total tile\n"
+		"                        count, along the axis with the most tiles (default 1)\n"
+		"  --image-order ORDER   round-robin (one tile of every image in turn) or sequential\n"
+		"                        (image after image)                (default round-robin)\n"
+		"  --pool-size SIZE      tile memory pool size, e.g. 1G     (default 1G)\n"
+		"  --block-size SIZE     device memory block size in the pool (default pool size)\n"
+		"  --memory-budget F     limit the pool to the fraction F of the memory the device\n"
+		"                        local heap has left, as VK_EXT_memory_budget reports it, or\n"
+		"                        of the heap size without it (default 0, no limit)\n"
+		"  --elastic-pool on|off allocate pool blocks when the pool runs out of pages instead\n"
+		"                        of up front, and release blocks that became empty; implies\n"
+		"                        churn residency                    (default off)\n"
+		"  --compact F           once the fraction F of the pages of partially used blocks\n"
+		"                        is free, move their tiles into fewer blocks by rebinding\n"
+		"                        them and release the emptied blocks; implies churn\n"
+		"                        residency                          (default 0, off)\n"
+		"  --mode MODE           sync (wait for every bind) or async (default sync)\n"
+		"  --in-flight N         binds in flight in async mode      (default 4)\n"
+		"  --residency MODE      fill (bind every tile once) or churn (evict least recently\n"
+		"                        used tiles once the pool is full)  (default fill)\n"
+		"  --pattern NAME        order of tile requests: linear, morton, random, slab or\n"
+		"                        camera (a camera path requesting and releasing tiles)\n"
+		"                                                           (default linear)\n"
+		"  --null-tiles F        bind the fraction F of the tiles, which are taken to be\n"
+		"                        uniform, to one shared read-only page; implies churn\n"
+		"                        residency                          (default 0)\n"
+		"  --null-writes F       write the fraction F of the null tiles after their bind,\n"
+		"                        which rebinds them to a private page (default 0)\n"
+		"  --coalesce on|off     merge adjacent tiles into larger binds (default off)\n"
+		"  --mip-chain on|off    also bind the tiles of all coarser mip levels covering a\n"
+		"                        requested tile, and the mip tail   (default off)\n"
+		"  --frame-budget MS     bind in frames of at most MS milliseconds, in batches of up\n"
+		"                        to --batch tiles sized by a latency model (default 0, off)\n"
+		"  --timeline on|off     chain every VkBindSparseInfo to the previous one with a timeline\n"
+		"                        semaphore, and wait for it instead of fences (default off)\n"
+		"  --overlap MODE        after every other vkQueueBindSparse, submit dummy work that waits\n"
+		"                        for the bind, on the same queue or another queue, or none;\n"
+		"                        implies --timeline                 (default none)\n"
+		"  --overlap-work SIZE   bytes the dummy work fills with vkCmdFillBuffer (default 64M)\n"
+		"  --upload on|off       write every bound tile to a staging ring and copy it to the\n"
+		"                        image on a transfer queue; implies --timeline (default off)\n"
+		"  --staging-size SIZE   staging ring size for uploads      (default 64M)\n"
+		"  --volume FILE         upload the tiles of a bricked volume file written with\n"
+		"                        --write-volume; implies --upload   (single value)\n"
+		"  --volume-reader MODE  mmap (copy tiles from the mapped file) or threads (read them\n"
+		"                        on --io-threads threads)           (default mmap)\n"
+		"  --io-threads N        reader threads of the threads reader (default 4)\n"
+		"  --write-volume FILE   write a volume of synthetic tiles matching the extent, tile\n"
+		"                        extent, format and mip levels of the first combination, and exit\n"
+		"  --threads N           bind from N threads, each with its own queue and image,\n"
+		"                        while a control thread measures vkQueueSubmit latency;\n"
+		"                        0 runs the single threaded benchmark   (default 0)\n"
+		"  --warmup N            bind and unbind N batches before the timed run, so that cold\n"
+		"                        start costs stay out of the timings (default 0)\n"
+		"  --repetitions N       run N times, each with a fresh image and pool, and report\n"
+		"                        completion times per coverage bucket over all runs, with\n"
+		"                        95% confidence intervals and outlier counts; without\n"
+		"                        --threads (default 1)\n"
+		"  --pin-cpu N           pin the binding thread to CPU N and --threads workers to the\n"
+		"                        following CPUs (single value, default off)\n"
+		"  --device FILTER       run on the devices matching any FILTER: an index in the order\n"
+		"                        of enumeration, a vendor (nvidia, amd, intel, ... or a\n"
+		"                        vendor ID like 0x10de) or part of the name (default all)\n"
+		"  --queue-family FAMILY bind on the first family with graphics and sparse binding\n"
+		"                        (graphics), a family with sparse binding but neither\n"
+		"                        graphics nor compute (sparse-only, graphics if there is\n"
+		"                        none) or the family with index N (default graphics)\n"
+		"  --concurrent-devices on|off\n"
+		"                        run every combination on all devices at the same time,\n"
+		"                        a thread per device, after running it on every device\n"
+		"                        alone; without --threads (default off)\n"
+		"  --processes N         run the benchmark in N processes started at the same time,\n"
+		"                        and merge their results; 0 runs it in one process\n"
+		"                        without the start barrier, as a baseline\n"
+		"  --trace FILE          record submits, waits, allocations, uploads and unbinds of\n"
+		"                        every thread, and write them as Chrome trace JSON for\n"
+		"                        chrome://tracing or ui.perfetto.dev at exit\n"
+		"  --output FORMAT       result file formats: txt, json (per-batch rows, statistics,\n"
+		"                        configuration and device limits) and/or csv (default txt)\n"
+		"  --driver FILE         load only the Vulkan driver with the ICD manifest FILE, e.g. a\n"
+		"                        software driver like lavapipe's lvp_icd.x86_64.json\n"
+		"  --simulate MODEL      run on a simulated device instead of Vulkan, one per MODEL:\n"
+		"                        constant, linear (grows with resident blocks) or lock\n"
+		"                        (one lock for all binds and submits). The --sim options\n"
+		"                        take a single value, latencies are in microseconds:\n"
+		"  --sim-bind-latency US      per vkQueueBindSparse         (default 50)\n"
+		"  --sim-entry-latency US     per bind entry                (default 1)\n"
+		"  --sim-resident-latency US  per resident 64 KiB block     (default 0.01)\n"
+		"  --sim-submit-latency US    per VkSubmitInfo              (default 10)\n"
+		"  --sim-transfer-rate GBS    GB/s of vkCmdFillBuffer and\n"
+		"                             vkCmdCopyBufferToImage        (default 100)\n"
+		"  --sim-memory SIZE          device local memory           (default 16G)\n"
+		"  --sim-memory-used SIZE     device local memory other processes\n"
+		"                             use, left out of the budget   (default 0)\n"
+		"  --sim-address-space SIZE   sparse address space          (default 1T)\n"
+		"  --config FILE         read options from FILE, one 'option = values' per line\n"
+		"  --help                print this message\n";
+
+	static BenchmarkConfig parse(int argc, const char* argv[])
+	{
+		BenchmarkConfig config;
+		for (int i = 1; i < argc; i++) {
+			std::string_view arg(argv[i]);
+			if (arg == "--help" || arg == "-h") {
+				config.help = true;
+				continue;
+			}
+			if (!arg.starts_with("--")) {
+				throw Exception(std::format("unexpected argument: {}\n{}", arg, usage));
+			}
+			arg.remove_prefix(2);
+
+			std::string_view value;
+			auto equals = arg.find('=');
+			if (equals != std::string_view::npos) {
+				value = arg.substr(equals + 1);
+				arg = arg.substr(0, equals);
+			}
+			else if (i + 1 < argc) {
+				value = argv[++i];
+			}
+			else {
+				throw Exception(std::format("missing value for option --{}", arg));
+			}
+			config.set(arg, value);
+		}
+		return config;
+	}
+
+	void load(const std::filesystem::path& path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			throw Exception(std::format("could not open config file: {}", path.string()));
+		}
+		std::string line;
+		while (std::getline(file, line)) {
+			auto content = trim(std::string_view(line).substr(0, line.find('#')));
+			if (content.empty()) {
+				continue;
+			}
+			auto equals = content.find('=');
+			if (equals == std::string_view::npos) {
+				throw Exception(std::format("{}: expected 'option = values', got: {}", path.string(), content));
+			}
+			this->set(trim(content.substr(0, equals)), trim(content.substr(equals + 1)));
+		}
+	}
+
+	void set(std::string_view option, std::string_view value)
+	{
+		if (option == "config") {
+			this->load(std::filesystem::path(value));
+		}
+		else if (option == "extent") {
+			this->imageExtents = parseList(value, parseExtent);
+		}
+		else if (option == "tile") {
+			this->tileExtents = parseList(value, [](std::string_view s) {
+				return (s == "auto") ? VkExtent3D{ 0, 0, 0 } : parseExtent(s);
+			});
+		}
+		else if (option == "batch") {
+			this->batchSizes = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseNumber(s)); });
+		}
+		else if (option == "bind-infos") {
+			this->bindInfoCounts = parseList(value, [](std::string_view s) {
+				auto count = static_cast<uint32_t>(parseNumber(s));
+				if (count == 0) {
+					throw Exception("--bind-infos must be at least 1");
+				}
+				return count;
+			});
+		}
+		else if (option == "format") {
+			this->formats = parseList(value, parseFormat);
+		}
+		else if (option == "image-type") {
+			this->imageTypes = parseList(value, parseImageType);
+		}
+		else if (option == "resource") {
+			this->resourceTypes = parseList(value, parseResourceType);
+		}
+		else if (option == "images") {
+			this->imageCounts = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseNumber(s)); });
+		}
+		else if (option == "image-order") {
+			this->imageOrders = parseList(value, parseImageOrder);
+		}
+		else if (option == "pool-size") {
+			this->memoryPoolSizes = parseList(value, parseSize);
+		}
+		else if (option == "block-size") {
+			this->memoryBlockSizes = parseList(value, parseSize);
+		}
+		else if (option == "memory-budget") {
+			this->memoryBudgets = parseList(value, parseFraction);
+		}
+		else if (option == "elastic-pool") {
+			this->elasticPoolValues = parseList(value, parseBool);
+		}
+		else if (option == "compact") {
+			this->compactThresholds = parseList(value, parseFraction);
+		}
+		else if (option == "mode") {
+			this->bindModes = parseList(value, parseBindMode);
+		}
+		else if (option == "in-flight") {
+			this->inFlights = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseNumber(s)); });
+		}
+		else if (option == "residency") {
+			this->residencyModes = parseList(value, parseResidencyMode);
+		}
+		else if (option == "pattern") {
+			this->patterns = parseList(value, parseAccessPattern);
+		}
+		else if (option == "coalesce") {
+			this->coalesceValues = parseList(value, parseBool);
+		}
+		else if (option == "frame-budget") {
+			this->frameBudgets = parseList(value, parseDouble);
+		}
+		else if (option == "timeline") {
+			this->timelineValues = parseList(value, parseBool);
+		}
+		else if (option == "overlap") {
+			this->overlapModes = parseList(value, parseOverlapMode);
+		}
+		else if (option == "overlap-work") {
+			this->overlapWorkSizes = parseList(value, parseSize);
+		}
+		else if (option == "upload") {
+			this->uploadValues = parseList(value, parseBool);
+		}
+		else if (option == "staging-size") {
+			this->stagingSizes = parseList(value, parseSize);
+		}
+		else if (option == "volume") {
+			this->volume = value;
+		}
+		else if (option == "volume-reader") {
+			this->volumeReaders = parseList(value, parseVolumeReaderMode);
+		}
+		else if (option == "io-threads") {
+			this->ioThreadCounts = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseNumber(s)); });
+		}
+		else if (option == "write-volume") {
+			this->writeVolume = value;
+		}
+		else if (option == "null-tiles") {
+			this->nullTileFractions = parseList(value, parseFraction);
+		}
+		else if (option == "null-writes") {
+			this->nullWriteFractions = parseList(value, parseFraction);
+		}
+		else if (option == "mip-chain") {
+			this->mipChainValues = parseList(value, parseBool);
+		}
+		else if (option == "warmup") {
+			this->warmups = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseInteger(s)); });
+		}
+		else if (option == "repetitions") {
+			this->repetitionCounts = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseNumber(s)); });
+		}
+		else if (option == "pin-cpu") {
+			this->pinCpu = static_cast<int32_t>(parseInteger(value));
+		}
+		else if (option == "threads") {
+			this->threadCounts = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseInteger(s)); });
+		}
+		else if (option == "device") {
+			this->devices = parseList(value, DeviceFilter::parse);
+		}
+		else if (option == "queue-family") {
+			this->queueFamilies = parseList(value, QueueFamilySelection::parse);
+		}
+		else if (option == "concurrent-devices") {
+			this->concurrentDevices = parseBool(value);
+		}
+		else if (option == "output") {
+			this->outputFormats = parseList(value, parseOutputFormat);
+		}
+		else if (option == "trace") {
+			this->trace = value;
+		}
+		else if (option == "driver") {
+			this->driver = value;
+		}
+		else if (option == "simulate") {
+			this->simulation.latencyModels = parseList(value, parseLatencyModel);
+		}
+		else if (option == "sim-bind-latency") {
+			this->simulation.bindLatency = parseDouble(value);
+		}
+		else if (option == "sim-entry-latency") {
+			this->simulation.entryLatency = parseDouble(value);
+		}
+		else if (option == "sim-resident-latency") {
+			this->simulation.residentLatency = parseDouble(value);
+		}
+		else if (option == "sim-submit-latency") {
+			this->simulation.submitLatency = parseDouble(value);
+		}
+		else if (option == "sim-transfer-rate") {
+			this->simulation.transferRate = parseDouble(value);
+		}
+		else if (option == "sim-memory") {
+			this->simulation.memorySize = parseSize(value);
+		}
+		else if (option == "sim-memory-used") {
+			this->simulation.memoryUsedElsewhere = parseSize(value);
+		}
+		else if (option == "sim-address-space") {
+			this->simulation.sparseAddressSpaceSize = parseSize(value);
+		}
+		else if (option == "processes") {
+			this->processCounts = parseList(value, [](std::string_view s) { return static_cast<uint32_t>(parseInteger(s)); });
+		}
+		// set by the process coordinator on the command line of its child processes
+		else if (option == "child") {
+			this->child = static_cast<int32_t>(parseInteger(value));
+		}
+		else if (option == "child-count") {
+			this->childCount = static_cast<uint32_t>(parseNumber(value));
+		}
+		else if (option == "child-directory") {
+			this->childDirectory = value;
+		}
+		else {
+			throw Exception(std::format("unknown option: --{}\n{}", option, usage));
+		}
+	}
+
+	// All combinations of the configured values
+	std::vector<BenchmarkParameters> sweep() const
+	{
+		std::vector<BenchmarkParameters> combinations{ BenchmarkParameters{} };
+
+		// replaces every combination so far with one copy per value of the option
+		auto expand = [&combinations](const auto& values, auto assign) {
+			std::vector<BenchmarkParameters> expanded;
+			for (auto& combination : combinations) {
+				for (const auto& value : values) {
+					expanded.push_back(combination);
+					assign(expanded.back(), value);
+				}
+			}
+			combinations = std::move(expanded);
+		};
+
+		expand(this->imageExtents, [](auto& p, auto& v) { p.imageExtent = v; });
+		expand(this->tileExtents, [](auto& p, auto& v) { p.tileExtent = v; });
+		expand(this->batchSizes, [](auto& p, auto& v) { p.batchSize = v; });
+		expand(this->bindInfoCounts, [](auto& p, auto& v) { p.bindInfos = v; });
+		expand(this->formats, [](auto& p, auto& v) { p.format = v; });
+		expand(this->imageTypes, [](auto& p, auto& v) { p.imageType = v; });
+		expand(this->resourceTypes, [](auto& p, auto& v) { p.resource = v; });
+		expand(this->imageCounts, [](auto& p, auto& v) { p.images = v; });
+		expand(this->imageOrders, [](auto& p, auto& v) { p.imageOrder = v; });
+		expand(this->memoryPoolSizes, [](auto& p, auto& v) { p.memoryPoolSize = v; });
+		expand(this->memoryBlockSizes, [](auto& p, auto& v) { p.memoryBlockSize = v; });
+		expand(this->memoryBudgets, [](auto& p, auto& v) { p.memoryBudget = v; });
+		expand(this->elasticPoolValues, [](auto& p, auto& v) { p.elasticPool = v; });
+		expand(this->compactThresholds, [](auto& p, auto& v) { p.compactThreshold = v; });
+		expand(this->bindModes, [](auto& p, auto& v) { p.bindMode = v; });
+		expand(this->inFlights, [](auto& p, auto& v) { p.inFlight = v; });
+		expand(this->residencyModes, [](auto& p, auto& v) { p.residencyMode = v; });
+		expand(this->patterns, [](auto& p, auto& v) { p.pattern = v; });
+		expand(this->nullTileFractions, [](auto& p, auto& v) { p.nullTiles = v; });
+		expand(this->nullWriteFractions, [](auto& p, auto& v) { p.nullWrites = v; });
+		expand(this->coalesceValues, [](auto& p, auto& v) { p.coalesce = v; });
+		expand(this->mipChainValues, [](auto& p, auto& v) { p.mipChain = v; });
+		expand(this->frameBudgets, [](auto& p, auto& v) { p.frameBudget = v; });
+		expand(this->timelineValues, [](auto& p, auto& v) { p.timeline = v; });
+		expand(this->overlapModes, [](auto& p, auto& v) { p.overlap = v; });
+		expand(this->overlapWorkSizes, [](auto& p, auto& v) { p.overlapWorkSize = v; });
+		expand(this->uploadValues, [](auto& p, auto& v) { p.upload = v; });
+		expand(this->stagingSizes, [](auto& p, auto& v) { p.stagingSize = v; });
+		expand(this->volumeReaders, [](auto& p, auto& v) { p.volumeReader = v; });
+		expand(this->ioThreadCounts, [](auto& p, auto& v) { p.ioThreads = v; });
+		expand(this->threadCounts, [](auto& p, auto& v) { p.threads = v; });
+		expand(this->queueFamilies, [](auto& p, auto& v) { p.queueFamily = v; });
+		expand(this->warmups, [](auto& p, auto& v) { p.warmup = v; });
+		expand(this->repetitionCounts, [](auto& p, auto& v) { p.repetitions = v; });
+
+		// repetitions are summarized only for the single threaded benchmark
+		std::erase_if(combinations, [this](const BenchmarkParameters& p) {
+			return p.threads > 0 && p.repetitions != this->repetitionCounts.front();
+		});
+		for (auto& combination : combinations) {
+			if (combination.threads > 0) {
+				combination.repetitions = 1;
+			}
+		}
+
+		// the in-flight depth only matters to async binding
+		std::erase_if(combinations, [this](const BenchmarkParameters& p) {
+			return p.bindMode == BindMode::Sync && p.inFlight != this->inFlights.front();
+		});
+		for (auto& combination : combinations) {
+			if (combination.bindMode == BindMode::Sync) {
+				combination.inFlight = 1;
+			}
+		}
+
+		// the image order only matters to several images
+		std::erase_if(combinations, [this](const BenchmarkParameters& p) {
+			return p.images == 1 && p.imageOrder != this->imageOrders.front();
+		});
+
+		// null tiles are tracked by the residency manager, and only they can be written.
+		// The residency manager also knows the tiles to move when the pool is compacted,
+		// and releases the tiles that let the elastic pool shrink.
+		auto needsChurn = [](const BenchmarkParameters& p) {
+			return p.nullTiles > 0.0 || p.elasticPool || p.compactThreshold > 0.0;
+		};
+		std::erase_if(combinations, [this, needsChurn](const BenchmarkParameters& p) {
+			return (needsChurn(p) && p.residencyMode != ResidencyMode::Churn && std::ranges::count(this->residencyModes, ResidencyMode::Churn) > 0) ||
+				(p.nullTiles == 0.0 && p.nullWrites != this->nullWriteFractions.front());
+		});
+		for (auto& combination : combinations) {
+			if (needsChurn(combination)) {
+				combination.residencyMode = ResidencyMode::Churn;
+			}
+		}
+
+		// tiles read from a volume are uploaded, and the reader threads only matter to the threads reader
+		std::erase_if(combinations, [this](const BenchmarkParameters& p) {
+			return (!this->volume.empty() && !p.upload && std::ranges::count(this->uploadValues, true) > 0) ||
+				(p.volumeReader != VolumeReaderMode::Threads && p.ioThreads != this->ioThreadCounts.front());
+		});
+		for (auto& combination : combinations) {
+			combination.volume = this->volume;
+			combination.pinCpu = this->pinCpu;
+			if (!this->volume.empty()) {
+				combination.upload = true;
+			}
+		}
+
+		// overlapping work and uploads wait for the timeline value of their bind, and the
+		// work and staging sizes only matter to them
+		std::erase_if(combinations, [this](const BenchmarkParameters& p) {
+			return ((p.overlap != OverlapMode::None || p.upload) && !p.timeline && std::ranges::count(this->timelineValues, true) > 0) ||
+				(p.overlap == OverlapMode::None && p.overlapWorkSize != this->overlapWorkSizes.front()) ||
+				(!p.upload && p.stagingSize != this->stagingSizes.front());
+		});
+		for (auto& combination : combinations) {
+			if (combination.overlap != OverlapMode::None || combination.upload) {
+				combination.timeline = true;
+			}
+		}
+		return combinations;
+	}
+
+	uint32_t maxThreads() const
+	{
+		return *std::max_element(this->threadCounts.begin(), this->threadCounts.end());
+	}
+
+	static std::string_view trim(std::string_view s)
+	{
+		auto begin = s.find_first_not_of(" \t\r\n");
+		if (begin == std::string_view::npos) {
+			return {};
+		}
+		auto end = s.find_last_not_of(" \t\r\n");
+		return s.substr(begin, end - begin + 1);
+	}
+
+	template <typename Parser>
+	static std::vector<std::invoke_result_t<Parser, std::string_view>> parseList(std::string_view list, Parser parser)
+	{
+		std::vector<std::invoke_result_t<Parser, std::string_view>> values;
+		while (!list.empty()) {
+			auto comma = list.find(',');
+			auto item = trim(list.substr(0, comma));
+			if (!item.empty()) {
+				values.push_back(parser(item));
+			}
+			list = (comma == std::string_view::npos) ? std::string_view() : list.substr(comma + 1);
+		}
+		if (values.empty()) {
+			throw Exception("empty value list");
+		}
+		return values;
+	}
+
+	static uint64_t parseInteger(std::string_view s)
+	{
+		uint64_t value = 0;
+		auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+		if (error != std::errc() || end != s.data() + s.size()) {
+			throw Exception(std::format("expected an integer, got: {}", s));
+		}
+		return value;
+	}
+
+	static uint64_t parseNumber(std::string_view s)
+	{
+		auto value = parseInteger(s);
+		if (value == 0) {
+			throw Exception(std::format("expected a positive integer, got: {}", s));
+		}
+		return value;
+	}
+
+	static double parseDouble(std::string_view s)
+	{
+		double value = 0.0;
+		auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+		if (error != std::errc() || end != s.data() + s.size() || value < 0.0) {
+			throw Exception(std::format("expected a non-negative number, got: {}", s));
+		}
+		return value;
+	}
+
+	static double parseFraction(std::string_view s)
+	{
+		auto value = parseDouble(s);
+		if (value > 1.0) {
+			throw Exception(std::format("expected a fraction from 0 to 1, got: {}", s));
+		}
+		return value;
+	}
+
+	static bool parseBool(std::string_view s)
+	{
+		if (s == "on" || s == "true" || s == "yes" || s == "1") {
+			return true;
+		}
+		if (s == "off" || s == "false" || s == "no" || s == "0") {
+			return false;
+		}
+		throw Exception(std::format("expected on or off, got: {}", s));
+	}
+
+	// "1073741824", "1024M", "1G", "1GiB"
+	static VkDeviceSize parseSize(std::string_view s)
+	{
+		if (s.ends_with("iB") || s.ends_with("ib")) {
+			s.remove_suffix(2);
+		}
+		VkDeviceSize shift = 0;
+		switch (s.empty() ? '\0' : s.back()) {
+		case 'K': case 'k': shift = 10; break;
+		case 'M': case 'm': shift = 20; break;
+		case 'G': case 'g': shift = 30; break;
+		case 'T': case 't': shift = 40; break;
+		}
+		if (shift != 0) {
+			s.remove_suffix(1);
+		}
+		return parseNumber(s) << shift;
+	}
+
+	// "4096x4096x1024", or "64" for a 64x64x64 cube
+	static VkExtent3D parseExtent(std::string_view s)
+	{
+		std::vector<uint32_t> dimensions;
+		while (true) {
+			auto x = s.find('x');
+			dimensions.push_back(static_cast<uint32_t>(parseNumber(s.substr(0, x))));
+			if (x == std::string_view::npos) {
+				break;
+			}
+			s = s.substr(x + 1);
+		}
+		if (dimensions.size() == 1) {
+			return { dimensions[0], dimensions[0], dimensions[0] };
+		}
+		if (dimensions.size() == 3) {
+			return { dimensions[0], dimensions[1], dimensions[2] };
+		}
+		throw Exception("expected an extent of the form WxHxD");
+	}
+
+	bool help{ false };
+	std::vector<VkExtent3D> imageExtents{ { 4096, 4096, 1024 } };
+	std::vector<VkExtent3D> tileExtents{ { 64, 64, 64 } };
+	std::vector<uint32_t> batchSizes{ 16 };
+	std::vector<uint32_t> bindInfoCounts{ 1 };
+	std::vector<VkFormat> formats{ VK_FORMAT_R8_SNORM };
+	std::vector<ImageType> imageTypes{ ImageType::Image3D };
+	std::vector<ResourceType> resourceTypes{ ResourceType::Image };
+	std::vector<uint32_t> imageCounts{ 1 };
+	std::vector<ImageOrder> imageOrders{ ImageOrder::RoundRobin };
+	std::vector<VkDeviceSize> memoryPoolSizes{ VkDeviceSize(1) << 30 };
+	std::vector<VkDeviceSize> memoryBlockSizes{ 0 };
+	std::vector<double> memoryBudgets{ 0.0 };
+	std::vector<bool> elasticPoolValues{ false };
+	std::vector<double> compactThresholds{ 0.0 };
+	std::vector<BindMode> bindModes{ BindMode::Sync };
+	std::vector<uint32_t> inFlights{ 4 };
+	std::vector<ResidencyMode> residencyModes{ ResidencyMode::Fill };
+	std::vector<AccessPattern> patterns{ AccessPattern::Linear };
+	std::vector<double> nullTileFractions{ 0.0 };
+	std::vector<double> nullWriteFractions{ 0.0 };
+	std::vector<bool> coalesceValues{ false };
+	std::vector<bool> mipChainValues{ false };
+	std::vector<double> frameBudgets{ 0.0 };
+	std::vector<bool> timelineValues{ false };
+	std::vector<OverlapMode> overlapModes{ OverlapMode::None };
+	std::vector<VkDeviceSize> overlapWorkSizes{ VkDeviceSize(64) << 20 };
+	std::vector<bool> uploadValues{ false };
+	std::vector<VkDeviceSize> stagingSizes{ VkDeviceSize(64) << 20 };
+	std::filesystem::path volume;
+	std::vector<VolumeReaderMode> volumeReaders{ VolumeReaderMode::Mmap };
+	std::vector<uint32_t> ioThreadCounts{ 4 };
+	std::filesystem::path writeVolume;
+	std::vector<uint32_t> threadCounts{ 0 };
+	std::vector<QueueFamilySelection> queueFamilies{ QueueFamilySelection{} };
+	std::vector<DeviceFilter> devices;			// all devices if empty
+	bool concurrentDevices{ false };
+	std::vector<uint32_t> warmups{ 0 };
+	std::vector<uint32_t> repetitionCounts{ 1 };
+	int32_t pinCpu{ -1 };
+	std::vector<uint32_t> processCounts;
+	std::vector<OutputFormat> outputFormats{ OutputFormat::Text };
+	std::filesystem::path trace;
+	std::filesystem::path driver;
+	SimulationConfig simulation;
+	int32_t child{ -1 };
+	uint32_t childCount{ 0 };
+	std::filesystem::path childDirectory;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <DeviceSelection.h>
+
+#include <format>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <optional>
+
+
+// A device with the queues the benchmarks need: the sparse binding queue used by
+// the single threaded benchmark, from the family queueFamily selects, a control queue
+// for measuring the latency of unrelated submissions, and as many additional sparse
+// binding queues as the device offers, up to workerQueueCount. The control queue is
+// never one of the sparse binding queues, and is null if the device has no queue left
+// for it. The queues are added to physicalDevice, so every BenchmarkDevice needs a
+// VulkanPhysicalDevice of its own.
+class BenchmarkDevice {
+public:
+	BenchmarkDevice(
+		std::shared_ptr<VulkanInstance> instance,
+		std::shared_ptr<VulkanPhysicalDevice> physicalDevice,
+		uint32_t workerQueueCount = 1,
+		QueueFamilySelection queueFamily = {})
+	{
+		auto sparseQueueFamilyIndex = queueFamily.select(*physicalDevice);
+		auto sparseQueueIndex = physicalDevice->addQueue(sparseQueueFamilyIndex);
+
+		// the control queue is a graphics queue if one is left, else any other queue, but
+		// not a sparse binding queue, whose binds it would wait behind
+		std::optional<std::pair<uint32_t, uint32_t>> controlQueueSlot;
+		for (auto required : { VkQueueFlags(VK_QUEUE_GRAPHICS_BIT), VkQueueFlags(0) }) {
+			for (uint32_t family = 0; family < physicalDevice->physicalDeviceQueueFamilyProperties.size() && !controlQueueSlot; family++) {
+				auto flags = physicalDevice->physicalDeviceQueueFamilyProperties[family].queueFlags;
+				if ((flags & required) == required && physicalDevice->getAvailableQueueCount(family) > 0) {
+					controlQueueSlot.emplace(family, physicalDevice->addQueue(family));
+				}
+			}
+		}
+
+		// additional sparse binding queues, first from the same family, then from other sparse capable families
+		std::vector<std::pair<uint32_t, uint32_t>> workerQueueSlots{ { sparseQueueFamilyIndex, sparseQueueIndex } };
+		std::vector<uint32_t> families{ sparseQueueFamilyIndex };
+		for (uint32_t family = 0; family < physicalDevice->physicalDeviceQueueFamilyProperties.size(); family++) {
+			auto flags = physicalDevice->physicalDeviceQueueFamilyProperties[family].queueFlags;
+			if (family != sparseQueueFamilyIndex && (flags & VK_QUEUE_SPARSE_BINDING_BIT)) {
+				families.push_back(family);
+			}
+		}
+		for (auto family : families) {
+			while (workerQueueSlots.size() < workerQueueCount && physicalDevice->getAvailableQueueCount(family) > 0) {
+				workerQueueSlots.emplace_back(family, physicalDevice->addQueue(family));
+			}
+		}
+
+		// uploads go to a dedicated transfer queue if the device has one, since it runs copies
+		// alongside other queues, and else to any other queue that can copy
+		std::optional<std::pair<uint32_t, uint32_t>> transferQueueSlot;
+		auto findTransferFamily = [&](auto isSuitable) -> std::optional<uint32_t> {
+			for (uint32_t family = 0; family < physicalDevice->physicalDeviceQueueFamilyProperties.size(); family++) {
+				auto flags = physicalDevice->physicalDeviceQueueFamilyProperties[family].queueFlags;
+				if (isSuitable(flags) && physicalDevice->getAvailableQueueCount(family) > 0) {
+					return family;
+				}
+			}
+			return std::nullopt;
+		};
+		auto transferFamily = findTransferFamily([](VkQueueFlags flags) {
+			return (flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+		});
+		if (!transferFamily) {
+			transferFamily = findTransferFamily([](VkQueueFlags flags) {
+				return (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)) != 0;
+			});
+		}
+		if (transferFamily) {
+			transferQueueSlot.emplace(*transferFamily, physicalDevice->addQueue(*transferFamily));
+		}
+
+		this->device = std::make_shared<VulkanDevice>(instance, physicalDevice, physicalDevice->deviceQueueCreateInfos);
+
+		for (auto& [family, index] : workerQueueSlots) {
+			this->workerQueues.push_back(std::make_shared<VulkanQueue>(this->device, family, index));
+		}
+		this->queue = this->workerQueues.front();
+		if (controlQueueSlot) {
+			this->controlQueue = std::make_shared<VulkanQueue>(this->device, controlQueueSlot->first, controlQueueSlot->second);
+		}
+		this->transferQueue = transferQueueSlot ?
+			std::make_shared<VulkanQueue>(this->device, transferQueueSlot->first, transferQueueSlot->second) :
+			this->queue;
+	}
+
+	// The queue for worker thread i. Workers sharing a queue would serialize on it, and
+	// measure that instead of the driver, so every worker needs a queue of its own.
+	std::shared_ptr<VulkanQueue> getWorkerQueue(size_t worker) const
+	{
+		if (worker >= this->workerQueues.size()) {
+			throw Exception(std::format("worker {} has no sparse binding queue of its own, the device offers {}.",
+				worker, this->workerQueues.size()));
+		}
+		return this->workerQueues[worker];
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	std::shared_ptr<VulkanQueue> queue{ nullptr };
+	std::shared_ptr<VulkanQueue> controlQueue{ nullptr };		// null if the device has no queue left
+	std::shared_ptr<VulkanQueue> transferQueue{ nullptr };		// for uploads
+	std::vector<std::shared_ptr<VulkanQueue>> workerQueues;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#include <tuple>
+#include <vector>
+#include <algorithm>
+
+
+// Merges the tile binds of one vkQueueBindSparse into fewer, larger binds. Two binds
+// are merged when their regions are adjacent along one axis and have the same extent
+// in the other two, and either both unbind (memory = VK_NULL_HANDLE), or both bind the
+// same memory and the second one continues where the first one ends. The binds are
+// merged along x, y and z in turn until nothing changes, so a box of tiles with
+// contiguous memory becomes a single bind. The merged list is in a different order
+// than the input.
+//
+// A merged bind is backed by the same memory range as the binds it replaces, but the
+// sparse blocks inside the region are assigned to that range in the order of the
+// merged region, so the memory of a single tile in it is not the memory it was given.
+// Callers that later unbind or reuse the memory of individual tiles should only merge
+// unbinds, with mergeBound = false. Buffer binds are merged along the buffer instead.
+class BindCoalescer {
+public:
+	BindCoalescer(VkExtent3D tileExtent, VkDeviceSize tileSize) :
+		tileExtent(tileExtent),
+		tileSize(tileSize)
+	{
+	}
+
+	void coalesce(std::vector<VkSparseImageMemoryBind>& binds, bool mergeBound = true) const
+	{
+		for (auto count = binds.size() + 1; binds.size() < count;) {
+			count = binds.size();
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				this->coalesceAxis(binds, axis, mergeBound);
+			}
+		}
+	}
+
+	// Buffers are linear, so a merged buffer bind maps every byte to the same memory as
+	// the binds it replaces, and binds can always be merged, not only unbinds.
+	void coalesce(std::vector<VkSparseMemoryBind>& binds) const
+	{
+		auto key = [](const VkSparseMemoryBind& bind) {
+			return std::make_tuple(reinterpret_cast<uint64_t>(bind.memory), bind.flags, bind.resourceOffset);
+		};
+		std::sort(binds.begin(), binds.end(), [&](auto& lhs, auto& rhs) { return key(lhs) < key(rhs); });
+
+		size_t merged = 0;
+		for (size_t i = 1; i < binds.size(); i++) {
+			auto& last = binds[merged];
+			auto& bind = binds[i];
+			if (last.memory == bind.memory && last.flags == bind.flags &&
+				last.resourceOffset + last.size == bind.resourceOffset &&
+				(bind.memory == VK_NULL_HANDLE || last.memoryOffset + last.size == bind.memoryOffset)) {
+				last.size += bind.size;
+			}
+			else {
+				binds[++merged] = bind;
+			}
+		}
+		if (!binds.empty()) {
+			binds.resize(merged + 1);
+		}
+	}
+
+	static int32_t getOffset(const VkSparseImageMemoryBind& bind, uint32_t axis)
+	{
+		return (axis == 0) ? bind.offset.x : (axis == 1) ? bind.offset.y : bind.offset.z;
+	}
+
+	static uint32_t getExtent(const VkExtent3D& extent, uint32_t axis)
+	{
+		return (axis == 0) ? extent.width : (axis == 1) ? extent.height : extent.depth;
+	}
+
+	static void grow(VkSparseImageMemoryBind& bind, uint32_t axis, uint32_t size)
+	{
+		(axis == 0 ? bind.extent.width : axis == 1 ? bind.extent.height : bind.extent.depth) += size;
+	}
+
+	// bytes of memory bound by a region of whole tiles
+	VkDeviceSize getMemorySize(const VkSparseImageMemoryBind& bind) const
+	{
+		return this->tileSize *
+			(bind.extent.width / this->tileExtent.width) *
+			(bind.extent.height / this->tileExtent.height) *
+			(bind.extent.depth / this->tileExtent.depth);
+	}
+
+	bool isWholeTiles(const VkSparseImageMemoryBind& bind) const
+	{
+		return
+			bind.extent.width % this->tileExtent.width == 0 &&
+			bind.extent.height % this->tileExtent.height == 0 &&
+			bind.extent.depth % this->tileExtent.depth == 0;
+	}
+
+	void coalesceAxis(std::vector<VkSparseImageMemoryBind>& binds, uint32_t axis, bool mergeBound) const
+	{
+		auto a = (axis + 1) % 3;
+		auto b = (axis + 2) % 3;
+		// binds that can be merged along axis end up next to each other, in order along axis
+		auto key = [&](const VkSparseImageMemoryBind& bind) {
+			return std::make_tuple(
+				bind.subresource.mipLevel,
+				bind.subresource.arrayLayer,
+				reinterpret_cast<uint64_t>(bind.memory),
+				getOffset(bind, b), getExtent(bind.extent, b),
+				getOffset(bind, a), getExtent(bind.extent, a),
+				getOffset(bind, axis));
+		};
+		std::sort(binds.begin(), binds.end(), [&](auto& lhs, auto& rhs) { return key(lhs) < key(rhs); });
+
+		size_t merged = 0;
+		for (size_t i = 1; i < binds.size(); i++) {
+			auto& last = binds[merged];
+			auto& bind = binds[i];
+			if (this->canMerge(last, bind, axis, a, b, mergeBound)) {
+				grow(last, axis, getExtent(bind.extent, axis));
+			}
+			else {
+				binds[++merged] = bind;
+			}
+		}
+		if (!binds.empty()) {
+			binds.resize(merged + 1);
+		}
+	}
+
+	bool canMerge(
+		const VkSparseImageMemoryBind& last,
+		const VkSparseImageMemoryBind& bind,
+		uint32_t axis, uint32_t a, uint32_t b,
+		bool mergeBound) const
+	{
+		if (last.subresource.mipLevel != bind.subresource.mipLevel ||
+			last.subresource.arrayLayer != bind.subresource.arrayLayer ||
+			last.subresource.aspectMask != bind.subresource.aspectMask ||
+			last.flags != bind.flags ||
+			last.memory != bind.memory) {
+			return false;
+		}
+		if (getOffset(last, a) != getOffset(bind, a) || getExtent(last.extent, a) != getExtent(bind.extent, a) ||
+			getOffset(last, b) != getOffset(bind, b) || getExtent(last.extent, b) != getExtent(bind.extent, b)) {
+			return false;
+		}
+		if (getOffset(last, axis) + int32_t(getExtent(last.extent, axis)) != getOffset(bind, axis)) {
+			return false;
+		}
+		if (bind.memory == VK_NULL_HANDLE) {
+			return true;
+		}
+		return
+			mergeBound &&
+			this->isWholeTiles(last) &&
+			this->isWholeTiles(bind) &&
+			last.memoryOffset + this->getMemorySize(last) == bind.memoryOffset;
+	}
+
+	VkExtent3D tileExtent{ 0, 0, 0 };
+	VkDeviceSize tileSize{ 0 };		// bytes of memory per tile
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <Workload.h>
+
+#include <queue>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+
+struct FrameTiming {
+	double time{ 0.0 };				// ms spent binding in the frame, including waiting for completion
+	size_t batches{ 0 };			// vkQueueBindSparse batches submitted in the frame
+	size_t tilesBound{ 0 };			// tiles bound in the frame
+	bool budgetHit{ false };		// time was within the frame budget
+};
+
+
+// Least squares fit of batch latency = fixed + perBind * binds over the recent batches.
+// Older batches are weighted down exponentially, so the fit follows latencies that
+// change with coverage. Until batches of different sizes were seen, latency is taken
+// to be proportional to the batch size, which overestimates large batches if most of
+// the latency is fixed, and batches grow by at most a factor of two at a time, so
+// that a single cheap batch does not lead to one far over budget.
+class BindLatencyModel {
+public:
+	static constexpr double decay = 0.95;
+
+	void add(double binds, double latency)
+	{
+		this->weight = this->weight * decay + 1.0;
+		this->sumBinds = this->sumBinds * decay + binds;
+		this->sumLatency = this->sumLatency * decay + latency;
+		this->sumBinds2 = this->sumBinds2 * decay + binds * binds;
+		this->sumBindsLatency = this->sumBindsLatency * decay + binds * latency;
+		this->largestBatch = std::max(this->largestBatch, binds);
+	}
+
+	// ms per batch and ms per bind
+	std::pair<double, double> getFit() const
+	{
+		if (this->weight == 0.0) {
+			return { 0.0, 0.0 };
+		}
+		auto meanBinds = this->sumBinds / this->weight;
+		auto meanLatency = this->sumLatency / this->weight;
+		auto variance = this->sumBinds2 / this->weight - meanBinds * meanBinds;
+		if (variance <= 1e-6 * meanBinds * meanBinds) {
+			return { 0.0, meanBinds > 0.0 ? meanLatency / meanBinds : 0.0 };
+		}
+		auto perBind = std::max((this->sumBindsLatency / this->weight - meanBinds * meanLatency) / variance, 0.0);
+		return { std::max(meanLatency - perBind * meanBinds, 0.0), perBind };
+	}
+
+	double predict(double binds) const
+	{
+		auto [fixed, perBind] = this->getFit();
+		return fixed + perBind * binds;
+	}
+
+	// The largest batch predicted to complete within budget ms, 0 if none does
+	uint32_t getBatchSize(double budget, uint32_t maxBatchSize) const
+	{
+		if (this->weight == 0.0) {
+			return budget > 0.0 ? 1 : 0;
+		}
+		auto [fixed, perBind] = this->getFit();
+		auto binds = (perBind > 0.0) ? (budget - fixed) / perBind : (budget >= fixed ? double(maxBatchSize) : 0.0);
+		binds = std::min({ binds, 2.0 * this->largestBatch, double(maxBatchSize) });
+		return binds >= 1.0 ? static_cast<uint32_t>(binds) : 0;
+	}
+
+	double weight{ 0.0 };
+	double sumBinds{ 0.0 };
+	double sumLatency{ 0.0 };
+	double sumBinds2{ 0.0 };
+	double sumBindsLatency{ 0.0 };
+	double largestBatch{ 0.0 };
+};
+
+
+// Binds prioritized tile requests within a time budget per frame, the way a streaming
+// engine has to. Every frame, batches are sized by the latency model to fit into the
+// rest of the budget, and submitted until the next batch would not fit. Every frame
+// binds at least one tile, so that streaming progresses when a single bind exceeds the
+// budget; such frames count as budget misses. Requests with a higher priority are
+// bound first, those of equal priority in the order they were pushed.
+//
+// The scheduler does not bind itself: enqueue(request) queues the bind of a request
+// and returns whether it needed one, and flush() submits the queued binds and waits
+// for them to complete. The scheduler times flush() to update the latency model.
+class BindScheduler {
+public:
+	struct Request {
+		TileRequest request;
+		uint32_t priority{ 0 };
+		uint64_t sequence{ 0 };
+	};
+
+	struct Compare {
+		bool operator()(const Request& lhs, const Request& rhs) const
+		{
+			return (lhs.priority != rhs.priority) ? lhs.priority < rhs.priority : lhs.sequence > rhs.sequence;
+		}
+	};
+
+	BindScheduler(double budget, uint32_t maxBatchSize) :
+		budget(budget),
+		maxBatchSize(maxBatchSize)
+	{
+	}
+
+	void push(const TileRequest& request, uint32_t priority)
+	{
+		this->requests.push({ .request = request, .priority = priority, .sequence = this->sequence++ });
+	}
+
+	bool empty() const
+	{
+		return this->requests.empty();
+	}
+
+	template <typename Enqueue, typename Flush>
+	FrameTiming runFrame(Enqueue enqueue, Flush flush)
+	{
+		TraceScope scope("frame");
+		FrameTiming frame;
+		Timer timer;
+		while (!this->requests.empty()) {
+			auto batchSize = this->model.getBatchSize(this->budget - timer.getElapsedTimeMilliseconds(), this->maxBatchSize);
+			if (batchSize == 0) {
+				if (frame.batches > 0) {
+					break;
+				}
+				batchSize = 1;
+			}
+
+			uint32_t binds = 0;
+			while (binds < batchSize && !this->requests.empty()) {
+				auto request = this->requests.top().request;
+				this->requests.pop();
+				binds += enqueue(request) ? 1 : 0;
+			}
+
+			Timer batchTimer;
+			flush();
+			if (binds > 0) {
+				this->model.add(binds, batchTimer.getElapsedTimeMilliseconds());
+				frame.batches++;
+				frame.tilesBound += binds;
+			}
+		}
+		frame.time = timer.getElapsedTimeMilliseconds();
+		frame.budgetHit = frame.time <= this->budget;
+		return frame;
+	}
+
+	double budget{ 0.0 };			// ms per frame
+	uint32_t maxBatchSize{ 0 };
+	BindLatencyModel model;
+	std::priority_queue<Request, std::vector<Request>, Compare> requests;
+	uint64_t sequence{ 0 };
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#include <span>
+#include <vector>
+
+
+// Collects any number of VkBindSparseInfos, each with binds of any number of images
+// and buffers, for a single vkQueueBindSparse. The binds are copied into one array per
+// bind type, and the arrays are cleared but not freed after every submission, so once
+// they have grown to the largest submission, collecting binds allocates nothing.
+// Appending may move the arrays, so pointers into them are only set in submit().
+// Every bind info can wait for and signal timeline semaphore values, which are chained
+// to it in a VkTimelineSemaphoreSubmitInfo.
+class BindSparseBatch {
+public:
+	// Room for bindInfos bind infos, each with binds of all images, waiting for two
+	// semaphore values and signaling one, and for binds bind entries in all of them
+	void reserve(size_t bindInfos, size_t images, size_t binds)
+	{
+		this->bindInfos.reserve(bindInfos);
+		this->starts.reserve(bindInfos);
+		this->imageBindInfos.reserve(bindInfos * images);
+		this->imageOpaqueBindInfos.reserve(bindInfos * images);
+		this->bufferBindInfos.reserve(bindInfos);
+		this->timelineInfos.reserve(bindInfos);
+		this->waitSemaphores.reserve(2 * bindInfos);
+		this->waitValues.reserve(2 * bindInfos);
+		this->signalSemaphores.reserve(bindInfos);
+		this->signalValues.reserve(bindInfos);
+		this->firstImageBinds.reserve(bindInfos * images);
+		this->firstImageOpaqueBinds.reserve(bindInfos * images);
+		this->firstBufferBinds.reserve(bindInfos);
+		this->imageBinds.reserve(binds);
+		this->memoryBinds.reserve(binds);
+	}
+
+	// Starts the next VkBindSparseInfo, the following binds are added to it
+	void beginBindInfo()
+	{
+		this->bindInfos.push_back(VkBindSparseInfo{
+			.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreCount = 0,
+			.pWaitSemaphores = nullptr,
+			.bufferBindCount = 0,
+			.pBufferBinds = nullptr,
+			.imageOpaqueBindCount = 0,
+			.pImageOpaqueBinds = nullptr,
+			.imageBindCount = 0,
+			.pImageBinds = nullptr,
+			.signalSemaphoreCount = 0,
+			.pSignalSemaphores = nullptr,
+		});
+		this->starts.push_back({
+			.bufferBindInfo = this->bufferBindInfos.size(),
+			.imageOpaqueBindInfo = this->imageOpaqueBindInfos.size(),
+			.imageBindInfo = this->imageBindInfos.size(),
+			.waitSemaphore = this->waitSemaphores.size(),
+			.signalSemaphore = this->signalSemaphores.size(),
+		});
+		this->timelineInfos.push_back(VkTimelineSemaphoreSubmitInfo{
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreValueCount = 0,
+			.pWaitSemaphoreValues = nullptr,
+			.signalSemaphoreValueCount = 0,
+			.pSignalSemaphoreValues = nullptr,
+		});
+	}
+
+	// The binds of the bind info are executed once the timeline semaphore reaches value
+	void addWait(VkSemaphore semaphore, uint64_t value)
+	{
+		this->waitSemaphores.push_back(semaphore);
+		this->waitValues.push_back(value);
+		this->bindInfos.back().waitSemaphoreCount++;
+		this->timelineInfos.back().waitSemaphoreValueCount++;
+	}
+
+	// The timeline semaphore is set to value once the binds of the bind info completed
+	void addSignal(VkSemaphore semaphore, uint64_t value)
+	{
+		this->signalSemaphores.push_back(semaphore);
+		this->signalValues.push_back(value);
+		this->bindInfos.back().signalSemaphoreCount++;
+		this->timelineInfos.back().signalSemaphoreValueCount++;
+	}
+
+	void addImageBinds(VkImage image, std::span<const VkSparseImageMemoryBind> binds)
+	{
+		if (binds.empty()) {
+			return;
+		}
+		this->imageBindInfos.push_back({ .image = image, .bindCount = static_cast<uint32_t>(binds.size()), .pBinds = nullptr });
+		this->firstImageBinds.push_back(this->imageBinds.size());
+		this->imageBinds.insert(this->imageBinds.end(), binds.begin(), binds.end());
+		this->bindInfos.back().imageBindCount++;
+	}
+
+	void addImageOpaqueBinds(VkImage image, std::span<const VkSparseMemoryBind> binds)
+	{
+		if (binds.empty()) {
+			return;
+		}
+		this->imageOpaqueBindInfos.push_back({ .image = image, .bindCount = static_cast<uint32_t>(binds.size()), .pBinds = nullptr });
+		this->firstImageOpaqueBinds.push_back(this->memoryBinds.size());
+		this->memoryBinds.insert(this->memoryBinds.end(), binds.begin(), binds.end());
+		this->bindInfos.back().imageOpaqueBindCount++;
+	}
+
+	void addBufferBinds(VkBuffer buffer, std::span<const VkSparseMemoryBind> binds)
+	{
+		if (binds.empty()) {
+			return;
+		}
+		this->bufferBindInfos.push_back({ .buffer = buffer, .bindCount = static_cast<uint32_t>(binds.size()), .pBinds = nullptr });
+		this->firstBufferBinds.push_back(this->memoryBinds.size());
+		this->memoryBinds.insert(this->memoryBinds.end(), binds.begin(), binds.end());
+		this->bindInfos.back().bufferBindCount++;
+	}
+
+	size_t bindInfoCount() const
+	{
+		return this->bindInfos.size();
+	}
+
+	// bind entries in all bind infos
+	size_t bindCount() const
+	{
+		return this->imageBinds.size() + this->memoryBinds.size();
+	}
+
+	bool empty() const
+	{
+		return this->bindInfos.empty();
+	}
+
+	void submit(VulkanQueue& queue, VkFence fence)
+	{
+		for (size_t i = 0; i < this->imageBindInfos.size(); i++) {
+			this->imageBindInfos[i].pBinds = this->imageBinds.data() + this->firstImageBinds[i];
+		}
+		for (size_t i = 0; i < this->imageOpaqueBindInfos.size(); i++) {
+			this->imageOpaqueBindInfos[i].pBinds = this->memoryBinds.data() + this->firstImageOpaqueBinds[i];
+		}
+		for (size_t i = 0; i < this->bufferBindInfos.size(); i++) {
+			this->bufferBindInfos[i].pBinds = this->memoryBinds.data() + this->firstBufferBinds[i];
+		}
+		for (size_t i = 0; i < this->bindInfos.size(); i++) {
+			auto& bindInfo = this->bindInfos[i];
+			bindInfo.pBufferBinds = this->bufferBindInfos.data() + this->starts[i].bufferBindInfo;
+			bindInfo.pImageOpaqueBinds = this->imageOpaqueBindInfos.data() + this->starts[i].imageOpaqueBindInfo;
+			bindInfo.pImageBinds = this->imageBindInfos.data() + this->starts[i].imageBindInfo;
+
+			auto& timelineInfo = this->timelineInfos[i];
+			bindInfo.pWaitSemaphores = this->waitSemaphores.data() + this->starts[i].waitSemaphore;
+			bindInfo.pSignalSemaphores = this->signalSemaphores.data() + this->starts[i].signalSemaphore;
+			timelineInfo.pWaitSemaphoreValues = this->waitValues.data() + this->starts[i].waitSemaphore;
+			timelineInfo.pSignalSemaphoreValues = this->signalValues.data() + this->starts[i].signalSemaphore;
+			bindInfo.pNext = (bindInfo.waitSemaphoreCount + bindInfo.signalSemaphoreCount > 0) ? &timelineInfo : nullptr;
+		}
+		queue.bindSparse(this->bindInfos, fence);
+	}
+
+	void clear()
+	{
+		this->bindInfos.clear();
+		this->starts.clear();
+		this->imageBindInfos.clear();
+		this->imageOpaqueBindInfos.clear();
+		this->bufferBindInfos.clear();
+		this->timelineInfos.clear();
+		this->waitSemaphores.clear();
+		this->waitValues.clear();
+		this->signalSemaphores.clear();
+		this->signalValues.clear();
+		this->firstImageBinds.clear();
+		this->firstImageOpaqueBinds.clear();
+		this->firstBufferBinds.clear();
+		this->imageBinds.clear();
+		this->memoryBinds.clear();
+	}
+
+	// index of the first resource bind info of every type of a VkBindSparseInfo
+	struct Start {
+		size_t bufferBindInfo{ 0 };
+		size_t imageOpaqueBindInfo{ 0 };
+		size_t imageBindInfo{ 0 };
+		size_t waitSemaphore{ 0 };
+		size_t signalSemaphore{ 0 };
+	};
+
+	std::vector<VkBindSparseInfo> bindInfos;
+	std::vector<Start> starts;
+	std::vector<VkSparseImageMemoryBindInfo> imageBindInfos;
+	std::vector<VkSparseImageOpaqueMemoryBindInfo> imageOpaqueBindInfos;
+	std::vector<VkSparseBufferMemoryBindInfo> bufferBindInfos;
+	std::vector<VkTimelineSemaphoreSubmitInfo> timelineInfos;	// one per bind info
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<uint64_t> waitValues;
+	std::vector<VkSemaphore> signalSemaphores;
+	std::vector<uint64_t> signalValues;
+	std::vector<size_t> firstImageBinds;		// index in imageBinds of the binds of every image bind info
+	std::vector<size_t> firstImageOpaqueBinds;	// index in memoryBinds
+	std::vector<size_t> firstBufferBinds;		// index in memoryBinds
+	std::vector<VkSparseImageMemoryBind> imageBinds;
+	std::vector<VkSparseMemoryBind> memoryBinds;	// opaque image binds and buffer binds
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <ResidencyManager.h>
+#include <Workload.h>
+
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include <deque>
+#include <mutex>
+#include <span>
+#include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <fstream>
+#include <exception>
+#include <filesystem>
+#include <stop_token>
+#include <condition_variable>
+
+
+// Header of a bricked volume file, which holds the tiles of the mip levels of a volume
+// in the tile grid of the sparse image. The header is followed by the file offset of
+// every tile, in the order of the tile indices of a SparsePageTable, and then by the
+// tiles, coarsest level first and in Morton order within a level, so that tiles close
+// in the volume are close on disk. Every tile starts at a multiple of dataAlignment.
+struct BrickedVolumeHeader {
+	static constexpr uint32_t expectedMagic = 0x42565053;		// "SPVB"
+	static constexpr uint32_t expectedVersion = 1;
+	static constexpr uint64_t dataAlignment = 4096;
+
+	uint32_t magic{ expectedMagic };
+	uint32_t version{ expectedVersion };
+	VkExtent3D extent{ 0, 0, 0 };
+	VkExtent3D tileExtent{ 0, 0, 0 };
+	VkFormat format{ VK_FORMAT_UNDEFINED };
+	uint32_t mipLevels{ 0 };		// levels stored, those the image does not put in its mip tail
+	uint64_t tileCount{ 0 };
+	uint64_t tileSize{ 0 };			// bytes of a tile, tightly packed texels of the full tile extent
+	uint64_t dataOffset{ 0 };		// of the first tile
+
+	static uint64_t align(uint64_t offset)
+	{
+		return (offset + dataAlignment - 1) / dataAlignment * dataAlignment;
+	}
+};
+static_assert(sizeof(BrickedVolumeHeader) == 64);
+
+
+// Writes synthetic bricked volumes to test reading with
+class BrickedVolumeWriter {
+public:
+	// Pseudo random bytes seeded by the tile index, so that the drive can not compress them
+	static void fill(std::span<std::byte> tile, uint32_t index)
+	{
+		uint64_t state = index;
+		for (size_t i = 0; i < tile.size(); i += sizeof(uint64_t)) {
+			// splitmix64
+			auto z = (state += 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			z ^= z >> 31;
+			std::memcpy(tile.data() + i, &z, std::min(sizeof(z), tile.size() - i));
+		}
+	}
+
+	// Returns the header of the written volume
+	static BrickedVolumeHeader write(const std::filesystem::path& path, VkExtent3D extent, VkExtent3D tileExtent, VkFormat format, uint32_t mipLevels)
+	{
+		SparsePageTable pageTable(extent, tileExtent, mipLevels);
+		BrickedVolumeHeader header{
+			.extent = extent,
+			.tileExtent = tileExtent,
+			.format = format,
+			.mipLevels = mipLevels,
+			.tileCount = pageTable.tileCount,
+			.tileSize = getFormatInfo(format).getSize(tileExtent),
+		};
+		header.dataOffset = BrickedVolumeHeader::align(sizeof(header) + header.tileCount * sizeof(uint64_t));
+		auto stride = BrickedVolumeHeader::align(header.tileSize);
+
+		std::vector<uint64_t> offsets(header.tileCount);
+		std::vector<uint32_t> order;
+		order.reserve(header.tileCount);
+		for (auto level = mipLevels; level-- > 0;) {
+			for (auto& request : MortonWorkload().generate(pageTable.levels[level].tileGrid)) {
+				auto index = pageTable.getTileIndex({ .x = request.tile.x, .y = request.tile.y, .z = request.tile.z, .mipLevel = level });
+				offsets[index] = header.dataOffset + order.size() * stride;
+				order.push_back(index);
+			}
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			throw Exception(std::format("could not open {} for writing", path.string()));
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+		file.seekp(header.dataOffset);
+		std::vector<std::byte> tile(stride);
+		for (auto index : order) {
+			fill(tile, index);
+			file.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+		}
+		if (!file) {
+			throw Exception(std::format("could not write {}", path.string()));
+		}
+		return header;
+	}
+};
+
+
+// Serves the tiles of a bricked volume file. In mmap mode the file is mapped, and a
+// read copies the tile from the mapping right away, so that the reading thread takes
+// the page faults of the disk reads. In threads mode reads are queued for a pool of
+// threads, each reading with its own file stream, and wait() waits for them to finish.
+class BrickedVolumeReader {
+public:
+	struct Read {
+		uint64_t offset{ 0 };
+		std::byte* destination{ nullptr };
+	};
+
+	BrickedVolumeReader(const std::filesystem::path& path, VolumeReaderMode mode, uint32_t threadCount) :
+		path(path),
+		mode(mode)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			throw Exception(std::format("could not open volume {}", path.string()));
+		}
+		file.read(reinterpret_cast<char*>(&this->header), sizeof(this->header));
+		if (!file || this->header.magic != BrickedVolumeHeader::expectedMagic || this->header.version != BrickedVolumeHeader::expectedVersion) {
+			throw Exception(std::format("{} is not a bricked volume of version {}", path.string(), BrickedVolumeHeader::expectedVersion));
+		}
+		this->pageTable = std::make_unique<SparsePageTable>(this->header.extent, this->header.tileExtent, this->header.mipLevels);
+		if (this->pageTable->tileCount != this->header.tileCount) {
+			throw Exception(std::format("volume {} holds {} tiles instead of the {} of its extents", path.string(), this->header.tileCount, this->pageTable->tileCount));
+		}
+		this->offsets.resize(this->header.tileCount);
+		file.read(reinterpret_cast<char*>(this->offsets.data()), this->offsets.size() * sizeof(uint64_t));
+
+		this->fileSize = std::filesystem::file_size(path);
+		for (auto offset : this->offsets) {
+			if (!file || offset + this->header.tileSize > this->fileSize) {
+				throw Exception(std::format("volume {} is truncated", path.string()));
+			}
+		}
+
+		if (mode == VolumeReaderMode::Mmap) {
+			this->map();
+		}
+		else {
+			for (uint32_t i = 0; i < threadCount; i++) {
+				this->threads.emplace_back([this, i](std::stop_token stop) {
+					Trace::setThreadName(std::format("volume reader {}", i));
+					this->readTiles(stop);
+				});
+			}
+		}
+	}
+
+	~BrickedVolumeReader()
+	{
+		// the reader threads stop when they are destroyed, before the mapping is unmapped
+		this->threads.clear();
+		this->unmap();
+	}
+
+	void map()
+	{
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+		this->file = CreateFileW(this->path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (this->file == INVALID_HANDLE_VALUE) {
+			throw Exception(std::format("could not open volume {}", this->path.string()));
+		}
+		this->fileMapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		auto view = this->fileMapping ? MapViewOfFile(this->fileMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+		this->file = open(this->path.c_str(), O_RDONLY);
+		if (this->file < 0) {
+			throw Exception(std::format("could not open volume {}", this->path.string()));
+		}
+		auto view = mmap(nullptr, this->fileSize, PROT_READ, MAP_SHARED, this->file, 0);
+		view = (view == MAP_FAILED) ? nullptr : view;
+#endif
+		if (!view) {
+			this->unmap();
+			throw Exception(std::format("could not map volume {}", this->path.string()));
+		}
+		this->mapping = static_cast<const std::byte*>(view);
+	}
+
+	void unmap()
+	{
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+		if (this->mapping) {
+			UnmapViewOfFile(this->mapping);
+		}
+		if (this->fileMapping) {
+			CloseHandle(this->fileMapping);
+		}
+		if (this->file != INVALID_HANDLE_VALUE) {
+			CloseHandle(this->file);
+		}
+		this->fileMapping = nullptr;
+		this->file = INVALID_HANDLE_VALUE;
+#else
+		if (this->mapping) {
+			munmap(const_cast<std::byte*>(this->mapping), this->fileSize);
+		}
+		if (this->file >= 0) {
+			close(this->file);
+		}
+		this->file = -1;
+#endif
+		this->mapping = nullptr;
+	}
+
+	// Reads the header.tileSize bytes of a tile to destination
+	void read(const TileCoordinate& tile, std::byte* destination)
+	{
+		auto offset = this->offsets[this->pageTable->getTileIndex(tile)];
+		if (this->mapping) {
+			TraceScope scope("read tile", offset);
+			std::memcpy(destination, this->mapping + offset, this->header.tileSize);
+			return;
+		}
+		{
+			std::lock_guard lock(this->mutex);
+			this->reads.push_back({ .offset = offset, .destination = destination });
+			this->pending++;
+		}
+		this->requested.notify_one();
+	}
+
+	// Waits until all reads completed, and throws if one of them failed
+	void wait()
+	{
+		TraceScope scope("wait for reads");
+		std::unique_lock lock(this->mutex);
+		this->completed.wait(lock, [this]() { return this->pending == 0; });
+		if (this->error) {
+			std::rethrow_exception(std::exchange(this->error, nullptr));
+		}
+	}
+
+	void readTiles(std::stop_token stop)
+	{
+		std::ifstream file(this->path, std::ios::binary);
+		while (true) {
+			Read read;
+			{
+				std::unique_lock lock(this->mutex);
+				if (!this->requested.wait(lock, stop, [this]() { return !this->reads.empty(); })) {
+					return;
+				}
+				read = this->reads.front();
+				this->reads.pop_front();
+			}
+			{
+				TraceScope scope("read tile", read.offset);
+				file.seekg(read.offset);
+				file.read(reinterpret_cast<char*>(read.destination), this->header.tileSize);
+			}
+			{
+				std::lock_guard lock(this->mutex);
+				if (!file && !this->error) {
+					this->error = std::make_exception_ptr(Exception(std::format("could not read the tile at offset {} of {}", read.offset, this->path.string())));
+				}
+				file.clear();
+				this->pending--;
+			}
+			this->completed.notify_all();
+		}
+	}
+
+	std::filesystem::path path;
+	VolumeReaderMode mode{ VolumeReaderMode::Mmap };
+	BrickedVolumeHeader header;
+	std::unique_ptr<SparsePageTable> pageTable{ nullptr };
+	std::vector<uint64_t> offsets;			// of every tile, by tile index
+	uint64_t fileSize{ 0 };
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	HANDLE file{ INVALID_HANDLE_VALUE };
+	HANDLE fileMapping{ nullptr };
+#else
+	int file{ -1 };
+#endif
+	const std::byte* mapping{ nullptr };	// in mmap mode
+	std::mutex mutex;						// guards reads, pending and error
+	std::condition_variable_any requested;
+	std::condition_variable completed;
+	std::deque<Read> reads;					// queued for the reader threads
+	size_t pending{ 0 };					// reads queued or in progress
+	std::exception_ptr error{ nullptr };	// of the first failed read
+	std::vector<std::jthread> threads;		// in threads mode
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <BenchmarkDevice.h>
+#include <Benchmark.h>
+#include <Statistics.h>
+#include <ThreadAffinity.h>
+
+#include <latch>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+
+
+struct ContentionResult {
+	std::vector<BenchmarkResult> workers;
+	std::vector<double> baselineLatencies;	// ms per control iteration before the workers start
+	std::vector<double> controlLatencies;	// ms per control iteration while the workers bind
+	double totalTime{ 0.0 };				// ms until the last worker finished
+
+	double bindsPerSecond() const
+	{
+		size_t tilesBound = 0;
+		for (auto& worker : this->workers) {
+			tilesBound += worker.tilesBound();
+		}
+		return this->totalTime > 0.0 ? tilesBound / (this->totalTime / 1000.0) : 0.0;
+	}
+
+	// how much slower the control thread's submissions are while the workers bind
+	double latencyInflation() const
+	{
+		auto baseline = Statistics(this->baselineLatencies).mean();
+		return baseline > 0.0 ? Statistics(this->controlLatencies).mean() / baseline : 0.0;
+	}
+};
+
+
+// Runs one SparseBindBenchmark per worker thread, each with its own queue, image,
+// memory and fences. Meanwhile a control thread, which does not bind anything,
+// measures the latency of trivial vkQueueSubmit + fence wait iterations on a separate
+// queue. Comparing that latency with a baseline measured before the workers start
+// shows how much binding on other threads blocks unrelated queue operations.
+class ContentionBenchmark {
+public:
+	static constexpr size_t baselineIterations = 1000;
+
+	ContentionBenchmark(const BenchmarkDevice& benchmarkDevice, const BenchmarkParameters& parameters) :
+		controlQueue(benchmarkDevice.controlQueue)
+	{
+		if (!this->controlQueue) {
+			throw Exception("the device has no queue left for the control thread besides the sparse binding queues.");
+		}
+		for (uint32_t worker = 0; worker < parameters.threads; worker++) {
+			this->workers.push_back(std::make_unique<SparseBindBenchmark>(
+				benchmarkDevice.device,
+				benchmarkDevice.getWorkerQueue(worker),
+				parameters));
+		}
+		this->controlFence = std::make_shared<VulkanFence>(benchmarkDevice.device);
+	}
+
+	double controlIteration()
+	{
+		Timer timer;
+		this->controlQueue->submit(this->controlFence->fence);
+		this->controlFence->waitAndReset();
+		return timer.getElapsedTimeMilliseconds();
+	}
+
+	ContentionResult run()
+	{
+		ContentionResult result;
+		result.workers.resize(this->workers.size());
+
+		for (size_t i = 0; i < baselineIterations; i++) {
+			result.baselineLatencies.push_back(this->controlIteration());
+		}
+
+		std::latch start(static_cast<std::ptrdiff_t>(this->workers.size() + 1));
+		std::atomic<size_t> running(this->workers.size());
+		std::vector<std::exception_ptr> errors(this->workers.size());
+		{
+			std::vector<std::jthread> threads;
+			for (size_t worker = 0; worker < this->workers.size(); worker++) {
+				threads.emplace_back([&, worker]() {
+					Trace::setThreadName(std::format("worker {}", worker));
+					start.arrive_and_wait();
+					try {
+						auto pinCpu = this->workers[worker]->parameters.pinCpu;
+						if (pinCpu >= 0) {
+							pinThread(static_cast<uint32_t>(pinCpu) + 1 + static_cast<uint32_t>(worker));
+						}
+						result.workers[worker] = this->workers[worker]->run(false);
+					}
+					catch (...) {
+						errors[worker] = std::current_exception();
+					}
+					running--;
+				});
+			}
+
+			start.arrive_and_wait();
+			Timer timer;
+			while (running > 0) {
+				result.controlLatencies.push_back(this->controlIteration());
+			}
+			result.totalTime = timer.getElapsedTimeMilliseconds();
+		}
+
+		for (auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+		return result;
+	}
+
+	std::vector<std::unique_ptr<SparseBindBenchmark>> workers;
+	std::shared_ptr<VulkanQueue> controlQueue{ nullptr };
+	std::shared_ptr<VulkanFence> controlFence{ nullptr };
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#include <array>
+#include <cctype>
+#include <format>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <charconv>
+#include <algorithm>
+#include <string_view>
+
+
+struct VendorName {
+	const char* name;
+	uint32_t vendorID;
+};
+
+inline constexpr std::array vendorNames{
+	VendorName{ "amd", 0x1002 },
+	VendorName{ "apple", 0x106b },
+	VendorName{ "arm", 0x13b5 },
+	VendorName{ "imgtec", 0x1010 },
+	VendorName{ "intel", 0x8086 },
+	VendorName{ "nvidia", 0x10de },
+	VendorName{ "qualcomm", 0x5143 },
+	VendorName{ "mesa", 0x10005 },
+};
+
+
+// Selects physical devices by their index in the order the instance enumerates them,
+// by vendor, or by a part of their name, e.g. "1", "nvidia", "0x10de" or "RTX 4090"
+struct DeviceFilter {
+	enum class Kind {
+		Index,
+		Vendor,
+		Name,		// case insensitive part of the device name
+	};
+
+	Kind kind{ Kind::Name };
+	uint32_t value{ 0 };		// index or vendor ID
+	std::string name;
+
+	static std::string toLower(std::string_view s)
+	{
+		std::string lower(s);
+		std::ranges::transform(lower, lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return lower;
+	}
+
+	static DeviceFilter parse(std::string_view s)
+	{
+		uint32_t value = 0;
+		if (!s.empty() && std::from_chars(s.data(), s.data() + s.size(), value).ptr == s.data() + s.size()) {
+			return { .kind = Kind::Index, .value = value };
+		}
+		if (s.starts_with("0x") && std::from_chars(s.data() + 2, s.data() + s.size(), value, 16).ptr == s.data() + s.size()) {
+			return { .kind = Kind::Vendor, .value = value };
+		}
+		auto lower = toLower(s);
+		for (auto& vendor : vendorNames) {
+			if (lower == vendor.name) {
+				return { .kind = Kind::Vendor, .value = vendor.vendorID, .name = lower };
+			}
+		}
+		return { .kind = Kind::Name, .name = lower };
+	}
+
+	bool matches(const VulkanPhysicalDevice& physicalDevice, uint32_t index) const
+	{
+		switch (this->kind) {
+		case Kind::Index: return index == this->value;
+		case Kind::Vendor: return physicalDevice.physicalDeviceProperties.vendorID == this->value;
+		case Kind::Name: return toLower(physicalDevice.deviceName()).find(this->name) != std::string::npos;
+		}
+		return false;
+	}
+};
+
+// The devices matching any of the filters, all devices without filters
+inline std::vector<std::shared_ptr<VulkanPhysicalDevice>> selectDevices(
+	const std::vector<std::shared_ptr<VulkanPhysicalDevice>>& physicalDevices,
+	const std::vector<DeviceFilter>& filters)
+{
+	std::vector<std::shared_ptr<VulkanPhysicalDevice>> selected;
+	for (uint32_t index = 0; index < physicalDevices.size(); index++) {
+		if (filters.empty() || std::ranges::any_of(filters, [&](auto& filter) { return filter.matches(*physicalDevices[index], index); })) {
+			selected.push_back(physicalDevices[index]);
+		}
+	}
+	return selected;
+}
+
+
+// The queue family the sparse binding queue is taken from
+struct QueueFamilySelection {
+	enum class Preference {
+		Graphics,		// the first family with graphics and sparse binding, like the original benchmark
+		SparseOnly,		// a family with sparse binding but neither graphics nor compute, else Graphics
+		Index,			// the family with the given index
+	};
+
+	Preference preference{ Preference::Graphics };
+	uint32_t index{ 0 };
+
+	bool operator==(const QueueFamilySelection&) const = default;
+
+	std::string name() const
+	{
+		switch (this->preference) {
+		case Preference::Graphics: return "graphics";
+		case Preference::SparseOnly: return "sparse-only";
+		case Preference::Index: return std::format("{}", this->index);
+		}
+		return {};
+	}
+
+	static QueueFamilySelection parse(std::string_view s)
+	{
+		if (s == "graphics") {
+			return {};
+		}
+		if (s == "sparse-only") {
+			return { .preference = Preference::SparseOnly };
+		}
+		uint32_t index = 0;
+		if (s.empty() || std::from_chars(s.data(), s.data() + s.size(), index).ptr != s.data() + s.size()) {
+			throw Exception(std::format("expected graphics, sparse-only or a queue family index, got: {}", s));
+		}
+		return { .preference = Preference::Index, .index = index };
+	}
+
+	// The index of the selected family of the device, which has to support sparse binding
+	uint32_t select(const VulkanPhysicalDevice& physicalDevice) const
+	{
+		auto& families = physicalDevice.physicalDeviceQueueFamilyProperties;
+		if (this->preference == Preference::Index) {
+			if (this->index >= families.size() || !(families[this->index].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT)) {
+				throw Exception(std::format("queue family {} of {} does not support sparse binding.", this->index, physicalDevice.deviceName()));
+			}
+			return this->index;
+		}
+		if (this->preference == Preference::SparseOnly) {
+			for (uint32_t family = 0; family < families.size(); family++) {
+				auto flags = families[family].queueFlags;
+				if ((flags & VK_QUEUE_SPARSE_BINDING_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+					return family;
+				}
+			}
+		}
+		return physicalDevice.getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_SPARSE_BINDING_BIT);
+	}
+};
+
+
+// e.g. "GCTS" for a family with graphics, compute, transfer and sparse binding
+inline std::string getQueueFlagsName(VkQueueFlags flags)
+{
+	std::string name;
+	for (auto [bit, letter] : { std::pair(VK_QUEUE_GRAPHICS_BIT, 'G'), std::pair(VK_QUEUE_COMPUTE_BIT, 'C'),
+		std::pair(VK_QUEUE_TRANSFER_BIT, 'T'), std::pair(VK_QUEUE_SPARSE_BINDING_BIT, 'S') }) {
+		if (flags & bit) {
+			name += letter;
+		}
+	}
+	return name;
+}
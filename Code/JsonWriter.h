@@ -0,0 +1,131 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <format>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+
+// Minimal streaming JSON writer. Objects and arrays are opened and closed explicitly,
+// and separators and indentation are inserted automatically.
+class JsonWriter {
+public:
+	explicit JsonWriter(std::ostream& out) :
+		out(out)
+	{
+	}
+
+	static std::string quote(std::string_view s)
+	{
+		std::string quoted("\"");
+		for (auto c : s) {
+			switch (c) {
+			case '"': quoted += "\\\""; break;
+			case '\\': quoted += "\\\\"; break;
+			case '\n': quoted += "\\n"; break;
+			case '\r': quoted += "\\r"; break;
+			case '\t': quoted += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					quoted += std::format("\\u{:04x}", int(c));
+				}
+				else {
+					quoted += c;
+				}
+			}
+		}
+		return quoted + "\"";
+	}
+
+	void beginObject(std::string_view key = {}) { this->begin(key, '{'); }
+	void endObject() { this->end('}'); }
+	void beginArray(std::string_view key = {}) { this->begin(key, '['); }
+	void endArray() { this->end(']'); }
+
+	// An object on a single line, for the rows of long arrays
+	void beginRow()
+	{
+		this->separate({});
+		this->out << '{';
+		this->first.push_back(true);
+		this->inline_ = true;
+	}
+
+	void endRow()
+	{
+		this->first.pop_back();
+		this->out << '}';
+		this->inline_ = false;
+	}
+
+	void value(std::string_view key, std::string_view value) { this->separate(key); this->out << quote(value); }
+	void value(std::string_view key, const char* value) { this->value(key, std::string_view(value)); }
+	void value(std::string_view key, const std::string& value) { this->value(key, std::string_view(value)); }
+	void value(std::string_view key, bool value) { this->separate(key); this->out << (value ? "true" : "false"); }
+	void value(std::string_view key, double value) { this->separate(key); this->out << std::format("{}", value); }
+
+	template <typename Integer> requires std::is_integral_v<Integer>
+	void value(std::string_view key, Integer value)
+	{
+		this->separate(key);
+		this->out << value;
+	}
+
+	template <typename Value>
+	void array(std::string_view key, const std::vector<Value>& values)
+	{
+		this->separate(key);
+		this->out << '[';
+		for (size_t i = 0; i < values.size(); i++) {
+			this->out << (i ? ", " : "") << values[i];
+		}
+		this->out << ']';
+	}
+
+	void begin(std::string_view key, char bracket)
+	{
+		this->separate(key);
+		this->out << bracket;
+		this->first.push_back(true);
+	}
+
+	void end(char bracket)
+	{
+		auto empty = this->first.back();
+		this->first.pop_back();
+		if (!empty && !this->inline_) {
+			this->newline();
+		}
+		this->out << bracket;
+		if (this->first.empty()) {
+			this->out << std::endl;
+		}
+	}
+
+	void separate(std::string_view key)
+	{
+		if (!this->first.empty()) {
+			if (!this->first.back()) {
+				this->out << (this->inline_ ? ", " : ",");
+			}
+			this->first.back() = false;
+			if (!this->inline_) {
+				this->newline();
+			}
+		}
+		if (!key.empty()) {
+			this->out << quote(key) << ": ";
+		}
+	}
+
+	void newline()
+	{
+		this->out << '\n' << std::string(this->first.size(), '\t');
+	}
+
+	std::ostream& out;
+	std::vector<bool> first;	// per open object or array, whether nothing was written to it yet
+	bool inline_{ false };
+};
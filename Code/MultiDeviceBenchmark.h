@@ -0,0 +1,106 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <BenchmarkDevice.h>
+#include <Benchmark.h>
+#include <ThreadAffinity.h>
+
+#include <latch>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+
+
+struct MultiDeviceResult {
+	std::vector<BenchmarkResult> alone;			// per device, while the other devices are idle
+	std::vector<BenchmarkResult> concurrent;	// per device, while all devices bind
+	double totalTime{ 0.0 };					// ms until the last device finished
+
+	double bindsPerSecond() const
+	{
+		size_t tilesBound = 0;
+		for (auto& result : this->concurrent) {
+			tilesBound += result.tilesBound();
+		}
+		return this->totalTime > 0.0 ? tilesBound / (this->totalTime / 1000.0) : 0.0;
+	}
+
+	// how much slower binding on the device is while the other devices bind
+	double slowdown(size_t device) const
+	{
+		auto concurrent = this->concurrent[device].bindsPerSecond();
+		return concurrent > 0.0 ? this->alone[device].bindsPerSecond() / concurrent : 0.0;
+	}
+};
+
+
+// Runs the single threaded benchmark on several devices, first on every device alone
+// and then on all of them at the same time, a thread per device. A slowdown of the
+// concurrent runs shows whether binding on one device stalls the others, e.g. through
+// a lock the driver shares between its devices or through the kernel driver.
+class MultiDeviceBenchmark {
+public:
+	MultiDeviceBenchmark(const std::vector<const BenchmarkDevice*>& benchmarkDevices, const BenchmarkParameters& parameters) :
+		benchmarkDevices(benchmarkDevices)
+	{
+		for (auto benchmarkDevice : benchmarkDevices) {
+			this->benchmarks.push_back(createBenchmark(*benchmarkDevice, parameters));
+		}
+	}
+
+	static std::unique_ptr<SparseBindBenchmark> createBenchmark(const BenchmarkDevice& benchmarkDevice, const BenchmarkParameters& parameters)
+	{
+		return std::make_unique<SparseBindBenchmark>(benchmarkDevice.device, benchmarkDevice.queue, parameters,
+			benchmarkDevice.controlQueue, benchmarkDevice.transferQueue);
+	}
+
+	MultiDeviceResult run()
+	{
+		MultiDeviceResult result;
+		result.concurrent.resize(this->benchmarks.size());
+
+		// each alone run gets an image and pool of its own, so that the concurrent runs start empty
+		for (auto benchmarkDevice : this->benchmarkDevices) {
+			result.alone.push_back(createBenchmark(*benchmarkDevice, this->benchmarks.front()->parameters)->run(false));
+		}
+
+		std::latch start(static_cast<std::ptrdiff_t>(this->benchmarks.size() + 1));
+		std::vector<std::exception_ptr> errors(this->benchmarks.size());
+		{
+			std::vector<std::jthread> threads;
+			for (size_t device = 0; device < this->benchmarks.size(); device++) {
+				threads.emplace_back([&, device]() {
+					Trace::setThreadName(std::format("device {}", device));
+					start.arrive_and_wait();
+					try {
+						auto pinCpu = this->benchmarks[device]->parameters.pinCpu;
+						if (pinCpu >= 0) {
+							pinThread(static_cast<uint32_t>(pinCpu) + 1 + static_cast<uint32_t>(device));
+						}
+						result.concurrent[device] = this->benchmarks[device]->run(false);
+					}
+					catch (...) {
+						errors[device] = std::current_exception();
+					}
+				});
+			}
+
+			start.arrive_and_wait();
+			Timer timer;
+			threads.clear();
+			result.totalTime = timer.getElapsedTimeMilliseconds();
+		}
+
+		for (auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+		return result;
+	}
+
+	std::vector<const BenchmarkDevice*> benchmarkDevices;
+	std::vector<std::unique_ptr<SparseBindBenchmark>> benchmarks;	// of the concurrent run, per device
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#include <span>
+#include <memory>
+
+
+// Stands in for the rendering work of a frame that samples freshly bound tiles: a
+// command buffer filling a device local buffer, submitted after a bind and waiting
+// for the timeline value the bind signals. Every submission signals the next value
+// of the workload's own timeline semaphore.
+class OverlapWorkload {
+public:
+	static constexpr size_t baselineIterations = 16;
+
+	OverlapWorkload(
+		std::shared_ptr<VulkanDevice> device,
+		std::shared_ptr<VulkanQueue> queue,
+		VkDeviceSize size) :
+		device(std::move(device)),
+		queue(std::move(queue))
+	{
+		this->buffer = std::make_shared<VulkanBuffer>(this->device, VulkanBuffer::Config{
+			.size = size,
+			.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		});
+		this->memory = std::make_shared<VulkanMemory>(this->device,
+			this->device->getMemoryRequirements(this->buffer->buffer), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		this->buffer->bindMemory(this->memory->memory);
+
+		// submissions may overlap, so the command buffer is recorded once for simultaneous use
+		this->commandPool = std::make_shared<VulkanCommandPool>(this->device, this->queue->queueFamilyIndex);
+		this->commandBuffer = std::make_shared<VulkanCommandBuffer>(this->commandPool);
+		this->commandBuffer->begin(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+		vkCmdFillBuffer(this->commandBuffer->commandBuffer, this->buffer->buffer, 0, VK_WHOLE_SIZE, 0);
+		this->commandBuffer->end();
+
+		this->semaphore = std::make_shared<VulkanSemaphore>(this->device);
+	}
+
+	// Submits the work, waiting for waitValue of waitSemaphore unless it is VK_NULL_HANDLE,
+	// and returns the value it signals
+	uint64_t submit(VkSemaphore waitSemaphore, uint64_t waitValue)
+	{
+		auto signalValue = ++this->value;
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		VkTimelineSemaphoreSubmitInfo timelineInfo{
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreValueCount = (waitSemaphore != VK_NULL_HANDLE) ? 1u : 0u,
+			.pWaitSemaphoreValues = &waitValue,
+			.signalSemaphoreValueCount = 1,
+			.pSignalSemaphoreValues = &signalValue,
+		};
+		VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = &timelineInfo,
+			.waitSemaphoreCount = timelineInfo.waitSemaphoreValueCount,
+			.pWaitSemaphores = &waitSemaphore,
+			.pWaitDstStageMask = &waitStage,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &this->commandBuffer->commandBuffer,
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &this->semaphore->semaphore,
+		};
+		this->queue->submit(std::span(&submitInfo, 1));
+		return signalValue;
+	}
+
+	// waits for all submitted work
+	void wait()
+	{
+		this->semaphore->wait(this->value);
+	}
+
+	// Mean ms from submission to completion of the work alone, on an idle queue
+	double measure()
+	{
+		double total = 0.0;
+		for (size_t i = 0; i < baselineIterations; i++) {
+			Timer timer;
+			this->submit(VK_NULL_HANDLE, 0);
+			this->wait();
+			total += timer.getElapsedTimeMilliseconds();
+		}
+		return total / baselineIterations;
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	std::shared_ptr<VulkanQueue> queue{ nullptr };
+	std::shared_ptr<VulkanBuffer> buffer{ nullptr };
+	std::shared_ptr<VulkanMemory> memory{ nullptr };
+	std::shared_ptr<VulkanCommandPool> commandPool{ nullptr };
+	std::shared_ptr<VulkanCommandBuffer> commandBuffer{ nullptr };
+	std::shared_ptr<VulkanSemaphore> semaphore{ nullptr };
+	uint64_t value{ 0 };		// the last value signaled by a submission
+};
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <Statistics.h>
+
+#include <map>
+#include <chrono>
+#include <limits>
+#include <cstdlib>
+#include <algorithm>
+#include <format>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <string_view>
+
+
+// Milliseconds since the epoch. Unlike steady_clock this is comparable between processes.
+inline double getWallClockMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+
+// Start barrier for benchmark child processes. Every child creates the file
+// "ready-<generation>-<child>" in the shared directory and waits until all childCount
+// children have done so, which releases them to start binding at the same time. A child
+// that fails creates the file "abort", which makes the others fail at their next barrier
+// instead of waiting for it until the timeout.
+class ProcessBarrier {
+public:
+	static constexpr std::chrono::seconds timeout{ 300 };
+
+	ProcessBarrier(std::filesystem::path directory, uint32_t child, uint32_t childCount) :
+		directory(std::move(directory)),
+		child(child),
+		childCount(childCount)
+	{
+	}
+
+	void arriveAndWait()
+	{
+		auto generation = this->generation++;
+		std::ofstream(this->directory / std::format("ready-{}-{}", generation, this->child));
+
+		Timer timer;
+		for (uint32_t other = 0; other < this->childCount;) {
+			if (std::filesystem::exists(this->directory / std::format("ready-{}-{}", generation, other))) {
+				other++;
+				continue;
+			}
+			if (std::filesystem::exists(this->directory / "abort")) {
+				throw Exception("ProcessBarrier: another child process failed");
+			}
+			if (timer.getElapsedTimeSeconds() > timeout.count()) {
+				throw Exception(std::format("ProcessBarrier: timed out waiting for child process {}", other));
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+
+	void abort()
+	{
+		std::ofstream(this->directory / "abort");
+	}
+
+	// Result files of this child are written to the shared directory, prefixed with the child index
+	std::filesystem::path getResultPath(const std::filesystem::path& filename) const
+	{
+		return this->directory / std::format("child{} {}", this->child, filename.filename().string());
+	}
+
+	// tiles bound, start and end time (wall clock ms) of the run whose result path is resultPath, read back by the coordinator
+	void writeSummary(const std::filesystem::path& resultPath, size_t tilesBound, double startTime, double endTime) const
+	{
+		auto path = resultPath;
+		path.replace_extension(".summary");
+		std::ofstream file(path);
+		file << std::format("{} {:.3f} {:.3f}", tilesBound, startTime, endTime) << std::endl;
+	}
+
+	std::filesystem::path directory;
+	uint32_t child;
+	uint32_t childCount;
+	uint32_t generation{ 0 };
+};
+
+
+// Runs the benchmark in several processes at once. The coordinator starts N copies
+// of this executable with the same options, which synchronize on a ProcessBarrier
+// before every run and write their results to a shared directory. The coordinator
+// then merges the results of each run into one report with per-process and
+// aggregate throughput.
+class ProcessCoordinator {
+public:
+	ProcessCoordinator(int argc, const char* argv[], std::vector<uint32_t> processCounts) :
+		processCounts(std::move(processCounts))
+	{
+		this->executable = std::filesystem::absolute(argv[0]).string();
+		for (int i = 1; i < argc; i++) {
+			std::string_view arg(argv[i]);
+			// the children get every option except --processes
+			if (arg == "--processes") {
+				i++;
+				continue;
+			}
+			if (arg.starts_with("--processes=")) {
+				continue;
+			}
+			this->arguments.emplace_back(arg);
+		}
+	}
+
+	static std::string quote(std::string_view arg)
+	{
+		std::string quoted("\"");
+		for (auto c : arg) {
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+			if (c == '"') {
+#else
+			if (c == '"' || c == '\\' || c == '$' || c == '`') {
+#endif
+				quoted += '\\';
+			}
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	int run()
+	{
+		int exitCode = EXIT_SUCCESS;
+		for (auto processCount : this->processCounts) {
+			if (processCount == 0) {
+				exitCode = this->runBaseline() ? exitCode : EXIT_FAILURE;
+				continue;
+			}
+			std::mt19937_64 random(std::random_device{}());
+			auto directory = std::filesystem::temp_directory_path() / std::format("SparseTexture-{:x}", random());
+			std::filesystem::create_directories(directory);
+
+			std::cout << std::format("Starting {} benchmark processes", processCount) << std::endl;
+			std::vector<int> exitCodes(processCount);
+			{
+				std::vector<std::jthread> processes;
+				for (uint32_t child = 0; child < processCount; child++) {
+					auto command = this->getCommand();
+					command += std::format(" --child {} --child-count {} --child-directory {}",
+						child, processCount, quote(directory.string()));
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+					// cmd.exe strips the outer quotes of the command line
+					command = quote(command);
+#endif
+					processes.emplace_back([&exitCodes, child, command]() {
+						exitCodes[child] = std::system(command.c_str());
+					});
+				}
+			}
+
+			for (uint32_t child = 0; child < processCount; child++) {
+				if (exitCodes[child] != 0) {
+					std::cerr << std::format("Child process {} failed with exit code {}", child, exitCodes[child]) << std::endl;
+					exitCode = EXIT_FAILURE;
+				}
+			}
+			this->merge(directory, processCount);
+			std::filesystem::remove_all(directory);
+		}
+		return exitCode;
+	}
+
+	// runs the benchmark in a single process of its own, without the barrier, and keeps its result files
+	bool runBaseline() const
+	{
+		std::cout << "Starting the benchmark in a single process" << std::endl;
+		auto command = this->getCommand();
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+		command = quote(command);
+#endif
+		auto exitCode = std::system(command.c_str());
+		if (exitCode != 0) {
+			std::cerr << std::format("Process failed with exit code {}", exitCode) << std::endl;
+		}
+		return exitCode == 0;
+	}
+
+	std::string getCommand() const
+	{
+		auto command = quote(this->executable);
+		for (auto& argument : this->arguments) {
+			command += " " + quote(argument);
+		}
+		return command;
+	}
+
+	struct ChildResult {
+		std::string header;
+		std::vector<double> bindTimes;
+		size_t tilesBound{ 0 };
+		double startTime{ 0.0 };
+		double endTime{ 0.0 };
+
+		double bindsPerSecond() const
+		{
+			auto duration = this->endTime - this->startTime;
+			return duration > 0.0 ? this->tilesBound / (duration / 1000.0) : 0.0;
+		}
+	};
+
+	// Groups the child result files by name and writes one "<name> processesN.txt" report per group
+	void merge(const std::filesystem::path& directory, uint32_t processCount)
+	{
+		std::map<std::string, std::map<uint32_t, ChildResult>> runs;
+		for (auto& entry : std::filesystem::directory_iterator(directory)) {
+			auto filename = entry.path().filename().string();
+			if (!filename.starts_with("child") || entry.path().extension() != ".txt") {
+				continue;
+			}
+			auto space = filename.find(' ');
+			auto child = static_cast<uint32_t>(std::stoul(filename.substr(5, space - 5)));
+			auto name = filename.substr(space + 1);
+
+			ChildResult result;
+			std::ifstream file(entry.path());
+			std::getline(file, result.header);
+			double value;
+			while (file >> value) {
+				result.bindTimes.push_back(value);
+			}
+
+			// only the main result file of a run has a summary
+			auto summaryPath = entry.path();
+			summaryPath.replace_extension(".summary");
+			if (!std::filesystem::exists(summaryPath)) {
+				continue;
+			}
+			std::ifstream summary(summaryPath);
+			summary >> result.tilesBound >> result.startTime >> result.endTime;
+
+			runs[name][child] = std::move(result);
+		}
+
+		for (auto& [name, children] : runs) {
+			std::filesystem::path filename(name);
+			filename.replace_filename(std::format("{} processes{}.txt", filename.stem().string(), processCount));
+
+			double startTime = std::numeric_limits<double>::max();
+			double endTime = 0.0;
+			size_t tilesBound = 0;
+			size_t batchCount = 0;
+			for (auto& [child, result] : children) {
+				startTime = std::min(startTime, result.startTime);
+				endTime = std::max(endTime, result.endTime);
+				tilesBound += result.tilesBound;
+				batchCount = std::max(batchCount, result.bindTimes.size());
+			}
+			auto aggregate = (endTime > startTime) ? tilesBound / ((endTime - startTime) / 1000.0) : 0.0;
+
+			std::ofstream file(filename);
+			file << std::format("{} ({} processes)", children.begin()->second.header, processCount) << std::endl;
+			for (auto& [child, result] : children) {
+				Statistics statistics(result.bindTimes);
+				auto line = std::format("process {}: {:.0f} binds/s, mean {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms",
+					child, result.bindsPerSecond(), statistics.mean(), statistics.percentile(99.0), statistics.max());
+				file << line << std::endl;
+				std::cout << line << std::endl;
+			}
+			auto line = std::format("aggregate: {:.0f} binds/s", aggregate);
+			file << line << std::endl;
+			std::cout << line << std::endl;
+
+			// per-batch timings, one column per process
+			file << "batch";
+			for (auto& [child, result] : children) {
+				file << "\tprocess" << child;
+			}
+			file << std::endl;
+			for (size_t batch = 0; batch < batchCount; batch++) {
+				file << batch;
+				for (auto& [child, result] : children) {
+					file << "\t";
+					if (batch < result.bindTimes.size()) {
+						file << result.bindTimes[batch];
+					}
+				}
+				file << std::endl;
+			}
+			std::cout << "Wrote merged results to: " << filename << std::endl << std::endl;
+		}
+	}
+
+	std::vector<uint32_t> processCounts;
+	std::string executable;
+	std::vector<std::string> arguments;
+};
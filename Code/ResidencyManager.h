@@ -0,0 +1,446 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <TilePool.h>
+
+#include <bit>
+#include <limits>
+#include <optional>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+
+struct TileCoordinate {
+	uint32_t x{ 0 };		// in tiles
+	uint32_t y{ 0 };
+	uint32_t z{ 0 };
+	uint32_t mipLevel{ 0 };
+};
+
+
+// The bind of a tile of an image, clipped to its mip level, since tiles at the edge of
+// a level, or in levels smaller than a tile, may be partial. In a layered image, a 2D
+// array, the depth of the extent counts the array layers, and z is the layer of the tile,
+// so its tiles are one layer deep. Extents are in texels, and the sparse granularity
+// of a block-compressed format is in texels too, so its tiles hold more texels in the
+// same memory.
+inline VkSparseImageMemoryBind getTileBind(
+	VkExtent3D imageExtent,
+	VkExtent3D tileExtent,
+	const TileCoordinate& tile,
+	VkDeviceMemory memory,
+	VkDeviceSize memoryOffset,
+	bool layered = false)
+{
+	VkExtent3D levelExtent{
+		std::max(imageExtent.width >> tile.mipLevel, 1u),
+		std::max(imageExtent.height >> tile.mipLevel, 1u),
+		layered ? 1u : std::max(imageExtent.depth >> tile.mipLevel, 1u),
+	};
+	VkOffset3D offset{
+		int32_t(tile.x * tileExtent.width),
+		int32_t(tile.y * tileExtent.height),
+		layered ? 0 : int32_t(tile.z * tileExtent.depth),
+	};
+	return VkSparseImageMemoryBind{
+		.subresource = VkImageSubresource{
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipLevel = tile.mipLevel,
+			.arrayLayer = layered ? tile.z : 0,
+		},
+		.offset = offset,
+		.extent = VkExtent3D{
+			std::min(tileExtent.width, levelExtent.width - uint32_t(offset.x)),
+			std::min(tileExtent.height, levelExtent.height - uint32_t(offset.y)),
+			std::min(tileExtent.depth, levelExtent.depth - uint32_t(offset.z)),
+		},
+		.memory = memory,
+		.memoryOffset = memoryOffset,
+		.flags = 0,
+	};
+}
+
+
+// Residency bitmap over the tile grid of the mip levels of a sparse image before the
+// mip tail, which is bound as a whole and not tracked. Tiles of all levels are numbered
+// consecutively, level 0 first, x fastest. A second bitmap with one bit per 64 bit word
+// of the first one marks the words with any resident tile, so that walking the resident
+// tiles of a mostly empty image is cheap.
+class SparsePageTable {
+public:
+	struct Level {
+		VkExtent3D tileGrid{ 0, 0, 0 };		// tiles per dimension
+		uint32_t firstTile{ 0 };			// index of the first tile of the level
+	};
+
+	// mipLevels is imageMipTailFirstLod of the image's sparse memory requirements. The
+	// depth of a layered image counts array layers, which the mip levels do not halve.
+	SparsePageTable(VkExtent3D imageExtent, VkExtent3D tileExtent, uint32_t mipLevels, bool layered = false)
+	{
+		for (uint32_t mipLevel = 0; mipLevel < mipLevels; mipLevel++) {
+			VkExtent3D levelExtent{
+				std::max(imageExtent.width >> mipLevel, 1u),
+				std::max(imageExtent.height >> mipLevel, 1u),
+				layered ? imageExtent.depth : std::max(imageExtent.depth >> mipLevel, 1u),
+			};
+			Level level{
+				.tileGrid = {
+					(levelExtent.width + tileExtent.width - 1) / tileExtent.width,
+					(levelExtent.height + tileExtent.height - 1) / tileExtent.height,
+					(levelExtent.depth + tileExtent.depth - 1) / tileExtent.depth,
+				},
+				.firstTile = this->tileCount,
+			};
+			this->tileCount += level.tileGrid.width * level.tileGrid.height * level.tileGrid.depth;
+			this->levels.push_back(level);
+		}
+		this->words.resize((this->tileCount + 63) / 64, 0);
+		this->summary.resize((this->words.size() + 63) / 64, 0);
+	}
+
+	uint32_t getTileIndex(const TileCoordinate& tile) const
+	{
+		auto& level = this->levels[tile.mipLevel];
+		return level.firstTile + (tile.z * level.tileGrid.height + tile.y) * level.tileGrid.width + tile.x;
+	}
+
+	TileCoordinate getTileCoordinate(uint32_t index) const
+	{
+		uint32_t mipLevel = 0;
+		while (mipLevel + 1 < this->levels.size() && index >= this->levels[mipLevel + 1].firstTile) {
+			mipLevel++;
+		}
+		auto& level = this->levels[mipLevel];
+		index -= level.firstTile;
+		return {
+			.x = index % level.tileGrid.width,
+			.y = (index / level.tileGrid.width) % level.tileGrid.height,
+			.z = index / (level.tileGrid.width * level.tileGrid.height),
+			.mipLevel = mipLevel,
+		};
+	}
+
+	bool isResident(uint32_t index) const
+	{
+		return (this->words[index / 64] >> (index % 64)) & 1;
+	}
+
+	void setResident(uint32_t index, bool resident)
+	{
+		auto& word = this->words[index / 64];
+		auto bit = uint64_t(1) << (index % 64);
+		if (resident == bool(word & bit)) {
+			return;
+		}
+		word ^= bit;
+		this->residentCount += resident ? 1 : -1;
+
+		auto wordIndex = index / 64;
+		auto summaryBit = uint64_t(1) << (wordIndex % 64);
+		if (word) {
+			this->summary[wordIndex / 64] |= summaryBit;
+		}
+		else {
+			this->summary[wordIndex / 64] &= ~summaryBit;
+		}
+	}
+
+	// Calls function(index) for every resident tile in increasing order
+	template <typename Function>
+	void forEachResident(Function function) const
+	{
+		for (size_t s = 0; s < this->summary.size(); s++) {
+			for (auto summaryWord = this->summary[s]; summaryWord; summaryWord &= summaryWord - 1) {
+				auto wordIndex = s * 64 + std::countr_zero(summaryWord);
+				for (auto word = this->words[wordIndex]; word; word &= word - 1) {
+					function(static_cast<uint32_t>(wordIndex * 64 + std::countr_zero(word)));
+				}
+			}
+		}
+	}
+
+	std::vector<Level> levels;
+	uint32_t tileCount{ 0 };
+	uint32_t residentCount{ 0 };
+	std::vector<uint64_t> words;		// one residency bit per tile
+	std::vector<uint64_t> summary;		// one bit per non-zero word
+};
+
+
+// Keeps tiles of a sparse image resident in the pages of a TilePool. Requested tiles
+// are bound to a free page; when the pool is full, the least recently used tile is
+// evicted first, i.e. unbound (memory = VK_NULL_HANDLE) and its page reused. Binds
+// and unbinds are collected in one list and submitted together by the caller, which
+// calls flush() once they are submitted.
+//
+// The LRU order is a doubly linked list threaded through per-tile index arrays, so
+// request, release and evict are O(1). The bind list has room for batchSize binds,
+// each evicting a tile, so queuing a batch of them allocates nothing.
+//
+// With a null page, uniform tiles are bound to that one shared page instead of a page
+// of their own, and stay resident and evictable like other tiles. The null page is
+// read-only: promote() rebinds a null tile to a private page before it is written.
+//
+// To compact the pool, move() rebinds the tiles on pages of blocks the pool retired to
+// free pages of other blocks. Only the binds are queued, the contents of the tiles
+// would have to be copied to their new page in between, which is left out here.
+class ResidencyManager {
+public:
+	static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+	static constexpr uint32_t shared = none - 1;	// page of tiles bound to the null page
+
+	ResidencyManager(
+		std::shared_ptr<TilePool> tilePool,
+		VkExtent3D imageExtent,
+		VkExtent3D tileExtent,
+		uint32_t mipLevels,
+		size_t batchSize,
+		bool layered = false) :
+		tilePool(std::move(tilePool)),
+		imageExtent(imageExtent),
+		tileExtent(tileExtent),
+		layered(layered),
+		pageTable(imageExtent, tileExtent, mipLevels, layered)
+	{
+		auto tileCount = this->pageTable.tileCount;
+		this->pages.resize(tileCount, none);
+		this->previous.resize(tileCount, none);
+		this->next.resize(tileCount, none);
+		this->lastUse.resize(tileCount, 0);
+		this->lastRelease.resize(tileCount, 0);
+		this->binds.reserve(2 * batchSize);
+		this->requestBinds.reserve(batchSize);
+	}
+
+	// Makes the tile resident, or marks it as most recently used if it already is.
+	// A uniform tile is bound to the null page, if there is one. Returns true if a
+	// bind was queued.
+	bool request(uint32_t tile, bool uniform = false)
+	{
+		this->lastUse[tile] = ++this->useCounter;
+		if (this->pageTable.isResident(tile)) {
+			this->unlink(tile);
+			this->pushFront(tile);
+			return false;
+		}
+
+		if (uniform && this->nullPage) {
+			this->pages[tile] = shared;
+			this->sharedCount++;
+			this->pageTable.setResident(tile, true);
+			this->pushFront(tile);
+			this->pushBind(tile, this->nullPage->memory, this->nullPage->offset);
+			this->requestBinds.push_back(this->binds.size() - 1);
+			this->bindCount++;
+			return true;
+		}
+
+		auto page = this->allocatePage();
+		this->pages[tile] = page.id;
+		this->pageTable.setResident(tile, true);
+		this->pushFront(tile);
+		this->pushBind(tile, page.memory, page.offset);
+		this->requestBinds.push_back(this->binds.size() - 1);
+		this->bindCount++;
+		return true;
+	}
+
+	// Rebinds a tile bound to the null page to a private page, so that it can be
+	// written, and marks it as most recently used. The tile has to be flushed since it
+	// was bound, the order of binds to the same region within one vkQueueBindSparse is
+	// undefined. Returns true if a bind was queued.
+	bool promote(uint32_t tile)
+	{
+		if (!this->pageTable.isResident(tile) || this->pages[tile] != shared) {
+			return false;
+		}
+		this->lastUse[tile] = ++this->useCounter;
+		this->unlink(tile);
+		this->pushFront(tile);
+		auto page = this->allocatePage();
+		this->pages[tile] = page.id;
+		this->sharedCount--;
+		this->pushBind(tile, page.memory, page.offset);
+		this->bindCount++;
+		this->promoteCount++;
+		this->promotionCount++;
+		return true;
+	}
+
+	// The resident tiles on pages of retired blocks of the pool, which have to be moved
+	// before those blocks can be released
+	std::vector<uint32_t> getRetiredTiles() const
+	{
+		std::vector<uint32_t> tiles;
+		this->pageTable.forEachResident([&](uint32_t tile) {
+			if (this->pages[tile] != shared && this->tilePool->isRetired(this->pages[tile])) {
+				tiles.push_back(tile);
+			}
+		});
+		return tiles;
+	}
+
+	// Rebinds a resident tile to a free page of a block that is not retired, and returns
+	// its old page to the pool. The tile keeps its place in the LRU order. The tile has to
+	// be flushed since it was bound, like for promote(). Returns true if a bind was queued,
+	// false if the tile is not on a page of its own or the pool has no free page left.
+	bool move(uint32_t tile)
+	{
+		if (!this->pageTable.isResident(tile) || this->pages[tile] == shared) {
+			return false;
+		}
+		auto page = this->tilePool->allocate();
+		if (!page) {
+			return false;
+		}
+		this->tilePool->free(this->tilePool->getPage(this->pages[tile]));
+		this->pages[tile] = page->id;
+		this->pushBind(tile, page->memory, page->offset);
+		this->bindCount++;
+		this->moveCount++;
+		return true;
+	}
+
+	// The block of the pool holding the null page, which compaction must not retire
+	uint32_t getNullPageBlock() const
+	{
+		return this->nullPage ? this->nullPage->id / this->tilePool->pagesPerBlock : TilePool::none;
+	}
+
+	// A free page, evicting least recently used tiles until the pool has one. Evicting
+	// a tile bound to the null page frees none.
+	TilePage allocatePage()
+	{
+		auto page = this->tilePool->allocate();
+		while (!page) {
+			this->evict();
+			page = this->tilePool->allocate();
+		}
+		return *page;
+	}
+
+	// Unbinds the tile and returns its page to the pool
+	void release(uint32_t tile)
+	{
+		if (!this->pageTable.isResident(tile)) {
+			return;
+		}
+		TraceScope scope("unbind tile", tile);
+		this->unlink(tile);
+		if (this->pages[tile] == shared) {
+			this->sharedCount--;
+		}
+		else {
+			this->tilePool->free(this->tilePool->getPage(this->pages[tile]));
+		}
+		this->pages[tile] = none;
+		this->pageTable.setResident(tile, false);
+		this->pushBind(tile, VK_NULL_HANDLE, 0);
+		this->unbindCount++;
+		this->lastRelease[tile] = ++this->useCounter;
+	}
+
+	// The tile was requested since the last flush
+	bool isPending(uint32_t tile) const
+	{
+		return this->lastUse[tile] > this->flushedUse;
+	}
+
+	// The tile was released or evicted since the last flush, so requesting it again
+	// would queue its bind in the same submission as its unbind
+	bool isReleasePending(uint32_t tile) const
+	{
+		return this->lastRelease[tile] > this->flushedUse;
+	}
+
+	// Releases the least recently used tile
+	void evict()
+	{
+		if (this->tail == none) {
+			throw Exception("ResidencyManager: nothing to evict, the memory pool is empty.");
+		}
+		// a tile bound since the last flush must not be unbound in the same submission,
+		// the order of binds to the same region within one vkQueueBindSparse is undefined
+		if (this->isPending(this->tail)) {
+			throw Exception("ResidencyManager: the memory pool holds fewer tiles than a batch.");
+		}
+		this->release(this->tail);
+	}
+
+	// Clears the queued binds after they were submitted
+	void flush()
+	{
+		this->binds.clear();
+		this->requestBinds.clear();
+		this->bindCount = 0;
+		this->unbindCount = 0;
+		this->promoteCount = 0;
+		this->moveCount = 0;
+		this->flushedUse = this->useCounter;
+	}
+
+	void pushBind(uint32_t tile, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+	{
+		auto coordinate = this->pageTable.getTileCoordinate(tile);
+		this->binds.push_back(getTileBind(this->imageExtent, this->tileExtent, coordinate, memory, memoryOffset, this->layered));
+	}
+
+	void pushFront(uint32_t tile)
+	{
+		this->previous[tile] = none;
+		this->next[tile] = this->head;
+		if (this->head != none) {
+			this->previous[this->head] = tile;
+		}
+		this->head = tile;
+		if (this->tail == none) {
+			this->tail = tile;
+		}
+	}
+
+	void unlink(uint32_t tile)
+	{
+		if (this->previous[tile] != none) {
+			this->next[this->previous[tile]] = this->next[tile];
+		}
+		else {
+			this->head = this->next[tile];
+		}
+		if (this->next[tile] != none) {
+			this->previous[this->next[tile]] = this->previous[tile];
+		}
+		else {
+			this->tail = this->previous[tile];
+		}
+		this->previous[tile] = none;
+		this->next[tile] = none;
+	}
+
+	std::shared_ptr<TilePool> tilePool{ nullptr };
+	VkExtent3D imageExtent{ 0, 0, 0 };
+	VkExtent3D tileExtent{ 0, 0, 0 };
+	bool layered{ false };				// a 2D array, with a layer per depth slice of the extent
+	SparsePageTable pageTable;
+
+	std::vector<VkSparseImageMemoryBind> binds;	// queued binds and unbinds
+	std::vector<size_t> requestBinds;			// indices in binds of the binds of requested tiles, not promoted or moved ones
+	size_t bindCount{ 0 };						// queued binds, excluding unbinds
+	size_t unbindCount{ 0 };
+	size_t promoteCount{ 0 };					// queued rebinds of null tiles, included in bindCount
+	size_t moveCount{ 0 };						// queued rebinds of compaction, included in bindCount
+
+	std::optional<TilePage> nullPage;	// shared by uniform tiles, none to give every tile its own page
+	uint32_t sharedCount{ 0 };			// resident tiles bound to the null page
+	size_t promotionCount{ 0 };			// null tiles rebound to a private page
+
+	std::vector<uint32_t> pages;		// page id per resident tile, shared for the null page
+	std::vector<uint32_t> previous;		// LRU list, head is the most recently used tile
+	std::vector<uint32_t> next;
+	std::vector<uint64_t> lastUse;		// value of useCounter at the last request per tile
+	std::vector<uint64_t> lastRelease;	// value of useCounter at the last release per tile
+	uint32_t head{ none };
+	uint32_t tail{ none };
+	uint64_t useCounter{ 0 };
+	uint64_t flushedUse{ 0 };
+};
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <Benchmark.h>
+#include <Statistics.h>
+#include <JsonWriter.h>
+
+#include <span>
+#include <vector>
+#include <format>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <string_view>
+
+
+// Everything about a run that is not in its BenchmarkResult
+struct RunDescription {
+	std::shared_ptr<VulkanPhysicalDevice> physicalDevice;
+	BenchmarkParameters parameters;
+	VkExtent3D imageExtent{ 0, 0, 0 };			// after clamping to the maximum supported extent
+	VkImageFormatProperties imageFormatProperties{};
+	VkSparseImageMemoryRequirements sparseMemoryRequirements{};	// of the color aspect
+	std::string label;							// e.g. "worker 0" in contention runs
+};
+
+
+// Writes a BenchmarkResult with per-batch rows, summary statistics, the run
+// configuration and the device limits as JSON or CSV, as an alternative to the
+// plain text result files with one completion time per line.
+class ResultWriter {
+public:
+	static constexpr size_t histogramBins = 32;
+	static constexpr std::array percentiles{ 50.0, 90.0, 99.0, 99.9 };
+	static constexpr size_t coverageBucketCount = 10;
+
+	struct CoverageBucket {
+		double from{ 0.0 };		// coverage in percent
+		double to{ 0.0 };
+		Statistics completion;
+	};
+
+	static std::vector<double> getCompletionTimes(const BenchmarkResult& result)
+	{
+		std::vector<double> times;
+		for (auto& batch : result.batches) {
+			times.push_back(batch.completionTime);
+		}
+		return times;
+	}
+
+	static std::vector<double> getSubmitTimes(const BenchmarkResult& result)
+	{
+		std::vector<double> times;
+		for (auto& batch : result.batches) {
+			times.push_back(batch.submitTime);
+		}
+		return times;
+	}
+
+	static std::vector<uint32_t> getExtent(const VkExtent3D& extent)
+	{
+		return { extent.width, extent.height, extent.depth };
+	}
+
+	// percentage of the tiles of the image resident after the batch
+	static double getCoverage(const BenchmarkResult& result, const BatchTiming& batch)
+	{
+		return result.tileCount ? 100.0 * (batch.tilesBound - batch.tilesUnbound) / result.tileCount : 0.0;
+	}
+
+	// The completion times of the batches of all results, in coverageBucketCount equally
+	// wide ranges of coverage, so that repetitions are compared at the same coverage.
+	// perImage buckets by the coverage of the image a batch bound last instead of all images.
+	static std::vector<CoverageBucket> getCoverageBuckets(std::span<const BenchmarkResult> results, bool perImage = false)
+	{
+		std::vector<std::vector<double>> times(coverageBucketCount);
+		for (auto& result : results) {
+			for (auto& batch : result.batches) {
+				auto coverage = perImage ? batch.imageCoverage : getCoverage(result, batch);
+				auto bucket = static_cast<size_t>(coverage / 100.0 * coverageBucketCount);
+				times[std::min(bucket, coverageBucketCount - 1)].push_back(batch.completionTime);
+			}
+		}
+		std::vector<CoverageBucket> buckets;
+		for (size_t bucket = 0; bucket < coverageBucketCount; bucket++) {
+			buckets.push_back({
+				.from = 100.0 * bucket / coverageBucketCount,
+				.to = 100.0 * (bucket + 1) / coverageBucketCount,
+				.completion = Statistics(std::move(times[bucket])),
+			});
+		}
+		return buckets;
+	}
+
+	static void writeCoverageBuckets(JsonWriter& json, std::string_view key, std::span<const BenchmarkResult> results, bool perImage = false)
+	{
+		json.beginArray(key);
+		for (auto& bucket : getCoverageBuckets(results, perImage)) {
+			json.beginRow();
+			json.value("from", bucket.from);
+			json.value("to", bucket.to);
+			json.value("count", bucket.completion.count());
+			json.value("mean", bucket.completion.mean());
+			json.value("confidenceInterval95", bucket.completion.confidenceInterval95());
+			json.value("median", bucket.completion.median());
+			json.value("outliers", bucket.completion.outliers());
+			json.endRow();
+		}
+		json.endArray();
+	}
+
+	static void writeStatistics(JsonWriter& json, std::string_view key, const Statistics& statistics)
+	{
+		json.beginObject(key);
+		json.value("min", statistics.min());
+		json.value("mean", statistics.mean());
+		json.value("standardDeviation", statistics.standardDeviation());
+		for (auto p : percentiles) {
+			json.value(std::format("p{}", p), statistics.percentile(p));
+		}
+		json.value("max", statistics.max());
+		json.value("confidenceInterval95", statistics.confidenceInterval95());
+		json.value("outliers", statistics.outliers());
+		json.endObject();
+	}
+
+	static void writeJson(const std::filesystem::path& filename, const RunDescription& run, const BenchmarkResult& result)
+	{
+		std::ofstream file(filename);
+		if (!file.is_open()) {
+			throw Exception(std::format("could not open {} for writing", filename.string()));
+		}
+		auto& physicalDevice = *run.physicalDevice;
+		auto& properties = physicalDevice.physicalDeviceProperties;
+		auto& parameters = run.parameters;
+
+		JsonWriter json(file);
+		json.beginObject();
+		json.value("label", run.label);
+
+		json.beginObject("device");
+		json.value("name", physicalDevice.deviceName());
+		json.value("driverVersion", physicalDevice.driverVersion());
+		json.value("vendorID", properties.vendorID);
+		json.value("deviceID", properties.deviceID);
+		json.value("apiVersion", std::format("{}.{}.{}",
+			VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion), VK_API_VERSION_PATCH(properties.apiVersion)));
+		json.beginObject("limits");
+		json.value("sparseAddressSpaceSize", properties.limits.sparseAddressSpaceSize);
+		json.value("maxImageDimension3D", properties.limits.maxImageDimension3D);
+		json.value("maxMemoryAllocationCount", properties.limits.maxMemoryAllocationCount);
+		json.value("bufferImageGranularity", properties.limits.bufferImageGranularity);
+		json.endObject();
+		json.beginObject("sparseProperties");
+		json.value("residencyStandard2DBlockShape", bool(properties.sparseProperties.residencyStandard2DBlockShape));
+		json.value("residencyStandard3DBlockShape", bool(properties.sparseProperties.residencyStandard3DBlockShape));
+		json.value("residencyAlignedMipSize", bool(properties.sparseProperties.residencyAlignedMipSize));
+		json.value("residencyNonResidentStrict", bool(properties.sparseProperties.residencyNonResidentStrict));
+		json.endObject();
+		json.array("imageMaxExtent", getExtent(run.imageFormatProperties.maxExtent));
+		json.endObject();
+
+		json.beginObject("configuration");
+		json.array("extent", getExtent(parameters.imageExtent));
+		json.array("imageExtent", getExtent(run.imageExtent));
+		json.array("tile", getExtent(parameters.tileExtent));
+		json.value("batch", parameters.batchSize);
+		json.value("bindInfos", parameters.bindInfos);
+		json.value("format", getFormatName(parameters.format));
+		json.value("imageType", getImageTypeName(parameters.imageType));
+		json.value("resource", getResourceTypeName(parameters.resource));
+		json.value("images", parameters.images);
+		json.value("imageOrder", getImageOrderName(parameters.imageOrder));
+		json.value("poolSize", parameters.memoryPoolSize);
+		json.value("blockSize", parameters.memoryBlockSize);
+		json.value("memoryBudget", parameters.memoryBudget);
+		json.value("elasticPool", parameters.elasticPool);
+		json.value("compactThreshold", parameters.compactThreshold);
+		json.value("mode", getBindModeName(parameters.bindMode));
+		json.value("inFlight", parameters.inFlight);
+		json.value("residency", getResidencyModeName(parameters.residencyMode));
+		json.value("pattern", getAccessPatternName(parameters.pattern));
+		json.value("nullTiles", parameters.nullTiles);
+		json.value("nullWrites", parameters.nullWrites);
+		json.value("coalesce", parameters.coalesce);
+		json.value("mipChain", parameters.mipChain);
+		json.value("frameBudget", parameters.frameBudget);
+		json.value("timeline", parameters.timeline);
+		json.value("overlap", getOverlapModeName(parameters.overlap));
+		json.value("overlapWork", parameters.overlapWorkSize);
+		json.value("upload", parameters.upload);
+		json.value("stagingSize", parameters.stagingSize);
+		json.value("volume", parameters.volume.string());
+		json.value("volumeReader", getVolumeReaderModeName(parameters.volumeReader));
+		json.value("ioThreads", parameters.ioThreads);
+		json.value("threads", parameters.threads);
+		json.value("queueFamily", parameters.queueFamily.name());
+		json.array("granularity", getExtent(run.sparseMemoryRequirements.formatProperties.imageGranularity));
+		json.value("mipTailFirstLod", run.sparseMemoryRequirements.imageMipTailFirstLod);
+		json.value("mipTailSize", run.sparseMemoryRequirements.imageMipTailSize);
+		json.endObject();
+
+		Statistics completion(getCompletionTimes(result));
+		json.beginObject("summary");
+		json.value("batches", result.batches.size());
+		json.value("tileCount", result.tileCount);
+		json.value("tilesBound", result.tilesBound());
+		json.value("tilesUnbound", result.tilesUnbound());
+		json.value("totalTime", result.totalTime);
+		json.value("bindsPerSecond", result.bindsPerSecond());
+		json.value("churnBindsPerSecond", result.churnBindsPerSecond());
+		json.value("bytesPerBind", result.tileSize);
+		json.value("texelsPerBind", result.tileTexels);
+		json.value("bytesPerSecond", result.bytesPerSecond());
+		json.value("texelsPerSecond", result.texelsPerSecond());
+		if (!result.frames.empty()) {
+			json.value("frames", result.frames.size());
+			json.value("budgetHitRate", result.budgetHitRate());
+			json.value("tilesPerFrame", result.tilesPerFrame());
+		}
+		if (parameters.overlap != OverlapMode::None) {
+			json.value("workTime", result.workTime);
+			json.value("serialization", result.serialization());
+		}
+		json.value("poolLimit", result.poolLimit);
+		json.value("peakPoolSize", result.peakPoolSize);
+		if (parameters.elasticPool || parameters.compactThreshold > 0.0) {
+			json.value("blocksAllocated", result.blocksAllocated);
+			json.value("blocksReleased", result.blocksReleased);
+			json.value("allocationFailures", result.allocationFailures);
+		}
+		if (parameters.compactThreshold > 0.0) {
+			json.value("compactions", result.compactions.size());
+			json.value("tilesMoved", result.tilesMoved());
+			json.value("compactionTime", result.compactionTime());
+			json.value("compactionBytesReleased", result.compactionBytesReleased());
+		}
+		if (parameters.nullTiles > 0.0) {
+			json.value("nullTilesResident", result.nullTilesResident);
+			json.value("promotions", result.promotions);
+			json.value("nullMemorySaved", result.nullMemorySaved());
+		}
+		if (parameters.upload) {
+			json.value("uploadedTiles", result.tileLatencies.size());
+			json.value("uploadMegabytesPerSecond", result.uploadMegabytesPerSecond());
+			writeStatistics(json, "tileLatency", Statistics(result.tileLatencies));
+			if (!parameters.volume.empty()) {
+				json.value("readTime", result.readTime);
+			}
+		}
+		writeStatistics(json, "completionTime", completion);
+		writeStatistics(json, "submitTime", Statistics(getSubmitTimes(result)));
+		json.beginObject("histogram");
+		json.value("min", completion.min());
+		json.value("max", completion.max());
+		json.array("counts", completion.histogram(histogramBins));
+		json.endObject();
+		writeCoverageBuckets(json, "coverageBuckets", std::span(&result, 1));
+		if (parameters.images > 1) {
+			writeCoverageBuckets(json, "imageCoverageBuckets", std::span(&result, 1), true);
+		}
+		json.endObject();
+
+		json.beginArray("batches");
+		for (size_t i = 0; i < result.batches.size(); i++) {
+			auto& batch = result.batches[i];
+			json.beginRow();
+			json.value("batch", i);
+			json.value("tilesBound", batch.tilesBound);
+			json.value("tilesUnbound", batch.tilesUnbound);
+			json.value("coverage", getCoverage(result, batch));
+			json.value("imageCoverage", batch.imageCoverage);
+			json.value("bindEntries", batch.bindEntries);
+			json.value("submitTime", batch.submitTime);
+			json.value("completionTime", batch.completionTime);
+			if (parameters.overlap != OverlapMode::None) {
+				json.value("afterWork", batch.afterWork);
+			}
+			if (parameters.compactThreshold > 0.0) {
+				json.value("compaction", batch.compaction);
+			}
+			json.endRow();
+		}
+		json.endArray();
+
+		if (!result.frames.empty()) {
+			json.beginArray("frames");
+			for (size_t i = 0; i < result.frames.size(); i++) {
+				auto& frame = result.frames[i];
+				json.beginRow();
+				json.value("frame", i);
+				json.value("time", frame.time);
+				json.value("batches", frame.batches);
+				json.value("tilesBound", frame.tilesBound);
+				json.value("budgetHit", frame.budgetHit);
+				json.endRow();
+			}
+			json.endArray();
+		}
+
+		if (!result.compactions.empty()) {
+			json.beginArray("compactions");
+			for (auto& compaction : result.compactions) {
+				json.beginRow();
+				json.value("time", compaction.time);
+				json.value("tilesMoved", compaction.tilesMoved);
+				json.value("blocksReleased", compaction.blocksReleased);
+				json.value("bytesReleased", compaction.bytesReleased);
+				json.value("fragmentationBefore", compaction.fragmentationBefore);
+				json.value("fragmentationAfter", compaction.fragmentationAfter);
+				json.endRow();
+			}
+			json.endArray();
+		}
+		json.endObject();
+	}
+
+	// One row per batch. The configuration and summary come first as '#' comment lines.
+	static void writeCsv(const std::filesystem::path& filename, const RunDescription& run, const BenchmarkResult& result)
+	{
+		std::ofstream file(filename);
+		if (!file.is_open()) {
+			throw Exception(std::format("could not open {} for writing", filename.string()));
+		}
+		auto& physicalDevice = *run.physicalDevice;
+		auto& limits = physicalDevice.physicalDeviceProperties.limits;
+
+		file << std::format("# device: {}, Driver version: {}", physicalDevice.deviceName(), physicalDevice.driverVersion()) << std::endl;
+		if (!run.label.empty()) {
+			file << "# label: " << run.label << std::endl;
+		}
+		file << std::format("# parameters: {}", run.parameters.name()) << std::endl;
+		file << std::format("# image extent: {}x{}x{}", run.imageExtent.width, run.imageExtent.height, run.imageExtent.depth) << std::endl;
+		file << std::format("# sparse address space: {}, max image dimension 3D: {}", limits.sparseAddressSpaceSize, limits.maxImageDimension3D) << std::endl;
+
+		Statistics completion(getCompletionTimes(result));
+		file << std::format("# tiles: {} bound, {} unbound, {} in image; {:.0f} binds/s",
+			result.tilesBound(), result.tilesUnbound(), result.tileCount, result.bindsPerSecond()) << std::endl;
+		file << std::format("# per tile bind: {} bytes, {} texels; {:.0f} bytes/s, {:.0f} texels/s",
+			result.tileSize, result.tileTexels, result.bytesPerSecond(), result.texelsPerSecond()) << std::endl;
+		file << std::format("# completion time ms: min {} p50 {} p90 {} p99 {} p99.9 {} max {}",
+			completion.min(), completion.percentile(50.0), completion.percentile(90.0),
+			completion.percentile(99.0), completion.percentile(99.9), completion.max()) << std::endl;
+		for (auto& bucket : getCoverageBuckets(std::span(&result, 1))) {
+			file << std::format("# coverage {}-{}%: {} batches, mean {} ms +- {} (95% CI), median {}, {} outliers",
+				bucket.from, bucket.to, bucket.completion.count(), bucket.completion.mean(),
+				bucket.completion.confidenceInterval95(), bucket.completion.median(), bucket.completion.outliers()) << std::endl;
+		}
+
+		if (!result.compactions.empty()) {
+			file << std::format("# compactions: {}, {} tiles moved in {} ms, {} bytes released",
+				result.compactions.size(), result.tilesMoved(), result.compactionTime(), result.compactionBytesReleased()) << std::endl;
+		}
+
+		file << "batch,tilesBound,tilesUnbound,coverage,imageCoverage,bindEntries,submitTime,completionTime,compaction" << std::endl;
+		for (size_t i = 0; i < result.batches.size(); i++) {
+			auto& batch = result.batches[i];
+			file << std::format("{},{},{},{},{},{},{},{},{}",
+				i, batch.tilesBound, batch.tilesUnbound, getCoverage(result, batch), batch.imageCoverage,
+				batch.bindEntries, batch.submitTime, batch.completionTime, int(batch.compaction)) << std::endl;
+		}
+	}
+
+	// The original format: a header line, then one value per line
+	static void writeText(const std::filesystem::path& filename, const std::string& header, const std::vector<double>& values)
+	{
+		std::ofstream file(filename);
+		if (file.is_open()) {
+			file << header << std::endl;
+			for (auto& value : values) {
+				file << value << std::endl;
+			}
+		}
+	}
+
+	// The completion times of repeated runs per coverage bucket, and the mean throughput of the runs
+	static void writeRepetitions(const std::filesystem::path& filename, const std::string& header, std::span<const BenchmarkResult> results)
+	{
+		std::ofstream file(filename);
+		if (!file.is_open()) {
+			throw Exception(std::format("could not open {} for writing", filename.string()));
+		}
+		std::vector<double> throughputs;
+		for (auto& result : results) {
+			throughputs.push_back(result.bindsPerSecond());
+		}
+		Statistics throughput(throughputs);
+		file << header << std::endl;
+		file << std::format("# repetitions: {}, binds/s mean {:.0f} +- {:.0f} (95% CI), {} outliers",
+			results.size(), throughput.mean(), throughput.confidenceInterval95(), throughput.outliers()) << std::endl;
+		file << "coverageFrom,coverageTo,batches,mean,confidenceInterval95,median,outliers" << std::endl;
+		for (auto& bucket : getCoverageBuckets(results)) {
+			file << std::format("{},{},{},{},{},{},{}", bucket.from, bucket.to, bucket.completion.count(), bucket.completion.mean(),
+				bucket.completion.confidenceInterval95(), bucket.completion.median(), bucket.completion.outliers()) << std::endl;
+		}
+	}
+
+	// Writes the result in every requested format, filename with the extension of the format
+	static void write(
+		const std::filesystem::path& filename,
+		const std::vector<OutputFormat>& formats,
+		const std::string& header,
+		const RunDescription& run,
+		const BenchmarkResult& result)
+	{
+		for (auto format : formats) {
+			auto path = filename;
+			switch (format) {
+			case OutputFormat::Text:
+				writeText(path.replace_extension(".txt"), header, getCompletionTimes(result));
+				break;
+			case OutputFormat::Json:
+				writeJson(path.replace_extension(".json"), run, result);
+				break;
+			case OutputFormat::Csv:
+				writeCsv(path.replace_extension(".csv"), run, result);
+				break;
+			}
+			std::cout << " Wrote results to: " << path << std::endl;
+		}
+	}
+};
@@ -0,0 +1,1335 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+
+#include <bit>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <string>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <string_view>
+
+
+// A Vulkan driver without a GPU, so that the benchmarks run on machines without one
+// and the allocation, residency and scheduling code can be tested deterministically.
+// It takes the place of the Vulkan loader through volkInitializeCustom, and the rest of
+// the program calls it through the usual volk function pointers. The instance has one
+// physical device per configured latency model.
+//
+// Sparse binds are validated against the standard sparse block shapes and the bound
+// memory, and residency is tracked per 64 KiB block. A vkQueueBindSparse costs
+//   bindLatency + entryLatency * bind entries (+ residentLatency * resident blocks of the device)
+// where the last term is only part of the linear model. In the constant and linear
+// models this time is put on the queue's timeline, so the call returns at once and the
+// fence signals when the queue gets to the end of it. In the global lock model it is
+// spent inside vkQueueBindSparse while holding a lock that all queues of all devices
+// share, and that vkQueueSubmit also takes, like a driver that serializes binds.
+//
+// A queue executes its submissions one after the other, so work submitted to the same
+// queue as binds delays them, while work on other queues does not. A submission costs
+// submitLatency plus the time of its fill and copy commands at transferRate. Submissions
+// and binds start once the timeline semaphore values they wait for are reached, and
+// signal their values at their completion. Binary semaphores are not simulated.
+class SimulatedDriver {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr VkDeviceSize blockSize = 65536;	// bytes per sparse block
+	static constexpr uint32_t maxMemoryAllocationCount = 4096;
+	static constexpr uint32_t maxImageDimension = 16384;
+	static constexpr uint32_t maxImageArrayLayers = 2048;
+	static constexpr std::array deviceExtensions{ VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME };
+
+	struct PhysicalDevice {
+		LatencyModel latencyModel{ LatencyModel::Constant };
+		VkPhysicalDeviceProperties properties{};
+		std::vector<VkQueueFamilyProperties> queueFamilies;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		std::array<std::atomic<VkDeviceSize>, VK_MAX_MEMORY_HEAPS> heapUsage{};	// of all devices, for the memory budget
+	};
+
+	struct Instance {
+		std::vector<std::unique_ptr<PhysicalDevice>> physicalDevices;
+	};
+
+	struct Device;
+
+	struct Queue {
+		Device* device{ nullptr };
+		uint32_t queueFamilyIndex{ 0 };
+		uint32_t queueIndex{ 0 };
+		std::mutex mutex;
+		Clock::time_point busyUntil{};		// end of the last submission on the queue's timeline
+	};
+
+	struct Device {
+		PhysicalDevice* physicalDevice{ nullptr };
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::mutex mutex;					// guards the memory and address space accounting
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapUsage{};
+		uint32_t allocationCount{ 0 };
+		VkDeviceSize sparseAddressSpaceUsage{ 0 };
+		std::atomic<int64_t> residentBlocks{ 0 };
+	};
+
+	struct Fence {
+		static constexpr Clock::rep unsignaled = std::numeric_limits<Clock::rep>::max();
+		std::atomic<Clock::rep> signalTime{ unsignaled };		// since the clock's epoch, unsignaled if never submitted
+	};
+
+	// Values signaled by submissions are kept with their signal time until that has passed
+	struct Semaphore {
+		std::mutex mutex;
+		uint64_t value{ 0 };		// the value reached, as of the last update
+		std::vector<std::pair<uint64_t, Clock::rep>> pending;	// values and signal times not reached yet
+
+		void update(Clock::rep now)
+		{
+			std::erase_if(this->pending, [&](auto& signal) {
+				if (signal.second > now) {
+					return false;
+				}
+				this->value = std::max(this->value, signal.first);
+				return true;
+			});
+		}
+
+		// the time value is reached, Fence::unsignaled if no submission signals it
+		Clock::rep getSignalTime(uint64_t value)
+		{
+			std::lock_guard lock(this->mutex);
+			this->update(Clock::now().time_since_epoch().count());
+			if (this->value >= value) {
+				return 0;
+			}
+			auto time = Fence::unsignaled;
+			for (auto& [signalValue, signalTime] : this->pending) {
+				if (signalValue >= value) {
+					time = std::min(time, signalTime);
+				}
+			}
+			return time;
+		}
+
+		void signal(uint64_t value, Clock::time_point time)
+		{
+			std::lock_guard lock(this->mutex);
+			this->pending.emplace_back(value, time.time_since_epoch().count());
+		}
+	};
+
+	struct CommandBuffer {
+		double microseconds{ 0.0 };		// execution time of the recorded commands
+	};
+
+	struct CommandPool {
+		std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+	};
+
+	struct Memory {
+		VkDeviceSize size{ 0 };
+		uint32_t memoryTypeIndex{ 0 };
+		std::vector<std::byte> data;		// of host visible memory, allocated when first mapped
+	};
+
+	struct ImageLevel {
+		VkExtent3D extent;
+		VkExtent3D blocks;					// sparse blocks in each dimension, partial blocks at the edges included
+		size_t firstBlock;					// within the array layer
+	};
+
+	// Image memory holds, for every array layer, the blocks of every level before the
+	// mip tail in x, y, z order, followed by the mip tail.
+	struct Image {
+		VkImageCreateInfo createInfo{};
+		VkExtent3D granularity{};
+		uint32_t mipTailFirstLod{ 0 };
+		std::vector<ImageLevel> levels;		// the levels before the mip tail
+		size_t mipTailBlocks{ 0 };
+		size_t layerBlocks{ 0 };
+		VkDeviceSize size{ 0 };
+		std::mutex mutex;
+		std::vector<bool> resident;			// one per block of sparse images
+	};
+
+	struct Buffer {
+		VkBufferCreateInfo createInfo{};
+		std::mutex mutex;
+		std::vector<bool> resident;			// one per block of sparse buffers
+	};
+
+	static void install(const SimulationConfig& config)
+	{
+		SimulatedDriver::config = config;
+		volkInitializeCustom(&SimulatedDriver::getInstanceProcAddr);
+	}
+
+	// The Vulkan standard sparse image block shapes, each 64 KiB, in texels. The shapes of
+	// block-compressed formats are those of their block size, in blocks of texels.
+	static VkExtent3D getStandardBlockShape(VkImageType imageType, const FormatInfo& formatInfo)
+	{
+		auto is3D = (imageType == VK_IMAGE_TYPE_3D);
+		auto shape = [&]() {
+			switch (formatInfo.texelSize) {
+			case 1: return is3D ? VkExtent3D{ 64, 32, 32 } : VkExtent3D{ 256, 256, 1 };
+			case 2: return is3D ? VkExtent3D{ 32, 32, 32 } : VkExtent3D{ 256, 128, 1 };
+			case 4: return is3D ? VkExtent3D{ 32, 32, 16 } : VkExtent3D{ 128, 128, 1 };
+			case 8: return is3D ? VkExtent3D{ 32, 16, 16 } : VkExtent3D{ 128, 64, 1 };
+			case 16: return is3D ? VkExtent3D{ 16, 16, 16 } : VkExtent3D{ 64, 64, 1 };
+			}
+			throw Exception(std::format("no standard sparse block shape for {} byte texels", formatInfo.texelSize));
+		}();
+		return { shape.width * formatInfo.blockWidth, shape.height * formatInfo.blockHeight, shape.depth };
+	}
+
+	template <typename T>
+	static T divideRoundingUp(T value, T divisor)
+	{
+		return (value + divisor - 1) / divisor;
+	}
+
+	template <typename Object, typename Handle>
+	static Object* get(Handle handle)
+	{
+		return reinterpret_cast<Object*>(handle);
+	}
+
+	template <typename Handle, typename Object>
+	static Handle toHandle(Object* object)
+	{
+		return reinterpret_cast<Handle>(object);
+	}
+
+	// Invalid usage, which a real driver might not report at all
+	static VkResult fail(std::string_view message)
+	{
+		std::cerr << "Simulated driver: " << message << std::endl;
+		return VK_ERROR_VALIDATION_FAILED_EXT;
+	}
+
+	// Sleeps most of the time, and spins for the rest, because sleeps overshoot by tens of microseconds
+	static void waitUntil(Clock::time_point time)
+	{
+		constexpr auto spin = std::chrono::microseconds(100);
+		if (time - Clock::now() > spin) {
+			std::this_thread::sleep_until(time - spin);
+		}
+		while (Clock::now() < time) {
+			std::this_thread::yield();
+		}
+	}
+
+	// Spends the time on the queue's timeline, or, in the global lock model, in the calling
+	// thread, starting no earlier than start, and returns the time of completion
+	static Clock::time_point execute(Queue& queue, double microseconds, VkFence fence, Clock::time_point start = {})
+	{
+		auto duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(microseconds));
+		Clock::time_point completion;
+		if (queue.device->physicalDevice->latencyModel == LatencyModel::GlobalLock) {
+			std::lock_guard lock(globalLock);
+			completion = std::max(Clock::now(), start) + duration;
+			waitUntil(completion);
+		}
+		else {
+			std::lock_guard lock(queue.mutex);
+			completion = std::max({ Clock::now(), queue.busyUntil, start }) + duration;
+			queue.busyUntil = completion;
+		}
+		if (fence != VK_NULL_HANDLE) {
+			get<Fence>(fence)->signalTime = completion.time_since_epoch().count();
+		}
+		return completion;
+	}
+
+	// Waits until signalTime, or returns VK_TIMEOUT if that is more than timeout ns away
+	static VkResult waitForSignal(Clock::rep signalTime, uint64_t timeout)
+	{
+		constexpr uint64_t forever = uint64_t(365) * 24 * 3600 * 1000000000;
+		if (signalTime == Fence::unsignaled) {
+			if (timeout >= forever) {
+				return fail("waiting without timeout for a fence or semaphore value that was never submitted");
+			}
+			waitUntil(Clock::now() + std::chrono::nanoseconds(timeout));
+			return VK_TIMEOUT;
+		}
+		auto time = Clock::time_point(Clock::duration(signalTime));
+		if (timeout < forever && time > Clock::now() + std::chrono::nanoseconds(timeout)) {
+			waitUntil(Clock::now() + std::chrono::nanoseconds(timeout));
+			return VK_TIMEOUT;
+		}
+		waitUntil(time);
+		return VK_SUCCESS;
+	}
+
+	static const VkTimelineSemaphoreSubmitInfo* getTimelineSemaphoreSubmitInfo(const void* pNext)
+	{
+		for (auto next = static_cast<const VkBaseInStructure*>(pNext); next; next = next->pNext) {
+			if (next->sType == VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO) {
+				return reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(next);
+			}
+		}
+		return nullptr;
+	}
+
+	// The time the semaphore waits of a submission are satisfied, as the start of execute()
+	static VkResult getWaitTime(const void* pNext, uint32_t count, const VkSemaphore* pSemaphores, Clock::time_point& start)
+	{
+		if (count == 0) {
+			return VK_SUCCESS;
+		}
+		auto timelineInfo = getTimelineSemaphoreSubmitInfo(pNext);
+		if (!timelineInfo || timelineInfo->waitSemaphoreValueCount != count) {
+			return fail("semaphore waits need a VkTimelineSemaphoreSubmitInfo with a value per semaphore");
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			auto signalTime = get<Semaphore>(pSemaphores[i])->getSignalTime(timelineInfo->pWaitSemaphoreValues[i]);
+			if (signalTime == Fence::unsignaled) {
+				return fail("waiting for a semaphore value before the submission signaling it is not simulated");
+			}
+			start = std::max(start, Clock::time_point(Clock::duration(signalTime)));
+		}
+		return VK_SUCCESS;
+	}
+
+	static VkResult checkSignals(const void* pNext, uint32_t count)
+	{
+		auto timelineInfo = getTimelineSemaphoreSubmitInfo(pNext);
+		if (count > 0 && (!timelineInfo || timelineInfo->signalSemaphoreValueCount != count)) {
+			return fail("semaphore signals need a VkTimelineSemaphoreSubmitInfo with a value per semaphore");
+		}
+		return VK_SUCCESS;
+	}
+
+	static void signal(const void* pNext, uint32_t count, const VkSemaphore* pSemaphores, Clock::time_point time)
+	{
+		for (uint32_t i = 0; i < count; i++) {
+			get<Semaphore>(pSemaphores[i])->signal(getTimelineSemaphoreSubmitInfo(pNext)->pSignalSemaphoreValues[i], time);
+		}
+	}
+
+	// instance
+
+	static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL getInstanceProcAddr(VkInstance, const char* pName)
+	{
+		for (auto& [name, function] : functions) {
+			if (name == pName) {
+				return function;
+			}
+		}
+		return nullptr;
+	}
+
+	static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL getDeviceProcAddr(VkDevice, const char* pName)
+	{
+		return getInstanceProcAddr(VK_NULL_HANDLE, pName);
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL enumerateInstanceVersion(uint32_t* pApiVersion)
+	{
+		*pApiVersion = VK_API_VERSION_1_3;
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createInstance(const VkInstanceCreateInfo*, const VkAllocationCallbacks*, VkInstance* pInstance)
+	{
+		auto instance = new Instance;
+		for (uint32_t i = 0; i < config.latencyModels.size(); i++) {
+			auto physicalDevice = std::make_unique<PhysicalDevice>();
+			physicalDevice->latencyModel = config.latencyModels[i];
+
+			auto& properties = physicalDevice->properties;
+			properties.apiVersion = VK_API_VERSION_1_3;
+			properties.driverVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);
+			properties.vendorID = 0;
+			properties.deviceID = i;
+			properties.deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+			auto name = std::format("Simulated {} sparse device", getLatencyModelName(config.latencyModels[i]));
+			name.copy(properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+
+			auto& limits = properties.limits;
+			limits.maxImageDimension1D = maxImageDimension;
+			limits.maxImageDimension2D = maxImageDimension;
+			limits.maxImageDimension3D = maxImageDimension;
+			limits.maxImageArrayLayers = maxImageArrayLayers;
+			limits.maxMemoryAllocationCount = maxMemoryAllocationCount;
+			limits.bufferImageGranularity = 1;
+			limits.sparseAddressSpaceSize = config.sparseAddressSpaceSize;
+			limits.optimalBufferCopyOffsetAlignment = 1;
+			limits.optimalBufferCopyRowPitchAlignment = 1;
+			limits.nonCoherentAtomSize = 1;
+
+			auto& sparseProperties = properties.sparseProperties;
+			sparseProperties.residencyStandard2DBlockShape = VK_TRUE;
+			sparseProperties.residencyStandard3DBlockShape = VK_TRUE;
+			sparseProperties.residencyAlignedMipSize = VK_FALSE;
+			sparseProperties.residencyNonResidentStrict = VK_TRUE;
+
+			// a universal family, and a transfer family that can also bind, like most discrete GPUs have
+			physicalDevice->queueFamilies = {
+				VkQueueFamilyProperties{
+					.queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT,
+					.queueCount = 4,
+					.timestampValidBits = 64,
+					.minImageTransferGranularity = { 1, 1, 1 },
+				},
+				VkQueueFamilyProperties{
+					.queueFlags = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT,
+					.queueCount = 2,
+					.timestampValidBits = 64,
+					.minImageTransferGranularity = { 1, 1, 1 },
+				},
+			};
+
+			auto& memoryProperties = physicalDevice->memoryProperties;
+			memoryProperties.memoryHeapCount = 2;
+			memoryProperties.memoryHeaps[0] = { .size = config.memorySize, .flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+			memoryProperties.memoryHeaps[1] = { .size = config.memorySize, .flags = 0 };
+			memoryProperties.memoryTypeCount = 2;
+			memoryProperties.memoryTypes[0] = { .propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, .heapIndex = 0 };
+			memoryProperties.memoryTypes[1] = { .propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, .heapIndex = 1 };
+
+			instance->physicalDevices.push_back(std::move(physicalDevice));
+		}
+		*pInstance = toHandle<VkInstance>(instance);
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroyInstance(VkInstance instance, const VkAllocationCallbacks*)
+	{
+		delete get<Instance>(instance);
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL enumeratePhysicalDevices(VkInstance instance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices)
+	{
+		auto& physicalDevices = get<Instance>(instance)->physicalDevices;
+		if (!pPhysicalDevices) {
+			*pPhysicalDeviceCount = static_cast<uint32_t>(physicalDevices.size());
+			return VK_SUCCESS;
+		}
+		auto count = std::min<uint32_t>(*pPhysicalDeviceCount, static_cast<uint32_t>(physicalDevices.size()));
+		for (uint32_t i = 0; i < count; i++) {
+			pPhysicalDevices[i] = toHandle<VkPhysicalDevice>(physicalDevices[i].get());
+		}
+		*pPhysicalDeviceCount = count;
+		return count < physicalDevices.size() ? VK_INCOMPLETE : VK_SUCCESS;
+	}
+
+	// physical device
+
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures* pFeatures)
+	{
+		*pFeatures = VkPhysicalDeviceFeatures{
+			.textureCompressionBC = VK_TRUE,
+			.sparseBinding = VK_TRUE,
+			.sparseResidencyBuffer = VK_TRUE,
+			.sparseResidencyImage2D = VK_TRUE,
+			.sparseResidencyImage3D = VK_TRUE,
+			.sparseResidencyAliased = VK_TRUE,
+		};
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2* pFeatures)
+	{
+		getPhysicalDeviceFeatures(physicalDevice, &pFeatures->features);
+		for (auto next = static_cast<VkBaseOutStructure*>(pFeatures->pNext); next; next = next->pNext) {
+			if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES) {
+				reinterpret_cast<VkPhysicalDeviceVulkan12Features*>(next)->timelineSemaphore = VK_TRUE;
+			}
+		}
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties)
+	{
+		*pProperties = get<PhysicalDevice>(physicalDevice)->properties;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties)
+	{
+		auto& queueFamilies = get<PhysicalDevice>(physicalDevice)->queueFamilies;
+		if (!pQueueFamilyProperties) {
+			*pQueueFamilyPropertyCount = static_cast<uint32_t>(queueFamilies.size());
+			return;
+		}
+		*pQueueFamilyPropertyCount = std::min<uint32_t>(*pQueueFamilyPropertyCount, static_cast<uint32_t>(queueFamilies.size()));
+		std::copy_n(queueFamilies.begin(), *pQueueFamilyPropertyCount, pQueueFamilyProperties);
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties)
+	{
+		*pMemoryProperties = get<PhysicalDevice>(physicalDevice)->memoryProperties;
+	}
+
+	// The budget of the device local heap leaves out the memory other processes use
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2* pMemoryProperties)
+	{
+		auto& simulatedPhysicalDevice = *get<PhysicalDevice>(physicalDevice);
+		pMemoryProperties->memoryProperties = simulatedPhysicalDevice.memoryProperties;
+		for (auto next = static_cast<VkBaseOutStructure*>(pMemoryProperties->pNext); next; next = next->pNext) {
+			if (next->sType != VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT) {
+				continue;
+			}
+			auto& budgetProperties = *reinterpret_cast<VkPhysicalDeviceMemoryBudgetPropertiesEXT*>(next);
+			for (uint32_t heap = 0; heap < simulatedPhysicalDevice.memoryProperties.memoryHeapCount; heap++) {
+				budgetProperties.heapBudget[heap] = getHeapLimit(simulatedPhysicalDevice, heap);
+				budgetProperties.heapUsage[heap] = simulatedPhysicalDevice.heapUsage[heap];
+			}
+		}
+	}
+
+	// bytes of the heap the process can allocate
+	static VkDeviceSize getHeapLimit(const PhysicalDevice& physicalDevice, uint32_t heapIndex)
+	{
+		auto& heap = physicalDevice.memoryProperties.memoryHeaps[heapIndex];
+		auto usedElsewhere = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? config.memoryUsedElsewhere : 0;
+		return heap.size > usedElsewhere ? heap.size - usedElsewhere : 0;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL getPhysicalDeviceImageFormatProperties(
+		VkPhysicalDevice physicalDevice,
+		VkFormat format,
+		VkImageType type,
+		VkImageTiling tiling,
+		VkImageUsageFlags,
+		VkImageCreateFlags flags,
+		VkImageFormatProperties* pImageFormatProperties)
+	{
+		auto supported = std::any_of(formatInfos.begin(), formatInfos.end(), [format](auto& formatInfo) { return formatInfo.format == format; });
+		auto sparse = (flags & (VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT)) != 0;
+		if (!supported || (sparse && (type == VK_IMAGE_TYPE_1D || tiling != VK_IMAGE_TILING_OPTIMAL))) {
+			return VK_ERROR_FORMAT_NOT_SUPPORTED;
+		}
+		auto& limits = get<PhysicalDevice>(physicalDevice)->properties.limits;
+		*pImageFormatProperties = VkImageFormatProperties{
+			.maxExtent = {
+				type == VK_IMAGE_TYPE_3D ? limits.maxImageDimension3D : limits.maxImageDimension2D,
+				type == VK_IMAGE_TYPE_1D ? 1 : (type == VK_IMAGE_TYPE_3D ? limits.maxImageDimension3D : limits.maxImageDimension2D),
+				type == VK_IMAGE_TYPE_3D ? limits.maxImageDimension3D : 1,
+			},
+			.maxMipLevels = static_cast<uint32_t>(std::bit_width(maxImageDimension)),
+			.maxArrayLayers = type == VK_IMAGE_TYPE_3D ? 1 : limits.maxImageArrayLayers,
+			.sampleCounts = VK_SAMPLE_COUNT_1_BIT,
+			.maxResourceSize = limits.sparseAddressSpaceSize,
+		};
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getPhysicalDeviceSparseImageFormatProperties(
+		VkPhysicalDevice,
+		VkFormat format,
+		VkImageType type,
+		VkSampleCountFlagBits,
+		VkImageUsageFlags,
+		VkImageTiling tiling,
+		uint32_t* pPropertyCount,
+		VkSparseImageFormatProperties* pProperties)
+	{
+		auto formatInfo = std::find_if(formatInfos.begin(), formatInfos.end(), [format](auto& formatInfo) { return formatInfo.format == format; });
+		if (formatInfo == formatInfos.end() || type == VK_IMAGE_TYPE_1D || tiling != VK_IMAGE_TILING_OPTIMAL) {
+			*pPropertyCount = 0;
+			return;
+		}
+		if (pProperties && *pPropertyCount > 0) {
+			pProperties[0] = VkSparseImageFormatProperties{
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.imageGranularity = getStandardBlockShape(type, *formatInfo),
+				.flags = 0,
+			};
+		}
+		*pPropertyCount = 1;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL enumerateDeviceExtensionProperties(VkPhysicalDevice, const char*, uint32_t* pPropertyCount, VkExtensionProperties* pProperties)
+	{
+		if (!pProperties) {
+			*pPropertyCount = static_cast<uint32_t>(deviceExtensions.size());
+			return VK_SUCCESS;
+		}
+		auto count = std::min<uint32_t>(*pPropertyCount, static_cast<uint32_t>(deviceExtensions.size()));
+		for (uint32_t i = 0; i < count; i++) {
+			pProperties[i] = VkExtensionProperties{ .specVersion = 1 };
+			std::string_view(deviceExtensions[i]).copy(pProperties[i].extensionName, VK_MAX_EXTENSION_NAME_SIZE - 1);
+		}
+		*pPropertyCount = count;
+		return count < deviceExtensions.size() ? VK_INCOMPLETE : VK_SUCCESS;
+	}
+
+	// device
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkDevice* pDevice)
+	{
+		for (uint32_t i = 0; i < pCreateInfo->enabledExtensionCount; i++) {
+			std::string_view extension(pCreateInfo->ppEnabledExtensionNames[i]);
+			if (std::find(deviceExtensions.begin(), deviceExtensions.end(), extension) == deviceExtensions.end()) {
+				return VK_ERROR_EXTENSION_NOT_PRESENT;
+			}
+		}
+		auto device = std::make_unique<Device>();
+		device->physicalDevice = get<PhysicalDevice>(physicalDevice);
+		auto& queueFamilies = device->physicalDevice->queueFamilies;
+		for (uint32_t i = 0; i < pCreateInfo->queueCreateInfoCount; i++) {
+			auto& queueCreateInfo = pCreateInfo->pQueueCreateInfos[i];
+			if (queueCreateInfo.queueFamilyIndex >= queueFamilies.size() ||
+				queueCreateInfo.queueCount > queueFamilies[queueCreateInfo.queueFamilyIndex].queueCount) {
+				return fail(std::format("queue family {} does not have {} queues", queueCreateInfo.queueFamilyIndex, queueCreateInfo.queueCount));
+			}
+			for (uint32_t queueIndex = 0; queueIndex < queueCreateInfo.queueCount; queueIndex++) {
+				auto queue = std::make_unique<Queue>();
+				queue->device = device.get();
+				queue->queueFamilyIndex = queueCreateInfo.queueFamilyIndex;
+				queue->queueIndex = queueIndex;
+				device->queues.push_back(std::move(queue));
+			}
+		}
+		*pDevice = toHandle<VkDevice>(device.release());
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroyDevice(VkDevice device, const VkAllocationCallbacks*)
+	{
+		delete get<Device>(device);
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue)
+	{
+		*pQueue = VK_NULL_HANDLE;
+		for (auto& queue : get<Device>(device)->queues) {
+			if (queue->queueFamilyIndex == queueFamilyIndex && queue->queueIndex == queueIndex) {
+				*pQueue = toHandle<VkQueue>(queue.get());
+			}
+		}
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL queueWaitIdle(VkQueue queue)
+	{
+		auto& simulatedQueue = *get<Queue>(queue);
+		Clock::time_point busyUntil;
+		{
+			std::lock_guard lock(simulatedQueue.mutex);
+			busyUntil = simulatedQueue.busyUntil;
+		}
+		waitUntil(busyUntil);
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL deviceWaitIdle(VkDevice device)
+	{
+		for (auto& queue : get<Device>(device)->queues) {
+			queueWaitIdle(toHandle<VkQueue>(queue.get()));
+		}
+		return VK_SUCCESS;
+	}
+
+	// memory
+
+	static VKAPI_ATTR VkResult VKAPI_CALL allocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory)
+	{
+		auto& simulatedDevice = *get<Device>(device);
+		auto& memoryProperties = simulatedDevice.physicalDevice->memoryProperties;
+		if (pAllocateInfo->memoryTypeIndex >= memoryProperties.memoryTypeCount) {
+			return fail(std::format("memory type {} does not exist", pAllocateInfo->memoryTypeIndex));
+		}
+		auto heapIndex = memoryProperties.memoryTypes[pAllocateInfo->memoryTypeIndex].heapIndex;
+
+		std::lock_guard lock(simulatedDevice.mutex);
+		if (simulatedDevice.allocationCount == maxMemoryAllocationCount) {
+			return VK_ERROR_TOO_MANY_OBJECTS;
+		}
+		auto& physicalDeviceUsage = simulatedDevice.physicalDevice->heapUsage[heapIndex];
+		if (physicalDeviceUsage + pAllocateInfo->allocationSize > getHeapLimit(*simulatedDevice.physicalDevice, heapIndex)) {
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		}
+		simulatedDevice.heapUsage[heapIndex] += pAllocateInfo->allocationSize;
+		physicalDeviceUsage += pAllocateInfo->allocationSize;
+		simulatedDevice.allocationCount++;
+		*pMemory = toHandle<VkDeviceMemory>(new Memory{ pAllocateInfo->allocationSize, pAllocateInfo->memoryTypeIndex });
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL freeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks*)
+	{
+		if (memory == VK_NULL_HANDLE) {
+			return;
+		}
+		auto& simulatedDevice = *get<Device>(device);
+		auto simulatedMemory = get<Memory>(memory);
+		auto heapIndex = simulatedDevice.physicalDevice->memoryProperties.memoryTypes[simulatedMemory->memoryTypeIndex].heapIndex;
+		{
+			std::lock_guard lock(simulatedDevice.mutex);
+			simulatedDevice.heapUsage[heapIndex] -= simulatedMemory->size;
+			simulatedDevice.physicalDevice->heapUsage[heapIndex] -= simulatedMemory->size;
+			simulatedDevice.allocationCount--;
+		}
+		delete simulatedMemory;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL mapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags, void** ppData)
+	{
+		auto& simulatedMemory = *get<Memory>(memory);
+		auto propertyFlags = get<Device>(device)->physicalDevice->memoryProperties.memoryTypes[simulatedMemory.memoryTypeIndex].propertyFlags;
+		if (!(propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+			return fail(std::format("memory type {} is not host visible", simulatedMemory.memoryTypeIndex));
+		}
+		if (offset > simulatedMemory.size || (size != VK_WHOLE_SIZE && offset + size > simulatedMemory.size)) {
+			return fail(std::format("mapping {} bytes at offset {} overruns the allocation of {} bytes", size, offset, simulatedMemory.size));
+		}
+		simulatedMemory.data.resize(simulatedMemory.size);
+		*ppData = simulatedMemory.data.data() + offset;
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL unmapMemory(VkDevice, VkDeviceMemory)
+	{
+	}
+
+	// fences
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createFence(VkDevice, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkFence* pFence)
+	{
+		auto fence = new Fence;
+		if (pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) {
+			fence->signalTime = 0;
+		}
+		*pFence = toHandle<VkFence>(fence);
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroyFence(VkDevice, VkFence fence, const VkAllocationCallbacks*)
+	{
+		delete get<Fence>(fence);
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL resetFences(VkDevice, uint32_t fenceCount, const VkFence* pFences)
+	{
+		for (uint32_t i = 0; i < fenceCount; i++) {
+			get<Fence>(pFences[i])->signalTime = Fence::unsignaled;
+		}
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL getFenceStatus(VkDevice, VkFence fence)
+	{
+		return get<Fence>(fence)->signalTime <= Clock::now().time_since_epoch().count() ? VK_SUCCESS : VK_NOT_READY;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL waitForFences(VkDevice, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout)
+	{
+		// the time the first (waitAny) or last (waitAll) fence signals
+		auto signalTime = waitAll ? std::numeric_limits<Clock::rep>::min() : Fence::unsignaled;
+		for (uint32_t i = 0; i < fenceCount; i++) {
+			Clock::rep fenceTime = get<Fence>(pFences[i])->signalTime;
+			signalTime = waitAll ? std::max(signalTime, fenceTime) : std::min(signalTime, fenceTime);
+		}
+		return waitForSignal(signalTime, timeout);
+	}
+
+	// semaphores
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createSemaphore(VkDevice, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkSemaphore* pSemaphore)
+	{
+		for (auto next = static_cast<const VkBaseInStructure*>(pCreateInfo->pNext); next; next = next->pNext) {
+			if (next->sType == VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO) {
+				auto typeCreateInfo = reinterpret_cast<const VkSemaphoreTypeCreateInfo*>(next);
+				if (typeCreateInfo->semaphoreType == VK_SEMAPHORE_TYPE_TIMELINE) {
+					auto semaphore = new Semaphore;
+					semaphore->value = typeCreateInfo->initialValue;
+					*pSemaphore = toHandle<VkSemaphore>(semaphore);
+					return VK_SUCCESS;
+				}
+			}
+		}
+		return fail("binary semaphores are not simulated");
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroySemaphore(VkDevice, VkSemaphore semaphore, const VkAllocationCallbacks*)
+	{
+		delete get<Semaphore>(semaphore);
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL getSemaphoreCounterValue(VkDevice, VkSemaphore semaphore, uint64_t* pValue)
+	{
+		auto& simulatedSemaphore = *get<Semaphore>(semaphore);
+		std::lock_guard lock(simulatedSemaphore.mutex);
+		simulatedSemaphore.update(Clock::now().time_since_epoch().count());
+		*pValue = simulatedSemaphore.value;
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL signalSemaphore(VkDevice, const VkSemaphoreSignalInfo* pSignalInfo)
+	{
+		get<Semaphore>(pSignalInfo->semaphore)->signal(pSignalInfo->value, Clock::now());
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL waitSemaphores(VkDevice, const VkSemaphoreWaitInfo* pWaitInfo, uint64_t timeout)
+	{
+		// the time the first (waitAny) or last value is reached
+		auto waitAny = (pWaitInfo->flags & VK_SEMAPHORE_WAIT_ANY_BIT) != 0;
+		auto signalTime = waitAny ? Fence::unsignaled : std::numeric_limits<Clock::rep>::min();
+		for (uint32_t i = 0; i < pWaitInfo->semaphoreCount; i++) {
+			auto valueTime = get<Semaphore>(pWaitInfo->pSemaphores[i])->getSignalTime(pWaitInfo->pValues[i]);
+			signalTime = waitAny ? std::min(signalTime, valueTime) : std::max(signalTime, valueTime);
+		}
+		return waitForSignal(signalTime, timeout);
+	}
+
+	// command buffers
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createCommandPool(VkDevice, const VkCommandPoolCreateInfo*, const VkAllocationCallbacks*, VkCommandPool* pCommandPool)
+	{
+		*pCommandPool = toHandle<VkCommandPool>(new CommandPool);
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroyCommandPool(VkDevice, VkCommandPool commandPool, const VkAllocationCallbacks*)
+	{
+		delete get<CommandPool>(commandPool);
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL allocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers)
+	{
+		auto& commandPool = *get<CommandPool>(pAllocateInfo->commandPool);
+		for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++) {
+			commandPool.commandBuffers.push_back(std::make_unique<CommandBuffer>());
+			pCommandBuffers[i] = toHandle<VkCommandBuffer>(commandPool.commandBuffers.back().get());
+		}
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL freeCommandBuffers(VkDevice, VkCommandPool commandPool, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
+	{
+		auto& commandBuffers = get<CommandPool>(commandPool)->commandBuffers;
+		for (uint32_t i = 0; i < commandBufferCount; i++) {
+			std::erase_if(commandBuffers, [&](auto& commandBuffer) { return commandBuffer.get() == get<CommandBuffer>(pCommandBuffers[i]); });
+		}
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL beginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo*)
+	{
+		get<CommandBuffer>(commandBuffer)->microseconds = 0.0;
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL endCommandBuffer(VkCommandBuffer)
+	{
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL cmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t)
+	{
+		if (size == VK_WHOLE_SIZE) {
+			size = get<Buffer>(buffer)->createInfo.size - offset;
+		}
+		// 1 GB/s is 1000 bytes per microsecond
+		get<CommandBuffer>(commandBuffer)->microseconds += double(size) / (config.transferRate * 1000.0);
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL cmdPipelineBarrier(VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags,
+		uint32_t, const VkMemoryBarrier*, uint32_t, const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier*)
+	{
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL cmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer, VkImage image, VkImageLayout,
+		uint32_t regionCount, const VkBufferImageCopy* pRegions)
+	{
+		auto format = get<Image>(image)->createInfo.format;
+		auto formatInfo = std::find_if(formatInfos.begin(), formatInfos.end(), [format](auto& formatInfo) { return formatInfo.format == format; });
+		VkDeviceSize size = 0;
+		for (uint32_t i = 0; i < regionCount; i++) {
+			size += formatInfo->getSize(pRegions[i].imageExtent);
+		}
+		get<CommandBuffer>(commandBuffer)->microseconds += double(size) / (config.transferRate * 1000.0);
+	}
+
+	// images
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createImage(VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkImage* pImage)
+	{
+		auto& simulatedDevice = *get<Device>(device);
+		auto formatInfo = std::find_if(formatInfos.begin(), formatInfos.end(), [pCreateInfo](auto& formatInfo) { return formatInfo.format == pCreateInfo->format; });
+		if (formatInfo == formatInfos.end()) {
+			return VK_ERROR_FORMAT_NOT_SUPPORTED;
+		}
+		auto& extent = pCreateInfo->extent;
+		auto maxDimension = std::max({ extent.width, extent.height, extent.depth });
+		if (maxDimension > maxImageDimension || pCreateInfo->mipLevels > uint32_t(std::bit_width(maxDimension))) {
+			return fail(std::format("image extent ({}, {}, {}) with {} mip levels exceeds the limits",
+				extent.width, extent.height, extent.depth, pCreateInfo->mipLevels));
+		}
+		auto sparseResidency = (pCreateInfo->flags & VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT) != 0;
+		auto sparseBinding = (pCreateInfo->flags & VK_IMAGE_CREATE_SPARSE_BINDING_BIT) != 0;
+		if (sparseResidency && !sparseBinding) {
+			return fail("VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT requires VK_IMAGE_CREATE_SPARSE_BINDING_BIT");
+		}
+
+		auto image = std::make_unique<Image>();
+		image->createInfo = *pCreateInfo;
+		image->createInfo.pNext = nullptr;
+		image->createInfo.pQueueFamilyIndices = nullptr;
+		image->granularity = getStandardBlockShape(pCreateInfo->imageType, *formatInfo);
+
+		// the mip tail starts at the first level that is smaller than a block in any dimension
+		auto& granularity = image->granularity;
+		VkDeviceSize mipTailSize = 0;
+		image->mipTailFirstLod = pCreateInfo->mipLevels;
+		for (uint32_t level = 0; level < pCreateInfo->mipLevels; level++) {
+			VkExtent3D levelExtent{
+				std::max(extent.width >> level, 1u),
+				std::max(extent.height >> level, 1u),
+				std::max(extent.depth >> level, 1u),
+			};
+			if (levelExtent.width < granularity.width || levelExtent.height < granularity.height || levelExtent.depth < granularity.depth) {
+				image->mipTailFirstLod = std::min(image->mipTailFirstLod, level);
+			}
+			if (level >= image->mipTailFirstLod) {
+				mipTailSize += formatInfo->getSize(levelExtent);
+				continue;
+			}
+			ImageLevel imageLevel{
+				.extent = levelExtent,
+				.blocks = {
+					divideRoundingUp(levelExtent.width, granularity.width),
+					divideRoundingUp(levelExtent.height, granularity.height),
+					divideRoundingUp(levelExtent.depth, granularity.depth),
+				},
+				.firstBlock = image->layerBlocks,
+			};
+			image->layerBlocks += size_t(imageLevel.blocks.width) * imageLevel.blocks.height * imageLevel.blocks.depth;
+			image->levels.push_back(imageLevel);
+		}
+		image->mipTailBlocks = static_cast<size_t>((mipTailSize + blockSize - 1) / blockSize);
+		image->layerBlocks += image->mipTailBlocks;
+		image->size = VkDeviceSize(image->layerBlocks) * pCreateInfo->arrayLayers * blockSize;
+
+		if (sparseBinding) {
+			std::lock_guard lock(simulatedDevice.mutex);
+			if (simulatedDevice.sparseAddressSpaceUsage + image->size > simulatedDevice.physicalDevice->properties.limits.sparseAddressSpaceSize) {
+				return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			}
+			simulatedDevice.sparseAddressSpaceUsage += image->size;
+			image->resident.resize(image->layerBlocks * pCreateInfo->arrayLayers, false);
+		}
+		*pImage = toHandle<VkImage>(image.release());
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks*)
+	{
+		if (image == VK_NULL_HANDLE) {
+			return;
+		}
+		auto& simulatedDevice = *get<Device>(device);
+		auto simulatedImage = get<Image>(image);
+		if (!simulatedImage->resident.empty()) {
+			std::lock_guard lock(simulatedDevice.mutex);
+			simulatedDevice.sparseAddressSpaceUsage -= simulatedImage->size;
+			simulatedDevice.residentBlocks -= std::count(simulatedImage->resident.begin(), simulatedImage->resident.end(), true);
+		}
+		delete simulatedImage;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getImageMemoryRequirements(VkDevice, VkImage image, VkMemoryRequirements* pMemoryRequirements)
+	{
+		*pMemoryRequirements = VkMemoryRequirements{
+			.size = get<Image>(image)->size,
+			.alignment = blockSize,
+			.memoryTypeBits = 1,
+		};
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getImageSparseMemoryRequirements(VkDevice, VkImage image, uint32_t* pSparseMemoryRequirementCount, VkSparseImageMemoryRequirements* pSparseMemoryRequirements)
+	{
+		auto& simulatedImage = *get<Image>(image);
+		if (!(simulatedImage.createInfo.flags & VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT)) {
+			*pSparseMemoryRequirementCount = 0;
+			return;
+		}
+		if (pSparseMemoryRequirements && *pSparseMemoryRequirementCount > 0) {
+			pSparseMemoryRequirements[0] = VkSparseImageMemoryRequirements{
+				.formatProperties = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.imageGranularity = simulatedImage.granularity,
+					.flags = 0,
+				},
+				.imageMipTailFirstLod = simulatedImage.mipTailFirstLod,
+				.imageMipTailSize = simulatedImage.mipTailBlocks * blockSize,
+				.imageMipTailOffset = (simulatedImage.layerBlocks - simulatedImage.mipTailBlocks) * blockSize,
+				.imageMipTailStride = simulatedImage.layerBlocks * blockSize,
+			};
+		}
+		*pSparseMemoryRequirementCount = 1;
+	}
+
+	// buffers
+
+	static VKAPI_ATTR VkResult VKAPI_CALL createBuffer(VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer)
+	{
+		auto& simulatedDevice = *get<Device>(device);
+		auto sparseResidency = (pCreateInfo->flags & VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT) != 0;
+		auto sparseBinding = (pCreateInfo->flags & VK_BUFFER_CREATE_SPARSE_BINDING_BIT) != 0;
+		if (sparseResidency && !sparseBinding) {
+			return fail("VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT requires VK_BUFFER_CREATE_SPARSE_BINDING_BIT");
+		}
+		if (pCreateInfo->size == 0) {
+			return fail("buffer size must be greater than 0");
+		}
+
+		auto buffer = std::make_unique<Buffer>();
+		buffer->createInfo = *pCreateInfo;
+		buffer->createInfo.pNext = nullptr;
+		buffer->createInfo.pQueueFamilyIndices = nullptr;
+		if (sparseBinding) {
+			auto size = divideRoundingUp(pCreateInfo->size, blockSize) * blockSize;
+			std::lock_guard lock(simulatedDevice.mutex);
+			if (simulatedDevice.sparseAddressSpaceUsage + size > simulatedDevice.physicalDevice->properties.limits.sparseAddressSpaceSize) {
+				return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			}
+			simulatedDevice.sparseAddressSpaceUsage += size;
+			buffer->resident.resize(static_cast<size_t>(size / blockSize), false);
+		}
+		*pBuffer = toHandle<VkBuffer>(buffer.release());
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL destroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks*)
+	{
+		if (buffer == VK_NULL_HANDLE) {
+			return;
+		}
+		auto& simulatedDevice = *get<Device>(device);
+		auto simulatedBuffer = get<Buffer>(buffer);
+		if (!simulatedBuffer->resident.empty()) {
+			std::lock_guard lock(simulatedDevice.mutex);
+			simulatedDevice.sparseAddressSpaceUsage -= simulatedBuffer->resident.size() * blockSize;
+			simulatedDevice.residentBlocks -= std::count(simulatedBuffer->resident.begin(), simulatedBuffer->resident.end(), true);
+		}
+		delete simulatedBuffer;
+	}
+
+	static VKAPI_ATTR void VKAPI_CALL getBufferMemoryRequirements(VkDevice, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements)
+	{
+		// non-sparse buffers may also be host visible
+		auto& simulatedBuffer = *get<Buffer>(buffer);
+		*pMemoryRequirements = VkMemoryRequirements{
+			.size = divideRoundingUp(simulatedBuffer.createInfo.size, blockSize) * blockSize,
+			.alignment = blockSize,
+			.memoryTypeBits = simulatedBuffer.resident.empty() ? 3u : 1u,
+		};
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL bindBufferMemory(VkDevice, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+	{
+		auto& simulatedBuffer = *get<Buffer>(buffer);
+		if (!simulatedBuffer.resident.empty()) {
+			return fail("sparse buffers are bound with vkQueueBindSparse");
+		}
+		if (memoryOffset + simulatedBuffer.createInfo.size > get<Memory>(memory)->size) {
+			return fail(std::format("buffer of {} bytes at memory offset {} overruns the allocation", simulatedBuffer.createInfo.size, memoryOffset));
+		}
+		return VK_SUCCESS;
+	}
+
+	// sparse binding
+
+	// memoryOffset and size of a bind into memory, nothing to check for unbinds
+	static VkResult checkMemory(VkDeviceMemory memory, VkDeviceSize memoryOffset, VkDeviceSize size)
+	{
+		if (memory == VK_NULL_HANDLE) {
+			return VK_SUCCESS;
+		}
+		auto& simulatedMemory = *get<Memory>(memory);
+		if (simulatedMemory.memoryTypeIndex != 0) {
+			return fail(std::format("memory type {} is not allowed for sparse resources", simulatedMemory.memoryTypeIndex));
+		}
+		if (memoryOffset % blockSize != 0) {
+			return fail(std::format("memory offset {} is not a multiple of the sparse block size", memoryOffset));
+		}
+		if (memoryOffset + size > simulatedMemory.size) {
+			return fail(std::format("binding {} bytes at memory offset {} overruns the allocation of {} bytes", size, memoryOffset, simulatedMemory.size));
+		}
+		return VK_SUCCESS;
+	}
+
+	static void setResident(Device& device, std::vector<bool>& blocks, size_t block, bool resident)
+	{
+		if (blocks[block] != resident) {
+			blocks[block] = resident;
+			device.residentBlocks += resident ? 1 : -1;
+		}
+	}
+
+	static VkResult bindImage(Device& device, Image& image, const VkSparseImageMemoryBind& bind)
+	{
+		auto& subresource = bind.subresource;
+		if (!(image.createInfo.flags & VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT)) {
+			return fail("image binds need an image created with VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT");
+		}
+		if (subresource.arrayLayer >= image.createInfo.arrayLayers || subresource.mipLevel >= image.createInfo.mipLevels) {
+			return fail(std::format("mip level {} array layer {} does not exist", subresource.mipLevel, subresource.arrayLayer));
+		}
+		if (subresource.mipLevel >= image.mipTailFirstLod) {
+			return fail(std::format("mip level {} is in the mip tail, which is bound with opaque binds", subresource.mipLevel));
+		}
+
+		// offsets are multiples of the granularity, extents too, except where they end at the edge of the level
+		auto& level = image.levels[subresource.mipLevel];
+		auto& granularity = image.granularity;
+		auto isAligned = [](int32_t offset, uint32_t extent, uint32_t granularity, uint32_t levelExtent) {
+			return offset >= 0 && uint32_t(offset) % granularity == 0 && extent > 0 && uint32_t(offset) + extent <= levelExtent &&
+				(extent % granularity == 0 || uint32_t(offset) + extent == levelExtent);
+		};
+		if (!isAligned(bind.offset.x, bind.extent.width, granularity.width, level.extent.width) ||
+			!isAligned(bind.offset.y, bind.extent.height, granularity.height, level.extent.height) ||
+			!isAligned(bind.offset.z, bind.extent.depth, granularity.depth, level.extent.depth)) {
+			return fail(std::format("bind at ({}, {}, {}) of extent ({}, {}, {}) in mip level {} of extent ({}, {}, {}) is not aligned to ({}, {}, {}) blocks",
+				bind.offset.x, bind.offset.y, bind.offset.z, bind.extent.width, bind.extent.height, bind.extent.depth, subresource.mipLevel,
+				level.extent.width, level.extent.height, level.extent.depth, granularity.width, granularity.height, granularity.depth));
+		}
+
+		VkExtent3D first{
+			uint32_t(bind.offset.x) / granularity.width,
+			uint32_t(bind.offset.y) / granularity.height,
+			uint32_t(bind.offset.z) / granularity.depth,
+		};
+		VkExtent3D blocks{
+			divideRoundingUp(bind.extent.width, granularity.width),
+			divideRoundingUp(bind.extent.height, granularity.height),
+			divideRoundingUp(bind.extent.depth, granularity.depth),
+		};
+		auto result = checkMemory(bind.memory, bind.memoryOffset, VkDeviceSize(blocks.width) * blocks.height * blocks.depth * blockSize);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+
+		std::lock_guard lock(image.mutex);
+		auto layerBlock = subresource.arrayLayer * image.layerBlocks + level.firstBlock;
+		for (uint32_t z = first.depth; z < first.depth + blocks.depth; z++) {
+			for (uint32_t y = first.height; y < first.height + blocks.height; y++) {
+				for (uint32_t x = first.width; x < first.width + blocks.width; x++) {
+					setResident(device, image.resident, layerBlock + (size_t(z) * level.blocks.height + y) * level.blocks.width + x, bind.memory != VK_NULL_HANDLE);
+				}
+			}
+		}
+		return VK_SUCCESS;
+	}
+
+	static VkResult bindImageOpaque(Device& device, Image& image, const VkSparseMemoryBind& bind)
+	{
+		if (image.resident.empty()) {
+			return fail("opaque binds need an image created with VK_IMAGE_CREATE_SPARSE_BINDING_BIT");
+		}
+		if (bind.size == 0 || bind.resourceOffset % blockSize != 0 || bind.resourceOffset + bind.size > image.size ||
+			(bind.size % blockSize != 0 && bind.resourceOffset + bind.size != image.size)) {
+			return fail(std::format("opaque bind of {} bytes at offset {} is not aligned to blocks or exceeds the image size {}",
+				bind.size, bind.resourceOffset, image.size));
+		}
+		auto result = checkMemory(bind.memory, bind.memoryOffset, bind.size);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+
+		std::lock_guard lock(image.mutex);
+		auto first = static_cast<size_t>(bind.resourceOffset / blockSize);
+		auto last = static_cast<size_t>((bind.resourceOffset + bind.size + blockSize - 1) / blockSize);
+		for (auto block = first; block < last; block++) {
+			setResident(device, image.resident, block, bind.memory != VK_NULL_HANDLE);
+		}
+		return VK_SUCCESS;
+	}
+
+	static VkResult bindBuffer(Device& device, Buffer& buffer, const VkSparseMemoryBind& bind)
+	{
+		if (buffer.resident.empty()) {
+			return fail("buffer binds need a buffer created with VK_BUFFER_CREATE_SPARSE_BINDING_BIT");
+		}
+		auto size = buffer.createInfo.size;
+		if (bind.size == 0 || bind.resourceOffset % blockSize != 0 || bind.resourceOffset + bind.size > size ||
+			(bind.size % blockSize != 0 && bind.resourceOffset + bind.size != size)) {
+			return fail(std::format("buffer bind of {} bytes at offset {} is not aligned to blocks or exceeds the buffer size {}",
+				bind.size, bind.resourceOffset, size));
+		}
+		auto result = checkMemory(bind.memory, bind.memoryOffset, bind.size);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+
+		std::lock_guard lock(buffer.mutex);
+		auto first = static_cast<size_t>(bind.resourceOffset / blockSize);
+		auto last = static_cast<size_t>((bind.resourceOffset + bind.size + blockSize - 1) / blockSize);
+		for (auto block = first; block < last; block++) {
+			setResident(device, buffer.resident, block, bind.memory != VK_NULL_HANDLE);
+		}
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL queueBindSparse(VkQueue queue, uint32_t bindInfoCount, const VkBindSparseInfo* pBindInfo, VkFence fence)
+	{
+		auto& simulatedQueue = *get<Queue>(queue);
+		auto& device = *simulatedQueue.device;
+		auto& physicalDevice = *device.physicalDevice;
+		if (!(physicalDevice.queueFamilies[simulatedQueue.queueFamilyIndex].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT)) {
+			return fail(std::format("queue family {} does not support sparse binding", simulatedQueue.queueFamilyIndex));
+		}
+
+		std::vector<size_t> entries(bindInfoCount, 0);
+		for (uint32_t i = 0; i < bindInfoCount; i++) {
+			auto& bindInfo = pBindInfo[i];
+			auto result = checkSignals(bindInfo.pNext, bindInfo.signalSemaphoreCount);
+			if (result != VK_SUCCESS) {
+				return result;
+			}
+			for (uint32_t j = 0; j < bindInfo.bufferBindCount; j++) {
+				auto& bufferBindInfo = bindInfo.pBufferBinds[j];
+				for (uint32_t k = 0; k < bufferBindInfo.bindCount; k++) {
+					auto result = bindBuffer(device, *get<Buffer>(bufferBindInfo.buffer), bufferBindInfo.pBinds[k]);
+					if (result != VK_SUCCESS) {
+						return result;
+					}
+				}
+				entries[i] += bufferBindInfo.bindCount;
+			}
+			for (uint32_t j = 0; j < bindInfo.imageOpaqueBindCount; j++) {
+				auto& opaqueBindInfo = bindInfo.pImageOpaqueBinds[j];
+				for (uint32_t k = 0; k < opaqueBindInfo.bindCount; k++) {
+					auto result = bindImageOpaque(device, *get<Image>(opaqueBindInfo.image), opaqueBindInfo.pBinds[k]);
+					if (result != VK_SUCCESS) {
+						return result;
+					}
+				}
+				entries[i] += opaqueBindInfo.bindCount;
+			}
+			for (uint32_t j = 0; j < bindInfo.imageBindCount; j++) {
+				auto& imageBindInfo = bindInfo.pImageBinds[j];
+				for (uint32_t k = 0; k < imageBindInfo.bindCount; k++) {
+					auto result = bindImage(device, *get<Image>(imageBindInfo.image), imageBindInfo.pBinds[k]);
+					if (result != VK_SUCCESS) {
+						return result;
+					}
+				}
+				entries[i] += imageBindInfo.bindCount;
+			}
+		}
+
+		// the fixed cost is paid once per call, and every bind info executes after its waits
+		auto latency = config.bindLatency;
+		if (physicalDevice.latencyModel == LatencyModel::Linear) {
+			latency += config.residentLatency * device.residentBlocks;
+		}
+		if (bindInfoCount == 0) {
+			execute(simulatedQueue, latency, fence);
+		}
+		for (uint32_t i = 0; i < bindInfoCount; i++) {
+			auto& bindInfo = pBindInfo[i];
+			Clock::time_point start;
+			auto result = getWaitTime(bindInfo.pNext, bindInfo.waitSemaphoreCount, bindInfo.pWaitSemaphores, start);
+			if (result != VK_SUCCESS) {
+				return result;
+			}
+			latency += config.entryLatency * entries[i];
+			auto completion = execute(simulatedQueue, latency, (i + 1 == bindInfoCount) ? fence : VK_NULL_HANDLE, start);
+			signal(bindInfo.pNext, bindInfo.signalSemaphoreCount, bindInfo.pSignalSemaphores, completion);
+			latency = 0.0;
+		}
+		return VK_SUCCESS;
+	}
+
+	static VKAPI_ATTR VkResult VKAPI_CALL queueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+	{
+		auto& simulatedQueue = *get<Queue>(queue);
+		if (submitCount == 0) {
+			execute(simulatedQueue, 0.0, fence);
+		}
+		for (uint32_t i = 0; i < submitCount; i++) {
+			auto& submit = pSubmits[i];
+			Clock::time_point start;
+			auto result = getWaitTime(submit.pNext, submit.waitSemaphoreCount, submit.pWaitSemaphores, start);
+			if (result == VK_SUCCESS) {
+				result = checkSignals(submit.pNext, submit.signalSemaphoreCount);
+			}
+			if (result != VK_SUCCESS) {
+				return result;
+			}
+			auto latency = config.submitLatency;
+			for (uint32_t j = 0; j < submit.commandBufferCount; j++) {
+				latency += get<CommandBuffer>(submit.pCommandBuffers[j])->microseconds;
+			}
+			auto completion = execute(simulatedQueue, latency, (i + 1 == submitCount) ? fence : VK_NULL_HANDLE, start);
+			signal(submit.pNext, submit.signalSemaphoreCount, submit.pSignalSemaphores, completion);
+		}
+		return VK_SUCCESS;
+	}
+
+	template <typename PFN>
+	static std::pair<std::string_view, PFN_vkVoidFunction> function(std::string_view name, PFN function)
+	{
+		return { name, reinterpret_cast<PFN_vkVoidFunction>(function) };
+	}
+
+	static inline SimulationConfig config;
+	static inline std::mutex globalLock;		// the lock of the global lock model
+
+	static inline const std::array functions{
+		function<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr", &getInstanceProcAddr),
+		function<PFN_vkGetDeviceProcAddr>("vkGetDeviceProcAddr", &getDeviceProcAddr),
+		function<PFN_vkEnumerateInstanceVersion>("vkEnumerateInstanceVersion", &enumerateInstanceVersion),
+		function<PFN_vkCreateInstance>("vkCreateInstance", &createInstance),
+		function<PFN_vkDestroyInstance>("vkDestroyInstance", &destroyInstance),
+		function<PFN_vkEnumeratePhysicalDevices>("vkEnumeratePhysicalDevices", &enumeratePhysicalDevices),
+		function<PFN_vkGetPhysicalDeviceFeatures>("vkGetPhysicalDeviceFeatures", &getPhysicalDeviceFeatures),
+		function<PFN_vkGetPhysicalDeviceFeatures2>("vkGetPhysicalDeviceFeatures2", &getPhysicalDeviceFeatures2),
+		function<PFN_vkGetPhysicalDeviceProperties>("vkGetPhysicalDeviceProperties", &getPhysicalDeviceProperties),
+		function<PFN_vkGetPhysicalDeviceQueueFamilyProperties>("vkGetPhysicalDeviceQueueFamilyProperties", &getPhysicalDeviceQueueFamilyProperties),
+		function<PFN_vkGetPhysicalDeviceMemoryProperties>("vkGetPhysicalDeviceMemoryProperties", &getPhysicalDeviceMemoryProperties),
+		function<PFN_vkGetPhysicalDeviceMemoryProperties2>("vkGetPhysicalDeviceMemoryProperties2", &getPhysicalDeviceMemoryProperties2),
+		function<PFN_vkGetPhysicalDeviceImageFormatProperties>("vkGetPhysicalDeviceImageFormatProperties", &getPhysicalDeviceImageFormatProperties),
+		function<PFN_vkGetPhysicalDeviceSparseImageFormatProperties>("vkGetPhysicalDeviceSparseImageFormatProperties", &getPhysicalDeviceSparseImageFormatProperties),
+		function<PFN_vkEnumerateDeviceExtensionProperties>("vkEnumerateDeviceExtensionProperties", &enumerateDeviceExtensionProperties),
+		function<PFN_vkCreateDevice>("vkCreateDevice", &createDevice),
+		function<PFN_vkDestroyDevice>("vkDestroyDevice", &destroyDevice),
+		function<PFN_vkGetDeviceQueue>("vkGetDeviceQueue", &getDeviceQueue),
+		function<PFN_vkQueueWaitIdle>("vkQueueWaitIdle", &queueWaitIdle),
+		function<PFN_vkDeviceWaitIdle>("vkDeviceWaitIdle", &deviceWaitIdle),
+		function<PFN_vkAllocateMemory>("vkAllocateMemory", &allocateMemory),
+		function<PFN_vkFreeMemory>("vkFreeMemory", &freeMemory),
+		function<PFN_vkMapMemory>("vkMapMemory", &mapMemory),
+		function<PFN_vkUnmapMemory>("vkUnmapMemory", &unmapMemory),
+		function<PFN_vkCreateFence>("vkCreateFence", &createFence),
+		function<PFN_vkDestroyFence>("vkDestroyFence", &destroyFence),
+		function<PFN_vkResetFences>("vkResetFences", &resetFences),
+		function<PFN_vkGetFenceStatus>("vkGetFenceStatus", &getFenceStatus),
+		function<PFN_vkWaitForFences>("vkWaitForFences", &waitForFences),
+		function<PFN_vkCreateSemaphore>("vkCreateSemaphore", &createSemaphore),
+		function<PFN_vkDestroySemaphore>("vkDestroySemaphore", &destroySemaphore),
+		function<PFN_vkGetSemaphoreCounterValue>("vkGetSemaphoreCounterValue", &getSemaphoreCounterValue),
+		function<PFN_vkSignalSemaphore>("vkSignalSemaphore", &signalSemaphore),
+		function<PFN_vkWaitSemaphores>("vkWaitSemaphores", &waitSemaphores),
+		function<PFN_vkCreateCommandPool>("vkCreateCommandPool", &createCommandPool),
+		function<PFN_vkDestroyCommandPool>("vkDestroyCommandPool", &destroyCommandPool),
+		function<PFN_vkAllocateCommandBuffers>("vkAllocateCommandBuffers", &allocateCommandBuffers),
+		function<PFN_vkFreeCommandBuffers>("vkFreeCommandBuffers", &freeCommandBuffers),
+		function<PFN_vkBeginCommandBuffer>("vkBeginCommandBuffer", &beginCommandBuffer),
+		function<PFN_vkEndCommandBuffer>("vkEndCommandBuffer", &endCommandBuffer),
+		function<PFN_vkCmdFillBuffer>("vkCmdFillBuffer", &cmdFillBuffer),
+		function<PFN_vkCmdPipelineBarrier>("vkCmdPipelineBarrier", &cmdPipelineBarrier),
+		function<PFN_vkCmdCopyBufferToImage>("vkCmdCopyBufferToImage", &cmdCopyBufferToImage),
+		function<PFN_vkCreateImage>("vkCreateImage", &createImage),
+		function<PFN_vkDestroyImage>("vkDestroyImage", &destroyImage),
+		function<PFN_vkGetImageMemoryRequirements>("vkGetImageMemoryRequirements", &getImageMemoryRequirements),
+		function<PFN_vkGetImageSparseMemoryRequirements>("vkGetImageSparseMemoryRequirements", &getImageSparseMemoryRequirements),
+		function<PFN_vkCreateBuffer>("vkCreateBuffer", &createBuffer),
+		function<PFN_vkDestroyBuffer>("vkDestroyBuffer", &destroyBuffer),
+		function<PFN_vkGetBufferMemoryRequirements>("vkGetBufferMemoryRequirements", &getBufferMemoryRequirements),
+		function<PFN_vkBindBufferMemory>("vkBindBufferMemory", &bindBufferMemory),
+		function<PFN_vkQueueBindSparse>("vkQueueBindSparse", &queueBindSparse),
+		function<PFN_vkQueueSubmit>("vkQueueSubmit", &queueSubmit),
+	};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#include <deque>
+#include <memory>
+#include <cstddef>
+#include <optional>
+
+
+// A persistently mapped, host visible buffer that tile contents are written to before
+// they are copied to the image. Space is handed out in order around the ring, and the
+// allocations are tagged with the timeline value of the upload that reads them, so
+// that their space is reused once the upload completed. When the ring is full, the
+// caller waits for the oldest upload and reclaims its space.
+class StagingRing {
+public:
+	struct Allocation {
+		VkDeviceSize size{ 0 };		// including the padding before it
+		uint64_t value{ 0 };		// of the upload reading it, 0 until tagged
+	};
+
+	StagingRing(std::shared_ptr<VulkanDevice> device, VkDeviceSize size) :
+		device(std::move(device)),
+		size(size)
+	{
+		this->buffer = std::make_shared<VulkanBuffer>(this->device, VulkanBuffer::Config{
+			.size = size,
+			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		});
+		this->memory = std::make_shared<VulkanMemory>(this->device, this->device->getMemoryRequirements(this->buffer->buffer),
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		this->buffer->bindMemory(this->memory->memory);
+		this->data = static_cast<std::byte*>(this->memory->map());
+	}
+
+	// The offset of size bytes aligned to alignment, none if the ring is too full
+	std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (this->used == 0) {
+			this->head = 0;
+		}
+		auto offset = (this->head + alignment - 1) / alignment * alignment;
+		if (offset + size > this->size) {
+			offset = 0;		// wrap around, the rest of the ring is padding
+		}
+		auto padding = (offset >= this->head) ? offset - this->head : this->size - this->head;
+		if (this->used + padding + size > this->size) {
+			return std::nullopt;
+		}
+		this->head = offset + size;
+		this->used += padding + size;
+		this->allocations.push_back({ .size = padding + size, .value = 0 });
+		return offset;
+	}
+
+	// the allocations since the last tag are read by the upload that signals value
+	void tag(uint64_t value)
+	{
+		for (auto allocation = this->allocations.rbegin(); allocation != this->allocations.rend() && allocation->value == 0; allocation++) {
+			allocation->value = value;
+		}
+	}
+
+	// frees the allocations of the uploads up to completedValue
+	void reclaim(uint64_t completedValue)
+	{
+		while (!this->allocations.empty() && this->allocations.front().value != 0 && this->allocations.front().value <= completedValue) {
+			this->used -= this->allocations.front().size;
+			this->allocations.pop_front();
+		}
+	}
+
+	// the upload to wait for to free space, none if all allocations are of uploads not submitted yet
+	std::optional<uint64_t> getOldestValue() const
+	{
+		if (this->allocations.empty() || this->allocations.front().value == 0) {
+			return std::nullopt;
+		}
+		return this->allocations.front().value;
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	std::shared_ptr<VulkanBuffer> buffer{ nullptr };
+	std::shared_ptr<VulkanMemory> memory{ nullptr };
+	std::byte* data{ nullptr };		// the mapped buffer
+	VkDeviceSize size{ 0 };
+	VkDeviceSize head{ 0 };			// where the next allocation starts
+	VkDeviceSize used{ 0 };
+	std::deque<Allocation> allocations;		// oldest first
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+
+// Summary statistics of a list of samples, e.g. bind times in milliseconds
+class Statistics {
+public:
+	explicit Statistics(std::vector<double> samples) :
+		samples(std::move(samples))
+	{
+		std::sort(this->samples.begin(), this->samples.end());
+	}
+
+	size_t count() const
+	{
+		return this->samples.size();
+	}
+
+	double mean() const
+	{
+		if (this->samples.empty()) {
+			return 0.0;
+		}
+		return std::accumulate(this->samples.begin(), this->samples.end(), 0.0) / this->samples.size();
+	}
+
+	double standardDeviation() const
+	{
+		if (this->samples.size() < 2) {
+			return 0.0;
+		}
+		auto mean = this->mean();
+		double sum = 0.0;
+		for (auto sample : this->samples) {
+			sum += (sample - mean) * (sample - mean);
+		}
+		return std::sqrt(sum / (this->samples.size() - 1));
+	}
+
+	double min() const
+	{
+		return this->samples.empty() ? 0.0 : this->samples.front();
+	}
+
+	double max() const
+	{
+		return this->samples.empty() ? 0.0 : this->samples.back();
+	}
+
+	// p in [0, 100], linear interpolation between closest ranks
+	double percentile(double p) const
+	{
+		if (this->samples.empty()) {
+			return 0.0;
+		}
+		auto rank = std::clamp(p, 0.0, 100.0) / 100.0 * (this->samples.size() - 1);
+		auto lower = static_cast<size_t>(std::floor(rank));
+		auto upper = std::min(lower + 1, this->samples.size() - 1);
+		return this->samples[lower] + (rank - lower) * (this->samples[upper] - this->samples[lower]);
+	}
+
+	double median() const
+	{
+		return this->percentile(50.0);
+	}
+
+	// Two sided 95% quantile of Student's t distribution with the given degrees of freedom
+	static double getStudentT95(size_t degreesOfFreedom)
+	{
+		static constexpr std::array table{
+			12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+			2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+			2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+		};
+		if (degreesOfFreedom == 0) {
+			return 0.0;
+		}
+		return degreesOfFreedom <= table.size() ? table[degreesOfFreedom - 1] : 1.960;
+	}
+
+	// Half width of the 95% confidence interval of the mean
+	double confidenceInterval95() const
+	{
+		if (this->samples.size() < 2) {
+			return 0.0;
+		}
+		return getStudentT95(this->samples.size() - 1) * this->standardDeviation() / std::sqrt(double(this->samples.size()));
+	}
+
+	// Samples outside Tukey's fences, more than 1.5 interquartile ranges below the first
+	// or above the third quartile
+	size_t outliers() const
+	{
+		auto q1 = this->percentile(25.0);
+		auto q3 = this->percentile(75.0);
+		auto low = q1 - 1.5 * (q3 - q1);
+		auto high = q3 + 1.5 * (q3 - q1);
+		return std::ranges::count_if(this->samples, [&](double sample) { return sample < low || sample > high; });
+	}
+
+	// Sample counts of binCount equally wide bins from min() to max()
+	std::vector<size_t> histogram(size_t binCount) const
+	{
+		std::vector<size_t> bins(binCount, 0);
+		if (this->samples.empty() || binCount == 0) {
+			return bins;
+		}
+		auto width = (this->max() - this->min()) / binCount;
+		for (auto sample : this->samples) {
+			auto bin = width > 0.0 ? static_cast<size_t>((sample - this->min()) / width) : 0;
+			bins[std::min(bin, binCount - 1)]++;
+		}
+		return bins;
+	}
+
+	std::vector<double> samples;
+};
+
+
+struct LinearFit {
+	double slope{ 0.0 };
+	double intercept{ 0.0 };
+	double r2{ 0.0 };		// coefficient of determination
+};
+
+// Least squares fit of y = slope * x + intercept
+inline LinearFit fitLine(const std::vector<double>& x, const std::vector<double>& y)
+{
+	auto n = std::min(x.size(), y.size());
+	if (n < 2) {
+		return {};
+	}
+	double meanX = 0.0;
+	double meanY = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		meanX += x[i];
+		meanY += y[i];
+	}
+	meanX /= n;
+	meanY /= n;
+
+	double sxx = 0.0;
+	double sxy = 0.0;
+	double syy = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		sxx += (x[i] - meanX) * (x[i] - meanX);
+		sxy += (x[i] - meanX) * (y[i] - meanY);
+		syy += (y[i] - meanY) * (y[i] - meanY);
+	}
+	if (sxx == 0.0) {
+		return { .slope = 0.0, .intercept = meanY, .r2 = 0.0 };
+	}
+	LinearFit fit{
+		.slope = sxy / sxx,
+		.intercept = meanY - sxy / sxx * meanX,
+	};
+	fit.r2 = syy > 0.0 ? (sxy * sxy) / (sxx * syy) : 1.0;
+	return fit;
+}
@@ -0,0 +1,513 @@
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <BenchmarkDevice.h>
+#include <SimulatedDriver.h>
+#include <TilePool.h>
+#include <ResidencyManager.h>
+#include <BindCoalescer.h>
+#include <BindSparseBatch.h>
+#include <BindScheduler.h>
+#include <StagingRing.h>
+#include <Benchmark.h>
+
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include <format>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+
+// Tests of the allocation, residency, coalescing, staging and scheduling code, on a
+// simulated device, which also validates every sparse bind. A test throws on the first
+// check that fails, and the program returns EXIT_FAILURE if any test did.
+
+#define CHECK(condition) check(condition, #condition, __LINE__)
+
+inline void check(bool condition, std::string_view expression, int line)
+{
+	if (!condition) {
+		throw Exception(std::format("line {}: check failed: {}", line, expression));
+	}
+}
+
+inline bool isNear(double value, double expected, double tolerance = 1e-9)
+{
+	return std::abs(value - expected) <= tolerance;
+}
+
+// A simulated device without latencies, shared by all tests
+BenchmarkDevice& getDevice()
+{
+	static std::unique_ptr<BenchmarkDevice> device = []() {
+		SimulatedDriver::install(SimulationConfig{
+			.latencyModels = { LatencyModel::Constant },
+			.bindLatency = 0.0,
+			.entryLatency = 0.0,
+			.submitLatency = 0.0,
+		});
+		auto instance = std::make_shared<VulkanInstance>();
+		return std::make_unique<BenchmarkDevice>(instance, instance->getVulkanPhysicalDevices().front());
+	}();
+	return *device;
+}
+
+constexpr VkDeviceSize pageSize = 65536;
+
+// A pool of maxBlocks blocks of pagesPerBlock 64 KiB pages
+std::shared_ptr<TilePool> createTilePool(uint32_t pagesPerBlock, uint32_t maxBlocks)
+{
+	return std::make_shared<TilePool>(getDevice().device, TilePool::Config{
+		.pageSize = pageSize,
+		.blockSize = pagesPerBlock * pageSize,
+		.maxSize = maxBlocks * pagesPerBlock * pageSize,
+		.memoryRequirements = { .size = 0, .alignment = pageSize, .memoryTypeBits = ~0u },
+	});
+}
+
+// 4x4x4 tiles of 64x64x64 texels, each 4 sparse blocks of R8
+struct SparseImage {
+	static constexpr VkExtent3D extent{ 256, 256, 256 };
+	static constexpr VkExtent3D tileExtent{ 64, 64, 64 };
+
+	SparseImage() :
+		image(std::make_shared<VulkanImage>(getDevice().device, VulkanImage::Config{
+			.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT,
+			.imageType = VK_IMAGE_TYPE_3D,
+			.format = VK_FORMAT_R8_SNORM,
+			.extent = extent,
+			.usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+		}))
+	{
+		this->memoryRequirements = getDevice().device->getMemoryRequirements(this->image->image);
+	}
+
+	std::shared_ptr<TilePool> createTilePool(uint32_t tiles) const
+	{
+		return std::make_shared<TilePool>(getDevice().device, TilePool::Config{
+			.pageSize = this->tileSize,
+			.blockSize = tiles * this->tileSize,
+			.maxSize = tiles * this->tileSize,
+			.memoryRequirements = this->memoryRequirements,
+		});
+	}
+
+	// Submits the queued binds of residency and waits for them
+	void submit(ResidencyManager& residency)
+	{
+		auto& device = getDevice();
+		VulkanFence fence(device.device);
+		BindSparseBatch batch;
+		batch.beginBindInfo();
+		batch.addImageBinds(this->image->image, residency.binds);
+		batch.submit(*device.queue, fence.fence);
+		fence.wait();
+		residency.flush();
+	}
+
+	size_t getResidentBlocks() const
+	{
+		return std::ranges::count(SimulatedDriver::get<SimulatedDriver::Image>(this->image->image)->resident, true);
+	}
+
+	std::shared_ptr<VulkanImage> image;
+	VkMemoryRequirements memoryRequirements{};
+	VkDeviceSize tileSize{ 4 * SimulatedDriver::blockSize };
+};
+
+
+void testTilePoolAllocate()
+{
+	auto pool = createTilePool(4, 2);
+
+	// pages of a block are handed out in order of increasing offset, blocks on demand
+	for (uint32_t page = 0; page < 4; page++) {
+		auto allocated = pool->allocate();
+		CHECK(allocated.has_value());
+		CHECK(allocated->id == page);
+		CHECK(allocated->offset == page * pageSize);
+	}
+	CHECK(pool->getBlockCount() == 1);
+	auto fifth = pool->allocate();
+	CHECK(fifth && fifth->id == 4 && fifth->offset == 0);
+	CHECK(pool->getBlockCount() == 2);
+
+	for (uint32_t page = 5; page < 8; page++) {
+		CHECK(pool->allocate().has_value());
+	}
+	CHECK(!pool->allocate().has_value());
+
+	// a freed page is the next one handed out
+	pool->free(pool->getPage(2));
+	auto reused = pool->allocate();
+	CHECK(reused && reused->id == 2);
+
+	auto statistics = pool->getStatistics();
+	CHECK(statistics.blocksAllocated == 2);
+	CHECK(statistics.pagesAllocated == 8);
+	CHECK(statistics.pageCapacity == 8);
+	CHECK(statistics.occupancy() == 1.0);
+}
+
+void testTilePoolTrim()
+{
+	auto pool = createTilePool(2, 3);
+	pool->reserve(3 * 2 * pageSize);
+	CHECK(pool->getBlockCount() == 3);
+
+	auto page = pool->allocate();
+	CHECK(page && page->id == 0);
+	CHECK(pool->getEmptyBlockCount() == 2);
+
+	// the empty blocks beyond the first keepEmpty are released
+	CHECK(pool->trim(1) == 1);
+	CHECK(pool->getBlockCount() == 2);
+	CHECK(pool->blocks[2] == nullptr);
+	CHECK(pool->trim(1) == 0);
+	CHECK(pool->trim(0) == 1);
+	CHECK(pool->getBlockCount() == 1);
+	CHECK(pool->blockReleases == 2);
+
+	// the free pages of released blocks are gone, a new block takes over a released slot
+	CHECK(pool->allocate()->id == 1);
+	auto next = pool->allocate();
+	CHECK(next && next->id / pool->pagesPerBlock == 1);
+	CHECK(pool->getBlockCount() == 2);
+	CHECK(pool->peakBlocks == 3);
+	CHECK(pool->blockAllocations == 4);
+}
+
+void testTilePoolCompaction()
+{
+	auto pool = createTilePool(4, 3);
+	std::vector<TilePage> pages;
+	for (uint32_t i = 0; i < 12; i++) {
+		pages.push_back(*pool->allocate());
+	}
+	// block 0 keeps 3 pages, block 1 one page and block 2 two pages
+	for (auto id : { 3u, 4u, 5u, 6u, 8u, 9u }) {
+		pool->free(pages[id]);
+	}
+	auto statistics = pool->getStatistics();
+	CHECK(statistics.pagesAllocated == 6);
+	CHECK(isNear(statistics.fragmentation(pool->pagesPerBlock), 0.5));
+
+	// the sparsest blocks are retired as long as the others can take their pages. Block 0
+	// and 2 take the page of block 1, but then only one page is free for the two of block 2.
+	auto retired = pool->retireSparseBlocks();
+	CHECK(retired == std::vector<uint32_t>{ 1 });
+	CHECK(pool->isRetired(7));
+	CHECK(!pool->isRetired(10));
+
+	// retired pages are not handed out again, moving their tiles empties the block
+	auto moved = pool->allocate();
+	CHECK(moved && !pool->isRetired(moved->id));
+	pool->free(pages[7]);
+	CHECK(pool->trim(0) == 1);
+	CHECK(pool->getBlockCount() == 2);
+	CHECK(pool->getStatistics().pagesAllocated == 6);
+	CHECK(pool->getStatistics().fragmentation(pool->pagesPerBlock) == 0.25);
+
+	// the block holding the null page is never retired
+	CHECK(pool->retireSparseBlocks(2).empty());
+}
+
+void testResidencyEviction()
+{
+	SparseImage image;
+	auto pool = image.createTilePool(4);
+	ResidencyManager residency(pool, image.extent, image.tileExtent, 1, 64);
+	CHECK(residency.pageTable.tileCount == 64);
+
+	for (uint32_t tile = 0; tile < 4; tile++) {
+		CHECK(residency.request(tile));
+	}
+	CHECK(residency.bindCount == 4 && residency.unbindCount == 0);
+	image.submit(residency);
+	CHECK(image.getResidentBlocks() == 16);
+
+	// a resident tile is only touched, the least recently used one is evicted
+	CHECK(!residency.request(0));
+	CHECK(residency.request(4));
+	CHECK(!residency.pageTable.isResident(1));
+	CHECK(residency.pageTable.isResident(0));
+	CHECK(residency.binds.size() == 2);
+	CHECK(residency.binds[0].memory == VK_NULL_HANDLE);
+	CHECK(residency.binds[1].memory != VK_NULL_HANDLE);
+	CHECK(residency.pages[4] == 1);		// the page of the evicted tile
+	image.submit(residency);
+	CHECK(image.getResidentBlocks() == 16);
+
+	// tiles bound in this submission cannot be evicted in it
+	for (auto tile : { 5u, 6u, 7u, 8u }) {
+		CHECK(residency.request(tile));
+	}
+	bool threw = false;
+	try {
+		residency.request(9);
+	}
+	catch (const Exception&) {
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+void testResidencyReleaseOrder()
+{
+	SparseImage image;
+	auto pool = image.createTilePool(4);
+	ResidencyManager residency(pool, image.extent, image.tileExtent, 1, 64);
+
+	CHECK(residency.request(0));
+	CHECK(residency.request(1));
+	image.submit(residency);
+
+	// a tile released since the last flush has its unbind queued, and requesting it
+	// again has to wait for the next submission
+	residency.release(1);
+	CHECK(residency.isReleasePending(1));
+	CHECK(!residency.isReleasePending(0));
+	CHECK(residency.unbindCount == 1);
+	CHECK(pool->getStatistics().pagesAllocated == 1);
+	if (residency.isReleasePending(1)) {
+		image.submit(residency);
+	}
+	CHECK(!residency.isReleasePending(1));
+	CHECK(image.getResidentBlocks() == 4);
+
+	CHECK(residency.request(1));
+	CHECK(residency.binds.size() == 1 && residency.binds[0].memory != VK_NULL_HANDLE);
+	image.submit(residency);
+	CHECK(image.getResidentBlocks() == 8);
+
+	// eviction counts as a release
+	for (auto tile : { 2u, 3u, 4u }) {
+		CHECK(residency.request(tile));
+	}
+	CHECK(residency.isReleasePending(0));
+	CHECK(residency.isPending(4));
+	CHECK(!residency.isPending(0));
+}
+
+VkSparseImageMemoryBind getBind(const TileCoordinate& tile, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+	return getTileBind(SparseImage::extent, SparseImage::tileExtent, tile, memory, memoryOffset);
+}
+
+void testBindCoalescer()
+{
+	auto tileSize = 4 * SimulatedDriver::blockSize;
+	BindCoalescer coalescer(SparseImage::tileExtent, tileSize);
+	auto memory = reinterpret_cast<VkDeviceMemory>(uintptr_t(1));
+
+	// a 2x2 box of tiles with contiguous memory in x, then y order becomes one bind
+	std::vector<VkSparseImageMemoryBind> binds{
+		getBind({ .x = 1, .y = 1 }, memory, 3 * tileSize),
+		getBind({ .x = 0, .y = 0 }, memory, 0),
+		getBind({ .x = 0, .y = 1 }, memory, 2 * tileSize),
+		getBind({ .x = 1, .y = 0 }, memory, tileSize),
+	};
+	coalescer.coalesce(binds);
+	CHECK(binds.size() == 1);
+	CHECK(binds[0].offset.x == 0 && binds[0].offset.y == 0 && binds[0].offset.z == 0);
+	CHECK(binds[0].extent.width == 128 && binds[0].extent.height == 128 && binds[0].extent.depth == 64);
+	CHECK(binds[0].memoryOffset == 0);
+
+	// memory out of order only merges along x
+	binds = {
+		getBind({ .x = 0, .y = 0 }, memory, 0),
+		getBind({ .x = 1, .y = 0 }, memory, tileSize),
+		getBind({ .x = 0, .y = 1 }, memory, 3 * tileSize),
+	};
+	coalescer.coalesce(binds);
+	CHECK(binds.size() == 2);
+
+	// without mergeBound only unbinds merge, across a row of tiles and not across mip levels
+	binds = {
+		getBind({ .x = 0 }, VK_NULL_HANDLE, 0),
+		getBind({ .x = 1 }, VK_NULL_HANDLE, 0),
+		getBind({ .x = 2 }, VK_NULL_HANDLE, 0),
+		getBind({ .x = 3 }, memory, 0),
+		getBind({ .x = 0, .mipLevel = 1 }, VK_NULL_HANDLE, 0),
+		getBind({ .x = 1, .mipLevel = 1 }, memory, tileSize),
+	};
+	coalescer.coalesce(binds, false);
+	CHECK(binds.size() == 4);
+	auto unbinds = std::ranges::find_if(binds, [](auto& bind) { return bind.memory == VK_NULL_HANDLE && bind.subresource.mipLevel == 0; });
+	CHECK(unbinds != binds.end() && unbinds->extent.width == 192);
+
+	// buffer binds merge where both the buffer and the memory ranges continue
+	std::vector<VkSparseMemoryBind> bufferBinds{
+		{ .resourceOffset = tileSize, .size = tileSize, .memory = memory, .memoryOffset = tileSize },
+		{ .resourceOffset = 0, .size = tileSize, .memory = memory, .memoryOffset = 0 },
+		{ .resourceOffset = 2 * tileSize, .size = tileSize, .memory = memory, .memoryOffset = 5 * tileSize },
+		{ .resourceOffset = 3 * tileSize, .size = tileSize, .memory = VK_NULL_HANDLE, .memoryOffset = 0 },
+		{ .resourceOffset = 4 * tileSize, .size = tileSize, .memory = VK_NULL_HANDLE, .memoryOffset = 0 },
+	};
+	coalescer.coalesce(bufferBinds);
+	CHECK(bufferBinds.size() == 3);
+	auto merged = std::ranges::find_if(bufferBinds, [](auto& bind) { return bind.memory != VK_NULL_HANDLE && bind.resourceOffset == 0; });
+	CHECK(merged != bufferBinds.end() && merged->size == 2 * tileSize);
+	auto unbound = std::ranges::find_if(bufferBinds, [](auto& bind) { return bind.memory == VK_NULL_HANDLE; });
+	CHECK(unbound != bufferBinds.end() && unbound->size == 2 * tileSize);
+}
+
+void testCoalescedBinds()
+{
+	// coalesced unbinds of a whole row of tiles are valid binds of the image
+	SparseImage image;
+	auto pool = image.createTilePool(8);
+	ResidencyManager residency(pool, image.extent, image.tileExtent, 1, 64);
+	for (uint32_t tile = 0; tile < 8; tile++) {
+		residency.request(tile);
+	}
+	image.submit(residency);
+	CHECK(image.getResidentBlocks() == 32);
+
+	for (uint32_t tile = 0; tile < 4; tile++) {
+		residency.release(tile);
+	}
+	BindCoalescer(image.tileExtent, image.tileSize).coalesce(residency.binds, false);
+	CHECK(residency.binds.size() == 1);
+	image.submit(residency);
+	CHECK(image.getResidentBlocks() == 16);
+}
+
+void testStagingRing()
+{
+	StagingRing ring(getDevice().device, 1024);
+	CHECK(ring.data != nullptr);
+
+	auto first = ring.allocate(300, 256);
+	CHECK(first == 0);
+	ring.tag(1);
+	auto second = ring.allocate(300, 256);
+	CHECK(second == 512);
+	ring.tag(2);
+	CHECK(ring.used == 812);
+
+	// the ring is full until the first upload completed
+	CHECK(!ring.allocate(300, 256).has_value());
+	CHECK(ring.getOldestValue() == 1);
+	ring.reclaim(0);
+	CHECK(ring.used == 812);
+	ring.reclaim(1);
+	CHECK(ring.used == 512);
+
+	// wraps around, and the end of the ring is padding of the allocation
+	auto third = ring.allocate(300, 256);
+	CHECK(third == 0);
+	CHECK(ring.used == 1024);
+	CHECK(!ring.allocate(1, 1).has_value());
+
+	// untagged allocations are not reclaimed
+	ring.reclaim(2);
+	CHECK(ring.used == 512);
+	CHECK(!ring.getOldestValue().has_value());
+	ring.reclaim(3);
+	CHECK(ring.used == 512);
+	ring.tag(3);
+	ring.reclaim(3);
+	CHECK(ring.used == 0);
+
+	// an empty ring starts over at its beginning
+	CHECK(ring.allocate(600, 256) == 0);
+}
+
+void testBindLatencyModel()
+{
+	BindLatencyModel model;
+	CHECK(model.getBatchSize(1.0, 64) == 1);
+	CHECK(model.getBatchSize(0.0, 64) == 0);
+
+	// 0.2 ms per batch and 0.01 ms per bind
+	for (auto binds : { 1.0, 2.0, 4.0, 8.0, 16.0, 32.0, 64.0 }) {
+		model.add(binds, 0.2 + 0.01 * binds);
+	}
+	auto [fixed, perBind] = model.getFit();
+	CHECK(isNear(fixed, 0.2));
+	CHECK(isNear(perBind, 0.01));
+	CHECK(isNear(model.predict(100.0), 1.2));
+	CHECK(model.getBatchSize(0.505, 1000) == 30);
+	CHECK(model.getBatchSize(0.505, 16) == 16);
+	// no more than twice the largest batch seen
+	CHECK(model.getBatchSize(10.0, 1000) == 128);
+	CHECK(model.getBatchSize(0.1, 1000) == 0);
+
+	// a single batch size cannot be split into fixed and per bind cost
+	BindLatencyModel constant;
+	for (int i = 0; i < 10; i++) {
+		constant.add(16.0, 0.8);
+	}
+	auto [constantFixed, constantPerBind] = constant.getFit();
+	CHECK(constantFixed == 0.0);
+	CHECK(isNear(constantPerBind, 0.05));
+
+	// older batches decay, so the fit follows a change of the latency
+	for (int i = 0; i < 200; i++) {
+		model.add((i % 2) ? 8.0 : 32.0, 0.4 + 0.02 * ((i % 2) ? 8.0 : 32.0));
+	}
+	auto [newFixed, newPerBind] = model.getFit();
+	CHECK(isNear(newFixed, 0.4, 1e-3));
+	CHECK(isNear(newPerBind, 0.02, 1e-4));
+}
+
+void testCompactionWithUploads()
+{
+	// a small pool of small blocks that the camera path fragments, with every tile uploaded
+	BenchmarkParameters parameters;
+	parameters.imageExtent = { 512, 512, 256 };
+	parameters.memoryPoolSize = VkDeviceSize(16) << 20;
+	parameters.memoryBlockSize = VkDeviceSize(2) << 20;
+	parameters.compactThreshold = 0.2;
+	parameters.residencyMode = ResidencyMode::Churn;
+	parameters.pattern = AccessPattern::Camera;
+	parameters.upload = true;
+	parameters.timeline = true;
+	parameters.stagingSize = VkDeviceSize(4) << 20;
+
+	auto& device = getDevice();
+	SparseBindBenchmark benchmark(device.device, device.queue, parameters, nullptr, device.transferQueue);
+	auto result = benchmark.run(false);
+
+	// moved tiles are rebound without an upload, every requested tile is uploaded once
+	CHECK(!result.compactions.empty());
+	CHECK(std::ranges::any_of(result.compactions, [](auto& compaction) { return compaction.tilesMoved > 0; }));
+	CHECK(result.tileLatencies.size() == result.tilesBound());
+	CHECK(result.uploadBytes == result.tilesBound() * benchmark.tileSize);
+}
+
+int main()
+{
+	std::vector<std::pair<std::string_view, std::function<void()>>> tests{
+		{ "TilePool allocate", testTilePoolAllocate },
+		{ "TilePool trim", testTilePoolTrim },
+		{ "TilePool compaction", testTilePoolCompaction },
+		{ "ResidencyManager eviction", testResidencyEviction },
+		{ "ResidencyManager release order", testResidencyReleaseOrder },
+		{ "BindCoalescer", testBindCoalescer },
+		{ "BindCoalescer binds", testCoalescedBinds },
+		{ "StagingRing", testStagingRing },
+		{ "BindLatencyModel", testBindLatencyModel },
+		{ "CompactionWithUploads", testCompactionWithUploads },
+	};
+
+	int failed = 0;
+	for (auto& [name, test] : tests) {
+		try {
+			test();
+			std::cout << std::format("passed: {}", name) << std::endl;
+		}
+		catch (const std::exception& e) {
+			std::cout << std::format("FAILED: {}: {}", name, e.what()) << std::endl;
+			failed++;
+		}
+	}
+	std::cout << std::format("{} of {} tests passed", tests.size() - failed, tests.size()) << std::endl;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
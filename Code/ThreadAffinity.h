@@ -0,0 +1,36 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <format>
+#include <thread>
+
+
+// Pins the calling thread to a CPU, so that the scheduler does not migrate it between
+// cores during a run and its timings do not include cold caches after a migration
+inline void pinThread(uint32_t cpu)
+{
+	auto cpuCount = std::thread::hardware_concurrency();
+	if (cpuCount > 0 && cpu >= cpuCount) {
+		throw Exception(std::format("can not pin a thread to CPU {} of {}", cpu, cpuCount));
+	}
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	if (cpu >= 64 || SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0) {
+		throw Exception(std::format("could not pin a thread to CPU {}", cpu));
+	}
+#else
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+		throw Exception(std::format("could not pin a thread to CPU {}", cpu));
+	}
+#endif
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <VulkanObjects.h>
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include <optional>
+#include <algorithm>
+
+
+struct TilePage {
+	VkDeviceMemory memory{ VK_NULL_HANDLE };
+	VkDeviceSize offset{ 0 };		// byte offset of the page in memory
+	uint32_t id{ 0 };				// block * pagesPerBlock + page index in block
+};
+
+struct TilePoolStatistics {
+	uint32_t blocksAllocated{ 0 };
+	uint32_t pagesAllocated{ 0 };	// pages in use
+	uint32_t pageCapacity{ 0 };		// pages in all allocated blocks
+	uint32_t blocksInUse{ 0 };		// blocks with at least one page in use
+
+	// fraction of the allocated memory that is in use
+	double occupancy() const
+	{
+		return this->pageCapacity ? double(this->pagesAllocated) / this->pageCapacity : 0.0;
+	}
+
+	// fraction of the pages in partially used blocks that are free. That memory cannot be
+	// returned to the device without moving the pages in use to other blocks.
+	double fragmentation(uint32_t pagesPerBlock) const
+	{
+		auto pagesInUsedBlocks = this->blocksInUse * pagesPerBlock;
+		return pagesInUsedBlocks ? 1.0 - double(this->pagesAllocated) / pagesInUsedBlocks : 0.0;
+	}
+};
+
+
+// Allocates fixed size tile pages from blocks of device memory. Blocks are allocated
+// on demand up to maxSize, and free pages are kept on a stack, so allocate and free
+// are O(1). Pages of a new block are handed out in order of increasing offset.
+//
+// Empty blocks can be released to give their memory back to the device. A released
+// block keeps its slot, so page ids of the other blocks stay valid, and the next block
+// allocated takes the slot over. For compaction, retire() takes blocks out of
+// allocation, so that the tiles on their pages can be moved to other blocks and the
+// blocks released once they are empty.
+class TilePool {
+public:
+	static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+	struct Config {
+		VkDeviceSize pageSize{ 0 };
+		VkDeviceSize blockSize{ 0 };
+		VkDeviceSize maxSize{ 0 };
+		VkMemoryRequirements memoryRequirements{};
+		VkMemoryPropertyFlags memoryFlags{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+	};
+
+	TilePool(std::shared_ptr<VulkanDevice> device, const Config& config) :
+		device(std::move(device)),
+		config(config)
+	{
+		// pages must satisfy the sparse binding alignment, blocks hold a whole number of pages
+		auto alignment = std::max<VkDeviceSize>(config.memoryRequirements.alignment, 1);
+		this->pageSize = (config.pageSize + alignment - 1) / alignment * alignment;
+		this->pagesPerBlock = static_cast<uint32_t>(std::max<VkDeviceSize>(config.blockSize / this->pageSize, 1));
+		this->blockSize = this->pagesPerBlock * this->pageSize;
+		this->maxBlocks = static_cast<uint32_t>(std::max<VkDeviceSize>(config.maxSize / this->blockSize, 1));
+	}
+
+	// A free page, none if the pool is full or the device is out of memory for another block
+	std::optional<TilePage> allocate()
+	{
+		TraceScope scope("allocate page");
+		if (this->freePages.empty()) {
+			try {
+				if (!this->allocateBlock()) {
+					return std::nullopt;
+				}
+			}
+			catch (const VkException& e) {
+				// memory other processes use may leave less than maxSize
+				if (e.error != VK_ERROR_OUT_OF_DEVICE_MEMORY) {
+					throw;
+				}
+				this->allocationFailures++;
+				return std::nullopt;
+			}
+		}
+		auto id = this->freePages.back();
+		this->freePages.pop_back();
+		this->blockUsage[id / this->pagesPerBlock]++;
+		return this->getPage(id);
+	}
+
+	// Pages of retired blocks are not handed out again
+	void free(const TilePage& page)
+	{
+		auto block = page.id / this->pagesPerBlock;
+		this->blockUsage[block]--;
+		if (!this->retired[block]) {
+			this->freePages.push_back(page.id);
+		}
+	}
+
+	// Allocates blocks up front, so that block allocation does not show up in bind timings
+	void reserve(VkDeviceSize size)
+	{
+		while (this->getBlockCount() * this->blockSize < size && this->allocateBlock()) {
+		}
+	}
+
+	// The page with the given id, whether allocated or not
+	TilePage getPage(uint32_t id) const
+	{
+		return {
+			.memory = this->blocks[id / this->pagesPerBlock]->memory,
+			.offset = (id % this->pagesPerBlock) * this->pageSize,
+			.id = id,
+		};
+	}
+
+	// Pages of all block slots, including released ones
+	uint32_t pageCount() const
+	{
+		return static_cast<uint32_t>(this->blocks.size()) * this->pagesPerBlock;
+	}
+
+	// Blocks holding device memory
+	uint32_t getBlockCount() const
+	{
+		return static_cast<uint32_t>(std::ranges::count_if(this->blocks, [](auto& block) { return block != nullptr; }));
+	}
+
+	bool isRetired(uint32_t id) const
+	{
+		return this->retired[id / this->pagesPerBlock];
+	}
+
+	TilePoolStatistics getStatistics() const
+	{
+		TilePoolStatistics statistics{
+			.blocksAllocated = this->getBlockCount(),
+			.pageCapacity = this->getBlockCount() * this->pagesPerBlock,
+		};
+		for (auto usage : this->blockUsage) {
+			statistics.pagesAllocated += usage;
+			statistics.blocksInUse += (usage > 0) ? 1 : 0;
+		}
+		return statistics;
+	}
+
+	bool allocateBlock()
+	{
+		if (this->getBlockCount() >= this->maxBlocks) {
+			return false;
+		}
+		auto memoryRequirements = this->config.memoryRequirements;
+		memoryRequirements.size = this->blockSize;
+		auto memory = std::make_shared<VulkanMemory>(this->device, memoryRequirements, this->config.memoryFlags);
+
+		// the first released slot, else a new one
+		auto block = static_cast<uint32_t>(std::ranges::find(this->blocks, nullptr) - this->blocks.begin());
+		if (block == this->blocks.size()) {
+			this->blocks.emplace_back();
+			this->blockUsage.push_back(0);
+			this->retired.push_back(false);
+		}
+		this->blocks[block] = std::move(memory);
+		this->blockAllocations++;
+		this->peakBlocks = std::max(this->peakBlocks, this->getBlockCount());
+
+		// new pages go to the bottom of the stack in reverse order, so pages are handed
+		// out block by block in order of increasing offset, after pages already freed
+		std::vector<uint32_t> pages(this->pagesPerBlock);
+		for (uint32_t page = 0; page < this->pagesPerBlock; page++) {
+			pages[page] = block * this->pagesPerBlock + this->pagesPerBlock - 1 - page;
+		}
+		this->freePages.insert(this->freePages.begin(), pages.begin(), pages.end());
+		return true;
+	}
+
+	// Takes the free pages of a block out of allocation
+	void retire(uint32_t block)
+	{
+		this->retired[block] = true;
+		std::erase_if(this->freePages, [&](uint32_t id) { return id / this->pagesPerBlock == block; });
+	}
+
+	// Frees the memory of an empty block. None of its pages may be bound anymore, and the
+	// unbinds of tiles that were on them have to be complete.
+	void releaseBlock(uint32_t block)
+	{
+		TraceScope scope("release block", block);
+		if (!this->retired[block]) {
+			this->retire(block);
+		}
+		this->blocks[block] = nullptr;
+		this->retired[block] = false;
+		this->blockReleases++;
+	}
+
+	// Releases the empty retired blocks and the other empty blocks beyond the first
+	// keepEmpty, so that the blocks left take the lowest slots. Returns the number of
+	// blocks released.
+	uint32_t trim(uint32_t keepEmpty)
+	{
+		uint32_t released = 0;
+		uint32_t empty = 0;
+		for (uint32_t block = 0; block < this->blocks.size(); block++) {
+			if (!this->blocks[block] || this->blockUsage[block] > 0) {
+				continue;
+			}
+			if (this->retired[block] || ++empty > keepEmpty) {
+				this->releaseBlock(block);
+				released++;
+			}
+		}
+		return released;
+	}
+
+	uint32_t getEmptyBlockCount() const
+	{
+		uint32_t empty = 0;
+		for (uint32_t block = 0; block < this->blocks.size(); block++) {
+			empty += (this->blocks[block] && this->blockUsage[block] == 0) ? 1 : 0;
+		}
+		return empty;
+	}
+
+	// Retires the partially used blocks with the fewest pages in use, as many as the free
+	// pages of the fuller blocks can take the pages of. Empty blocks do not take pages,
+	// they should be trimmed first, and keepBlock is never retired. Returns the retired
+	// blocks, whose pages in use have to be moved before they can be released.
+	std::vector<uint32_t> retireSparseBlocks(uint32_t keepBlock = none)
+	{
+		std::vector<uint32_t> candidates;
+		uint32_t freeElsewhere = 0;
+		for (uint32_t block = 0; block < this->blocks.size(); block++) {
+			if (!this->blocks[block] || this->retired[block] || this->blockUsage[block] == 0) {
+				continue;
+			}
+			freeElsewhere += this->pagesPerBlock - this->blockUsage[block];
+			if (block != keepBlock && this->blockUsage[block] < this->pagesPerBlock) {
+				candidates.push_back(block);
+			}
+		}
+		std::ranges::sort(candidates, [&](uint32_t lhs, uint32_t rhs) { return this->blockUsage[lhs] < this->blockUsage[rhs]; });
+
+		std::vector<uint32_t> retiring;
+		uint32_t moved = 0;
+		for (auto block : candidates) {
+			auto used = this->blockUsage[block];
+			auto free = this->pagesPerBlock - used;
+			if (freeElsewhere - free < moved + used) {
+				break;
+			}
+			freeElsewhere -= free;
+			moved += used;
+			retiring.push_back(block);
+		}
+		for (auto block : retiring) {
+			this->retire(block);
+		}
+		return retiring;
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	Config config;
+	VkDeviceSize pageSize{ 0 };
+	VkDeviceSize blockSize{ 0 };
+	uint32_t pagesPerBlock{ 0 };
+	uint32_t maxBlocks{ 0 };
+	std::vector<std::shared_ptr<VulkanMemory>> blocks;	// nullptr for released blocks
+	std::vector<uint32_t> blockUsage;		// pages in use per block
+	std::vector<bool> retired;				// per block, whether its pages are not handed out
+	std::vector<uint32_t> freePages;
+	uint32_t peakBlocks{ 0 };				// most blocks allocated at once
+	uint32_t blockAllocations{ 0 };
+	uint32_t blockReleases{ 0 };
+	uint32_t allocationFailures{ 0 };		// blocks the device had no memory for
+};
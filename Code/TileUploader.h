@@ -0,0 +1,272 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <StagingRing.h>
+#include <BrickedVolume.h>
+
+#include <mutex>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <stop_token>
+#include <condition_variable>
+
+
+// Streams the contents of freshly bound tiles to a sparse image: every tile is written
+// to a StagingRing and copied with vkCmdCopyBufferToImage on a transfer queue, in one
+// submission per bind submission, which waits for the timeline value the binds signal.
+// Uploads signal the values of the uploader's own timeline semaphore, whose completion
+// a waiter thread timestamps, so that the time from a tile's request until it can be
+// sampled is measured without polling. Binds that unbind or rebind pages wait for the
+// last upload submitted before them, since a copy into such a page may still run. The image is moved to the general layout by the
+// first upload, and stays there for copies and sampling alike. With a volume reader,
+// tiles are read from the volume into staging, whole tiles even where the bind is
+// clipped at the edge of a level, and every upload waits for the reads of its tiles.
+class TileUploader {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr uint32_t commandBufferCount = 16;		// uploads in flight
+	static constexpr VkDeviceSize copyAlignment = 16;		// satisfies the texel size of every format
+
+	struct Tile {
+		Clock::time_point requestTime;
+		uint64_t value{ 0 };		// of the upload copying it
+	};
+
+	TileUploader(
+		std::shared_ptr<VulkanDevice> device,
+		std::shared_ptr<VulkanQueue> queue,
+		VkImage image,
+		const FormatInfo& formatInfo,
+		VkDeviceSize stagingSize,
+		std::shared_ptr<BrickedVolumeReader> reader = nullptr) :
+		device(std::move(device)),
+		queue(std::move(queue)),
+		image(image),
+		formatInfo(formatInfo),
+		stagingRing(this->device, stagingSize),
+		reader(std::move(reader))
+	{
+		this->commandPool = std::make_shared<VulkanCommandPool>(this->device, this->queue->queueFamilyIndex,
+			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+		for (uint32_t i = 0; i < commandBufferCount; i++) {
+			this->commandBuffers.push_back(std::make_shared<VulkanCommandBuffer>(this->commandPool));
+		}
+		this->semaphore = std::make_shared<VulkanSemaphore>(this->device);
+		this->waiter = std::jthread([this](std::stop_token stop) { this->waitForUploads(stop); });
+	}
+
+	// Writes the tile of a bind to staging and queues its copy. Waits for earlier uploads
+	// when staging is full.
+	void addTile(const VkSparseImageMemoryBind& bind, Clock::time_point requestTime)
+	{
+		TraceScope scope("stage tile", this->tiles.size());
+		auto size = this->reader ? this->reader->header.tileSize :
+			this->formatInfo.getSize(bind.extent);
+		auto offset = this->stagingRing.allocate(size, copyAlignment);
+		while (!offset) {
+			auto value = this->stagingRing.getOldestValue();
+			if (!value) {
+				throw Exception(std::format("the staging ring of {} bytes is smaller than a submission of tiles.", this->stagingRing.size));
+			}
+			this->semaphore->wait(*value);
+			this->stagingRing.reclaim(*value);
+			offset = this->stagingRing.allocate(size, copyAlignment);
+		}
+
+		VkExtent3D bufferExtent{ 0, 0, 0 };		// tightly packed
+		if (this->reader) {
+			Timer timer;
+			auto& tileExtent = this->reader->header.tileExtent;
+			bufferExtent = tileExtent;
+			this->reader->read({
+				.x = uint32_t(bind.offset.x) / tileExtent.width,
+				.y = uint32_t(bind.offset.y) / tileExtent.height,
+				.z = bind.subresource.arrayLayer + uint32_t(bind.offset.z) / tileExtent.depth,
+				.mipLevel = bind.subresource.mipLevel,
+			}, this->stagingRing.data + *offset);
+			this->readTime += timer.getElapsedTimeMilliseconds();
+		}
+		else {
+			// stands in for tile data decoded from disk
+			std::memset(this->stagingRing.data + *offset, static_cast<int>(this->tiles.size() & 0xff), size);
+		}
+		this->regions.push_back(VkBufferImageCopy{
+			.bufferOffset = *offset,
+			.bufferRowLength = bufferExtent.width,
+			.bufferImageHeight = bufferExtent.height,
+			.imageSubresource = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = bind.subresource.mipLevel,
+				.baseArrayLayer = bind.subresource.arrayLayer,
+				.layerCount = 1,
+			},
+			.imageOffset = bind.offset,
+			.imageExtent = bind.extent,
+		});
+		this->tiles.push_back({ .requestTime = requestTime, .value = 0 });
+		this->bytes += size;
+	}
+
+	// Submits the copies queued since the last submission, once bindSemaphore reaches bindValue
+	void submit(VkSemaphore bindSemaphore, uint64_t bindValue)
+	{
+		if (this->regions.empty()) {
+			return;
+		}
+		auto value = this->value + 1;
+		TraceScope scope("upload", value);
+
+		if (this->reader) {
+			Timer timer;
+			this->reader->wait();
+			this->readTime += timer.getElapsedTimeMilliseconds();
+		}
+
+		// the command buffer was last used by the upload commandBufferCount before this one
+		if (value > commandBufferCount) {
+			this->semaphore->wait(value - commandBufferCount);
+		}
+		auto& commandBuffer = *this->commandBuffers[value % commandBufferCount];
+		commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		if (value == 1) {
+			VkImageMemoryBarrier imageBarrier{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = 0,
+				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+				.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = this->image,
+				.subresourceRange = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.baseMipLevel = 0,
+					.levelCount = VK_REMAINING_MIP_LEVELS,
+					.baseArrayLayer = 0,
+					.layerCount = VK_REMAINING_ARRAY_LAYERS,
+				},
+			};
+			vkCmdPipelineBarrier(commandBuffer.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+		}
+		else {
+			// a tile that was evicted and requested again is written by more than one upload
+			VkMemoryBarrier memoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			};
+			vkCmdPipelineBarrier(commandBuffer.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		}
+		vkCmdCopyBufferToImage(commandBuffer.commandBuffer, this->stagingRing.buffer->buffer, this->image, VK_IMAGE_LAYOUT_GENERAL,
+			static_cast<uint32_t>(this->regions.size()), this->regions.data());
+		commandBuffer.end();
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		VkTimelineSemaphoreSubmitInfo timelineInfo{
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreValueCount = 1,
+			.pWaitSemaphoreValues = &bindValue,
+			.signalSemaphoreValueCount = 1,
+			.pSignalSemaphoreValues = &value,
+		};
+		VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = &timelineInfo,
+			.waitSemaphoreCount = 1,
+			.pWaitSemaphores = &bindSemaphore,
+			.pWaitDstStageMask = &waitStage,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &commandBuffer.commandBuffer,
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &this->semaphore->semaphore,
+		};
+		this->queue->submit(std::span(&submitInfo, 1));
+
+		this->stagingRing.tag(value);
+		for (auto tile = this->tiles.rbegin(); tile != this->tiles.rend() && tile->value == 0; tile++) {
+			tile->value = value;
+		}
+		this->regions.clear();
+		{
+			std::lock_guard lock(this->mutex);
+			this->value = value;
+		}
+		this->submitted.notify_one();
+	}
+
+	// Waits until every upload submitted so far completed
+	void wait()
+	{
+		if (this->value > 0) {
+			this->semaphore->wait(this->value);
+		}
+	}
+
+	// Waits for all uploads, and returns the ms from request until the upload completed of every tile
+	std::vector<double> getLatencies()
+	{
+		this->wait();
+		std::unique_lock lock(this->mutex);
+		this->completed.wait(lock, [this]() { return this->completionTimes.size() == this->value; });
+
+		std::vector<double> latencies;
+		latencies.reserve(this->tiles.size());
+		for (auto& tile : this->tiles) {
+			if (tile.value > 0) {
+				latencies.push_back(std::chrono::duration<double, std::milli>(this->completionTimes[tile.value - 1] - tile.requestTime).count());
+			}
+		}
+		return latencies;
+	}
+
+	// Timestamps the completion of every upload, in order
+	void waitForUploads(std::stop_token stop)
+	{
+		Trace::setThreadName("upload waiter");
+		for (uint64_t value = 1;; value++) {
+			{
+				std::unique_lock lock(this->mutex);
+				if (!this->submitted.wait(lock, stop, [&]() { return this->value >= value; })) {
+					return;
+				}
+			}
+			this->semaphore->wait(value);
+			auto time = Clock::now();
+			{
+				std::lock_guard lock(this->mutex);
+				this->completionTimes.push_back(time);
+			}
+			this->completed.notify_all();
+		}
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	std::shared_ptr<VulkanQueue> queue{ nullptr };
+	VkImage image{ VK_NULL_HANDLE };
+	FormatInfo formatInfo{};
+	StagingRing stagingRing;
+	std::shared_ptr<BrickedVolumeReader> reader{ nullptr };		// of the tile contents, else they are a fill pattern
+	std::shared_ptr<VulkanCommandPool> commandPool{ nullptr };
+	std::vector<std::shared_ptr<VulkanCommandBuffer>> commandBuffers;
+	std::shared_ptr<VulkanSemaphore> semaphore{ nullptr };
+	std::vector<VkBufferImageCopy> regions;		// of the upload being collected
+	std::vector<Tile> tiles;					// every tile uploaded, in order
+	VkDeviceSize bytes{ 0 };					// uploaded in total
+	double readTime{ 0.0 };						// ms spent reading tiles and waiting for reads, with a reader
+	uint64_t value{ 0 };						// of the last upload submitted
+	std::mutex mutex;							// guards value and completionTimes
+	std::condition_variable_any submitted;
+	std::condition_variable completed;
+	std::vector<Clock::time_point> completionTimes;		// of every upload, seen by the waiter thread
+	std::jthread waiter;						// destroyed first, which stops it
+};
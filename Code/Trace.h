@@ -0,0 +1,189 @@
+#pragma once
+
+#include <JsonWriter.h>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <format>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+
+
+// Scoped events of every thread, exported as Chrome trace JSON for chrome://tracing or
+// ui.perfetto.dev, so that a stall shows which threads were blocked while it lasted.
+// Every thread records into its own ring without locks, and a ring keeps the latest
+// ringSize events when it overflows. Tracing is off until enable(), and while it is
+// off a TraceScope costs a relaxed atomic load. Rings live until the program exits,
+// so that the events of threads that finished are exported too.
+class Trace {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr size_t ringSize = size_t(1) << 16;		// events per thread
+
+	struct Event {
+		const char* name{ nullptr };	// a string literal
+		Clock::time_point begin;
+		Clock::time_point end;
+		uint64_t argument{ 0 };
+	};
+
+	struct Ring {
+		uint32_t threadId{ 0 };
+		std::string threadName;
+		std::vector<Event> events = std::vector<Event>(ringSize);
+		std::atomic<uint64_t> count{ 0 };		// events recorded, of which the latest ringSize are kept
+	};
+
+	static void enable()
+	{
+		start = Clock::now();
+		enabled.store(true, std::memory_order_relaxed);
+	}
+
+	static bool isEnabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	// The ring of the calling thread, created on first use
+	static Ring& getRing()
+	{
+		thread_local Ring* ring = nullptr;
+		if (!ring) {
+			std::lock_guard lock(mutex);
+			rings.push_back(std::make_unique<Ring>());
+			ring = rings.back().get();
+			ring->threadId = static_cast<uint32_t>(rings.size());
+			ring->threadName = std::format("thread {}", ring->threadId);
+		}
+		return *ring;
+	}
+
+	// Names the calling thread in the trace
+	static void setThreadName(std::string name)
+	{
+		if (!isEnabled()) {
+			return;
+		}
+		auto& ring = getRing();
+		std::lock_guard lock(mutex);
+		ring.threadName = std::move(name);
+	}
+
+	static void record(const char* name, Clock::time_point begin, Clock::time_point end, uint64_t argument)
+	{
+		auto& ring = getRing();
+		auto count = ring.count.load(std::memory_order_relaxed);
+		ring.events[count % ringSize] = { .name = name, .begin = begin, .end = end, .argument = argument };
+		ring.count.store(count + 1, std::memory_order_release);
+	}
+
+	static double toMicroseconds(Clock::time_point time)
+	{
+		return std::chrono::duration<double, std::micro>(time - start).count();
+	}
+
+	// Writes the events of all threads as complete events, with the thread names as
+	// metadata, and returns the number of events written. The traced threads have to
+	// be idle or finished, since their rings are read without synchronizing with them.
+	static size_t write(const std::filesystem::path& path)
+	{
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			throw std::runtime_error(std::format("could not open {} for writing", path.string()));
+		}
+		std::lock_guard lock(mutex);
+		size_t written = 0;
+		JsonWriter json(file);
+		json.beginObject();
+		json.value("displayTimeUnit", "ms");
+		json.beginArray("traceEvents");
+		for (auto& ring : rings) {
+			json.beginRow();
+			json.value("name", "thread_name");
+			json.value("ph", "M");
+			json.value("pid", 1);
+			json.value("tid", ring->threadId);
+			json.beginObject("args");
+			json.value("name", ring->threadName);
+			json.endObject();
+			json.endRow();
+
+			auto count = ring->count.load(std::memory_order_acquire);
+			auto first = (count > ringSize) ? count - ringSize : 0;
+			if (first > 0) {
+				json.beginRow();
+				json.value("name", "events dropped");
+				json.value("ph", "i");
+				json.value("s", "t");
+				json.value("ts", toMicroseconds(ring->events[first % ringSize].begin));
+				json.value("pid", 1);
+				json.value("tid", ring->threadId);
+				json.beginObject("args");
+				json.value("count", first);
+				json.endObject();
+				json.endRow();
+			}
+			for (auto i = first; i < count; i++) {
+				auto& event = ring->events[i % ringSize];
+				json.beginRow();
+				json.value("name", event.name);
+				json.value("ph", "X");
+				json.value("ts", toMicroseconds(event.begin));
+				json.value("dur", std::chrono::duration<double, std::micro>(event.end - event.begin).count());
+				json.value("pid", 1);
+				json.value("tid", ring->threadId);
+				if (event.argument != 0) {
+					json.beginObject("args");
+					json.value("value", event.argument);
+					json.endObject();
+				}
+				json.endRow();
+				written++;
+			}
+		}
+		json.endArray();
+		json.endObject();
+		return written;
+	}
+
+	static inline std::atomic<bool> enabled{ false };
+	static inline Clock::time_point start;
+	static inline std::mutex mutex;		// guards rings and the thread names
+	static inline std::vector<std::unique_ptr<Ring>> rings;
+};
+
+
+// Records an event from its construction until its destruction, with an optional
+// argument shown in the trace, e.g. TraceScope scope("vkQueueBindSparse", bindInfoCount);
+class TraceScope {
+public:
+	explicit TraceScope(const char* name, uint64_t argument = 0) :
+		name(name),
+		argument(argument)
+	{
+		if (Trace::isEnabled()) {
+			this->begin = Trace::Clock::now();
+		}
+	}
+
+	~TraceScope()
+	{
+		if (this->begin != Trace::Clock::time_point()) {
+			Trace::record(this->name, this->begin, Trace::Clock::now(), this->argument);
+		}
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+	const char* name{ nullptr };
+	uint64_t argument{ 0 };
+	Trace::Clock::time_point begin;		// default while tracing is off
+};
@@ -8,12 +8,16 @@
 #endif
 
 #include <vulkan/vk_enum_string_helper.h>
+#include <Trace.h>
 
+#include <span>
 #include <vector>
 #include <format>
 #include <chrono>
 #include <memory>
 #include <string>
+#include <optional>
+#include <string_view>
 #include <iostream>
 #include <stdexcept>
 
@@ -53,12 +57,40 @@ public:
 		vkGetPhysicalDeviceFeatures(this->physicalDevice, &this->physicalDeviceFeatures);
 		vkGetPhysicalDeviceProperties(this->physicalDevice, &this->physicalDeviceProperties);
 
+		// timeline semaphores are core in Vulkan 1.2, whose feature structure older devices do not know
+		if (this->physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+			VkPhysicalDeviceVulkan12Features vulkan12Features{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+				.pNext = nullptr,
+			};
+			VkPhysicalDeviceFeatures2 features{
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+				.pNext = &vulkan12Features,
+			};
+			vkGetPhysicalDeviceFeatures2(this->physicalDevice, &features);
+			this->timelineSemaphore = vulkan12Features.timelineSemaphore;
+		}
+
 		uint32_t count;
 		vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &count, nullptr);
 		this->physicalDeviceQueueFamilyProperties.resize(count);
 		vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &count, this->physicalDeviceQueueFamilyProperties.data());
 
 		this->queuePriorities.resize(this->physicalDeviceQueueFamilyProperties.size());
+
+		THROW_ON_VULKAN_ERROR(vkEnumerateDeviceExtensionProperties(this->physicalDevice, nullptr, &count, nullptr));
+		this->extensionProperties.resize(count);
+		THROW_ON_VULKAN_ERROR(vkEnumerateDeviceExtensionProperties(this->physicalDevice, nullptr, &count, this->extensionProperties.data()));
+	}
+
+	bool hasExtension(std::string_view name) const
+	{
+		for (auto& properties : this->extensionProperties) {
+			if (name == properties.extensionName) {
+				return true;
+			}
+		}
+		return false;
 	}
 
 	std::string deviceName() const
@@ -105,6 +137,20 @@ public:
 		return imageformatproperties;
 	}
 
+	std::vector<VkSparseImageFormatProperties> getSparseImageFormatProperties(
+		VkFormat format,
+		VkImageType type,
+		VkSampleCountFlagBits samples,
+		VkImageUsageFlags usage,
+		VkImageTiling tiling) const
+	{
+		uint32_t count;
+		vkGetPhysicalDeviceSparseImageFormatProperties(this->physicalDevice, format, type, samples, usage, tiling, &count, nullptr);
+		std::vector<VkSparseImageFormatProperties> properties(count);
+		vkGetPhysicalDeviceSparseImageFormatProperties(this->physicalDevice, format, type, samples, usage, tiling, &count, properties.data());
+		return properties;
+	}
+
 	uint32_t getMemoryTypeIndex(uint32_t memoryTypeBits, VkMemoryPropertyFlags required_flags) const
 	{
 		// memoryTypeBits is a bitmaskand contains one bit set for every supported memory type for the resource. Bit i is set if and only if
@@ -120,6 +166,52 @@ public:
 		throw Exception("VulkanDevice::getMemoryTypeIndex: could not find suitable memory type");
 	}
 
+	uint32_t getMemoryHeapIndex(uint32_t memoryTypeBits, VkMemoryPropertyFlags required_flags) const
+	{
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		vkGetPhysicalDeviceMemoryProperties(this->physicalDevice, &memory_properties);
+		return memory_properties.memoryTypes[this->getMemoryTypeIndex(memoryTypeBits, required_flags)].heapIndex;
+	}
+
+	VkDeviceSize getMemoryHeapSize(uint32_t heapIndex) const
+	{
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		vkGetPhysicalDeviceMemoryProperties(this->physicalDevice, &memory_properties);
+		return memory_properties.memoryHeaps[heapIndex].size;
+	}
+
+	struct MemoryBudget {
+		VkDeviceSize budget{ 0 };		// bytes the process can allocate from the heap, including what it uses
+		VkDeviceSize usage{ 0 };		// bytes the process uses
+
+		VkDeviceSize available() const
+		{
+			return this->budget > this->usage ? this->budget - this->usage : 0;
+		}
+	};
+
+	// The budget of a heap as VK_EXT_memory_budget reports it, which accounts for the
+	// memory other processes use, none without the extension
+	std::optional<MemoryBudget> getMemoryBudget(uint32_t heapIndex) const
+	{
+		if (!this->hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+			return std::nullopt;
+		}
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+			.pNext = nullptr,
+		};
+		VkPhysicalDeviceMemoryProperties2 memoryProperties{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+			.pNext = &budgetProperties,
+		};
+		vkGetPhysicalDeviceMemoryProperties2(this->physicalDevice, &memoryProperties);
+		return MemoryBudget{
+			.budget = budgetProperties.heapBudget[heapIndex],
+			.usage = budgetProperties.heapUsage[heapIndex],
+		};
+	}
+
 	uint32_t getQueueFamilyIndex(VkQueueFlags required_flags, const std::vector<VkBool32>& filter) const
 	{
 		// check for exact match of required flags
@@ -148,6 +240,13 @@ public:
 		return this->getQueueFamilyIndex(required_flags, filter);
 	}
 
+	uint32_t getAvailableQueueCount(uint32_t queueFamilyIndex) const
+	{
+		auto max_queue_count = this->physicalDeviceQueueFamilyProperties[queueFamilyIndex].queueCount;
+		auto current_queue_count = static_cast<uint32_t>(this->queuePriorities[queueFamilyIndex].size());
+		return max_queue_count - current_queue_count;
+	}
+
 	uint32_t addQueue(uint32_t queueFamilyIndex, float priority = 1.0f, VkDeviceQueueCreateFlags flags = 0)
 	{
 		auto max_queue_count = this->physicalDeviceQueueFamilyProperties[queueFamilyIndex].queueCount;
@@ -184,6 +283,8 @@ public:
 	std::vector<VkQueueFamilyProperties> physicalDeviceQueueFamilyProperties;
 	std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos;
 	std::vector<std::vector<float>> queuePriorities;
+	std::vector<VkExtensionProperties> extensionProperties;
+	VkBool32 timelineSemaphore{ VK_FALSE };
 };
 
 
@@ -256,18 +357,34 @@ public:
 		instance(std::move(instance)),
 		physicalDevice(std::move(physicalDevice))
 	{
+		// block-compressed formats, sparse buffers and aliased residency, for tiles sharing
+		// a page, where the device supports them
 		VkPhysicalDeviceFeatures physicalDeviceFeatures{
+			.textureCompressionBC = this->physicalDevice->physicalDeviceFeatures.textureCompressionBC,
 			.sparseBinding = VK_TRUE,
+			.sparseResidencyBuffer = this->physicalDevice->physicalDeviceFeatures.sparseResidencyBuffer,
 			.sparseResidencyImage2D = VK_TRUE,
 			.sparseResidencyImage3D = VK_TRUE,
+			.sparseResidencyAliased = this->physicalDevice->physicalDeviceFeatures.sparseResidencyAliased,
+		};
+
+		// only chained for Vulkan 1.2 devices, which all support timeline semaphores
+		VkPhysicalDeviceVulkan12Features physicalDeviceVulkan12Features{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+			.pNext = nullptr,
+			.timelineSemaphore = VK_TRUE,
 		};
 
 		std::vector<const char*> enabledLayerNames{};
 		std::vector<const char*> enabledExtensionNames{ VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME };
+		// for memory budget queries, where the device supports it
+		if (this->physicalDevice->hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+			enabledExtensionNames.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
 
 		VkDeviceCreateInfo createInfo{
 			.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-			.pNext = nullptr,
+			.pNext = this->physicalDevice->timelineSemaphore ? &physicalDeviceVulkan12Features : nullptr,
 			.flags = 0,
 			.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
 			.pQueueCreateInfos = queueCreateInfos.data(),
@@ -288,6 +405,22 @@ public:
 		return memory_requirements;
 	}
 
+	VkMemoryRequirements getMemoryRequirements(VkBuffer buffer)
+	{
+		VkMemoryRequirements memory_requirements;
+		vkGetBufferMemoryRequirements(this->device, buffer, &memory_requirements);
+		return memory_requirements;
+	}
+
+	std::vector<VkSparseImageMemoryRequirements> getSparseMemoryRequirements(VkImage image)
+	{
+		uint32_t count;
+		vkGetImageSparseMemoryRequirements(this->device, image, &count, nullptr);
+		std::vector<VkSparseImageMemoryRequirements> sparseMemoryRequirements(count);
+		vkGetImageSparseMemoryRequirements(this->device, image, &count, sparseMemoryRequirements.data());
+		return sparseMemoryRequirements;
+	}
+
 	~VulkanDevice()
 	{
 		vkDestroyDevice(this->device, nullptr);
@@ -320,22 +453,99 @@ public:
 
 	void waitAndReset()
 	{
+		this->wait();
+		this->reset();
+	}
+
+	void wait()
+	{
+		TraceScope scope("vkWaitForFences");
 		THROW_ON_VULKAN_ERROR(vkWaitForFences(this->device->device, 1, &this->fence, VK_TRUE, UINT64_MAX));
+	}
+
+	void reset()
+	{
 		THROW_ON_VULKAN_ERROR(vkResetFences(this->device->device, 1, &this->fence));
 	}
 
+	bool isSignaled() const
+	{
+		VkResult result = vkGetFenceStatus(this->device->device, this->fence);
+		if (result != VK_SUCCESS && result != VK_NOT_READY) {
+			throw VkException(result);
+		}
+		return result == VK_SUCCESS;
+	}
+
 	std::shared_ptr<VulkanDevice> device{ nullptr };
 	VkFence fence{ nullptr };
 };
 
 
+// A timeline semaphore, whose value only grows. Submissions wait for and signal values.
+class VulkanSemaphore {
+public:
+	VulkanSemaphore(std::shared_ptr<VulkanDevice> device, uint64_t initialValue = 0) :
+		device(std::move(device))
+	{
+		VkSemaphoreTypeCreateInfo typeCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = initialValue,
+		};
+
+		VkSemaphoreCreateInfo createInfo{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &typeCreateInfo,
+			.flags = 0,
+		};
+
+		THROW_ON_VULKAN_ERROR(vkCreateSemaphore(this->device->device, &createInfo, nullptr, &this->semaphore));
+	}
+
+	~VulkanSemaphore()
+	{
+		vkDestroySemaphore(this->device->device, this->semaphore, nullptr);
+	}
+
+	void wait(uint64_t value)
+	{
+		TraceScope scope("vkWaitSemaphores", value);
+		VkSemaphoreWaitInfo waitInfo{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.semaphoreCount = 1,
+			.pSemaphores = &this->semaphore,
+			.pValues = &value,
+		};
+		THROW_ON_VULKAN_ERROR(vkWaitSemaphores(this->device->device, &waitInfo, UINT64_MAX));
+	}
+
+	uint64_t getValue() const
+	{
+		uint64_t value;
+		THROW_ON_VULKAN_ERROR(vkGetSemaphoreCounterValue(this->device->device, this->semaphore, &value));
+		return value;
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	VkSemaphore semaphore{ nullptr };
+};
+
+
+// Queues are externally synchronized. The benchmarks give every thread queues of its
+// own, so that no thread waits for another one's submissions in the application.
 class VulkanQueue {
 public:
 	VulkanQueue(
 		std::shared_ptr<VulkanDevice> device,
 		uint32_t queueFamilyIndex,
 		uint32_t queueIndex) :
-		device(std::move(device))
+		device(std::move(device)),
+		queueFamilyIndex(queueFamilyIndex),
+		queueIndex(queueIndex)
 	{
 		vkGetDeviceQueue(this->device->device, queueFamilyIndex, queueIndex, &this->queue);
 	}
@@ -358,10 +568,45 @@ public:
 			.signalSemaphoreCount = 0,
 			.pSignalSemaphores = nullptr,
 		};
-		THROW_ON_VULKAN_ERROR(vkQueueBindSparse(this->queue, 1, &bindSparseInfo, fence));
+		this->bindSparse(bindSparseInfo, fence);
+	}
+
+	void bindSparse(const VkBindSparseInfo& bindSparseInfo, VkFence fence = VK_NULL_HANDLE)
+	{
+		this->bindSparse(std::span(&bindSparseInfo, 1), fence);
+	}
+
+	void bindSparse(std::span<const VkBindSparseInfo> bindSparseInfos, VkFence fence = VK_NULL_HANDLE)
+	{
+		THROW_ON_VULKAN_ERROR(vkQueueBindSparse(this->queue, static_cast<uint32_t>(bindSparseInfos.size()), bindSparseInfos.data(), fence));
+	}
+
+	// Submits an empty batch, which only signals the fence once the queue reaches it
+	void submit(VkFence fence)
+	{
+		VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreCount = 0,
+			.pWaitSemaphores = nullptr,
+			.pWaitDstStageMask = nullptr,
+			.commandBufferCount = 0,
+			.pCommandBuffers = nullptr,
+			.signalSemaphoreCount = 0,
+			.pSignalSemaphores = nullptr,
+		};
+		this->submit(std::span(&submitInfo, 1), fence);
+	}
+
+	void submit(std::span<const VkSubmitInfo> submitInfos, VkFence fence = VK_NULL_HANDLE)
+	{
+		TraceScope scope("vkQueueSubmit", submitInfos.size());
+		THROW_ON_VULKAN_ERROR(vkQueueSubmit(this->queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), fence));
 	}
 
 	std::shared_ptr<VulkanDevice> device{ nullptr };
+	uint32_t queueFamilyIndex;
+	uint32_t queueIndex;
 	VkQueue queue;
 };
 
@@ -417,6 +662,49 @@ public:
 };
 
 
+class VulkanBuffer {
+public:
+	struct Config {
+		VkBufferCreateFlags flags{ 0 };
+		VkDeviceSize size{ 0 };
+		VkBufferUsageFlags usage{ 0 };
+		VkSharingMode sharingMode{ VK_SHARING_MODE_EXCLUSIVE };
+		std::vector<uint32_t> queueFamilyIndices;
+	};
+
+	VulkanBuffer(std::shared_ptr<VulkanDevice> device, const Config& config) :
+		device(std::move(device))
+	{
+		VkBufferCreateInfo createInfo{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = config.flags,
+			.size = config.size,
+			.usage = config.usage,
+			.sharingMode = config.sharingMode,
+			.queueFamilyIndexCount = static_cast<uint32_t>(config.queueFamilyIndices.size()),
+			.pQueueFamilyIndices = config.queueFamilyIndices.data(),
+		};
+
+		THROW_ON_VULKAN_ERROR(vkCreateBuffer(this->device->device, &createInfo, nullptr, &this->buffer));
+	}
+
+	~VulkanBuffer()
+	{
+		vkDestroyBuffer(this->device->device, this->buffer, nullptr);
+	}
+
+	// Binds non-sparse buffers to their memory, sparse buffers are bound with vkQueueBindSparse
+	void bindMemory(VkDeviceMemory memory, VkDeviceSize memoryOffset = 0)
+	{
+		THROW_ON_VULKAN_ERROR(vkBindBufferMemory(this->device->device, this->buffer, memory, memoryOffset));
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	VkBuffer buffer{ nullptr };
+};
+
+
 class VulkanMemory {
 public:
 	VulkanMemory(
@@ -436,6 +724,7 @@ public:
 			.memoryTypeIndex = memoryTypeIndex,
 		};
 
+		TraceScope scope("vkAllocateMemory", memoryRequirements.size);
 		THROW_ON_VULKAN_ERROR(vkAllocateMemory(this->device->device, &allocate_info, nullptr, &this->memory));
 	}
 
@@ -444,11 +733,86 @@ public:
 		vkFreeMemory(this->device->device, this->memory, nullptr);
 	}
 
+	// Maps host visible memory, which stays mapped until it is freed
+	void* map()
+	{
+		void* data;
+		THROW_ON_VULKAN_ERROR(vkMapMemory(this->device->device, this->memory, 0, VK_WHOLE_SIZE, 0, &data));
+		return data;
+	}
+
 	std::shared_ptr<VulkanDevice> device{ nullptr };
 	VkDeviceMemory memory{ nullptr };
 };
 
 
+class VulkanCommandPool {
+public:
+	VulkanCommandPool(std::shared_ptr<VulkanDevice> device, uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags = 0) :
+		device(std::move(device))
+	{
+		VkCommandPoolCreateInfo createInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = flags,
+			.queueFamilyIndex = queueFamilyIndex,
+		};
+
+		THROW_ON_VULKAN_ERROR(vkCreateCommandPool(this->device->device, &createInfo, nullptr, &this->commandPool));
+	}
+
+	~VulkanCommandPool()
+	{
+		vkDestroyCommandPool(this->device->device, this->commandPool, nullptr);
+	}
+
+	std::shared_ptr<VulkanDevice> device{ nullptr };
+	VkCommandPool commandPool{ nullptr };
+};
+
+
+class VulkanCommandBuffer {
+public:
+	explicit VulkanCommandBuffer(std::shared_ptr<VulkanCommandPool> commandPool) :
+		commandPool(std::move(commandPool))
+	{
+		VkCommandBufferAllocateInfo allocateInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.commandPool = this->commandPool->commandPool,
+			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			.commandBufferCount = 1,
+		};
+
+		THROW_ON_VULKAN_ERROR(vkAllocateCommandBuffers(this->commandPool->device->device, &allocateInfo, &this->commandBuffer));
+	}
+
+	~VulkanCommandBuffer()
+	{
+		vkFreeCommandBuffers(this->commandPool->device->device, this->commandPool->commandPool, 1, &this->commandBuffer);
+	}
+
+	void begin(VkCommandBufferUsageFlags flags = 0)
+	{
+		VkCommandBufferBeginInfo beginInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = flags,
+			.pInheritanceInfo = nullptr,
+		};
+		THROW_ON_VULKAN_ERROR(vkBeginCommandBuffer(this->commandBuffer, &beginInfo));
+	}
+
+	void end()
+	{
+		THROW_ON_VULKAN_ERROR(vkEndCommandBuffer(this->commandBuffer));
+	}
+
+	std::shared_ptr<VulkanCommandPool> commandPool{ nullptr };
+	VkCommandBuffer commandBuffer{ nullptr };
+};
+
+
 class Timer {
 public:
 	~Timer() = default;
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <ResidencyManager.h>
+
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include <numbers>
+#include <algorithm>
+
+
+struct TileRequest {
+	TileCoordinate tile;
+	bool release{ false };		// the tile is no longer needed
+	uint32_t image{ 0 };		// of the images the tiles are spread over
+};
+
+
+// Generates the order in which the benchmark requests the tiles of a tileGrid sized
+// grid of mip level 0. The requests are generated before the benchmark starts, so
+// the generator does not take time from binding.
+class WorkloadGenerator {
+public:
+	virtual ~WorkloadGenerator() = default;
+	virtual std::vector<TileRequest> generate(VkExtent3D tileGrid) const = 0;
+};
+
+
+// x outermost, z innermost, the order of the original benchmark
+class LinearWorkload : public WorkloadGenerator {
+public:
+	std::vector<TileRequest> generate(VkExtent3D tileGrid) const override
+	{
+		std::vector<TileRequest> requests;
+		requests.reserve(size_t(tileGrid.width) * tileGrid.height * tileGrid.depth);
+		for (uint32_t x = 0; x < tileGrid.width; x++) {
+			for (uint32_t y = 0; y < tileGrid.height; y++) {
+				for (uint32_t z = 0; z < tileGrid.depth; z++) {
+					requests.push_back({ .tile = { .x = x, .y = y, .z = z } });
+				}
+			}
+		}
+		return requests;
+	}
+};
+
+
+// Z-order curve, so that tiles close in the image are also close in time
+class MortonWorkload : public WorkloadGenerator {
+public:
+	// the 21 low bits of value, moved to every third bit
+	static uint64_t spread(uint32_t value)
+	{
+		uint64_t code = value & 0x1fffff;
+		code = (code | (code << 32)) & 0x1f00000000ffff;
+		code = (code | (code << 16)) & 0x1f0000ff0000ff;
+		code = (code | (code << 8)) & 0x100f00f00f00f00f;
+		code = (code | (code << 4)) & 0x10c30c30c30c30c3;
+		code = (code | (code << 2)) & 0x1249249249249249;
+		return code;
+	}
+
+	static uint64_t getCode(const TileCoordinate& tile)
+	{
+		return spread(tile.x) | (spread(tile.y) << 1) | (spread(tile.z) << 2);
+	}
+
+	// sorts the tiles of the grid by their codes, rather than walking the codes of the
+	// enclosing power of two cube, which is mostly empty for long and flat grids
+	std::vector<TileRequest> generate(VkExtent3D tileGrid) const override
+	{
+		auto requests = LinearWorkload().generate(tileGrid);
+		std::ranges::sort(requests, {}, [](const TileRequest& request) { return getCode(request.tile); });
+		return requests;
+	}
+};
+
+
+// Every tile once, in uniformly random order
+class RandomWorkload : public WorkloadGenerator {
+public:
+	explicit RandomWorkload(uint64_t seed = 1) :
+		seed(seed)
+	{
+	}
+
+	std::vector<TileRequest> generate(VkExtent3D tileGrid) const override
+	{
+		auto requests = LinearWorkload().generate(tileGrid);
+		std::mt19937_64 random(this->seed);
+		std::shuffle(requests.begin(), requests.end(), random);
+		return requests;
+	}
+
+	uint64_t seed;
+};
+
+
+// One z slice after the other, x fastest, like a slice based volume loader
+class SlabWorkload : public WorkloadGenerator {
+public:
+	std::vector<TileRequest> generate(VkExtent3D tileGrid) const override
+	{
+		std::vector<TileRequest> requests;
+		requests.reserve(size_t(tileGrid.width) * tileGrid.height * tileGrid.depth);
+		for (uint32_t z = 0; z < tileGrid.depth; z++) {
+			for (uint32_t y = 0; y < tileGrid.height; y++) {
+				for (uint32_t x = 0; x < tileGrid.width; x++) {
+					requests.push_back({ .tile = { .x = x, .y = y, .z = z } });
+				}
+			}
+		}
+		return requests;
+	}
+};
+
+
+// A camera flies through the middle of the volume along x, looking along x. Every
+// step it moves by one tile, requests the tiles that came into its view frustum,
+// nearest first, and releases the tiles that left it, like a streamer following
+// the camera would.
+class CameraPathWorkload : public WorkloadGenerator {
+public:
+	CameraPathWorkload(double fieldOfView = 60.0, double farDistance = 0.5) :
+		fieldOfView(fieldOfView),
+		farDistance(farDistance)
+	{
+	}
+
+	std::vector<TileRequest> generate(VkExtent3D tileGrid) const override
+	{
+		// in tiles
+		auto far = std::max(1.0, this->farDistance * std::max({ tileGrid.width, tileGrid.height, tileGrid.depth }));
+		auto slope = std::tan(this->fieldOfView * std::numbers::pi / 360.0);
+		auto centerY = tileGrid.height / 2.0;
+		auto centerZ = tileGrid.depth / 2.0;
+
+		// tiles of the x slice at distance along the view direction, nearest to the view axis first
+		std::vector<std::pair<double, TileCoordinate>> visible;
+		auto isVisible = [&](double distance, double y, double z) {
+			auto radius = std::max(distance, 0.0) * slope + 0.5;
+			return distance >= -0.5 && distance <= far && std::abs(y) <= radius && std::abs(z) <= radius;
+		};
+
+		std::vector<TileRequest> requests;
+		std::vector<bool> resident(size_t(tileGrid.width) * tileGrid.height * tileGrid.depth, false);
+		auto index = [&](const TileCoordinate& tile) {
+			return (size_t(tile.z) * tileGrid.height + tile.y) * tileGrid.width + tile.x;
+		};
+
+		for (int64_t step = 0; step <= int64_t(tileGrid.width); step++) {
+			auto camera = double(step);
+
+			// release what is behind the camera or out of view
+			for (uint32_t x = 0; x < tileGrid.width; x++) {
+				for (uint32_t y = 0; y < tileGrid.height; y++) {
+					for (uint32_t z = 0; z < tileGrid.depth; z++) {
+						TileCoordinate tile{ .x = x, .y = y, .z = z };
+						if (resident[index(tile)] && !isVisible(x + 0.5 - camera, y + 0.5 - centerY, z + 0.5 - centerZ)) {
+							resident[index(tile)] = false;
+							requests.push_back({ .tile = tile, .release = true });
+						}
+					}
+				}
+			}
+
+			visible.clear();
+			auto last = std::min<double>(tileGrid.width, camera + far + 1.0);
+			for (auto x = uint32_t(std::max(0.0, camera - 1.0)); x < last; x++) {
+				for (uint32_t y = 0; y < tileGrid.height; y++) {
+					for (uint32_t z = 0; z < tileGrid.depth; z++) {
+						TileCoordinate tile{ .x = x, .y = y, .z = z };
+						auto dx = x + 0.5 - camera;
+						auto dy = y + 0.5 - centerY;
+						auto dz = z + 0.5 - centerZ;
+						if (!resident[index(tile)] && isVisible(dx, dy, dz)) {
+							resident[index(tile)] = true;
+							visible.emplace_back(dx * dx + dy * dy + dz * dz, tile);
+						}
+					}
+				}
+			}
+			std::stable_sort(visible.begin(), visible.end(), [](auto& lhs, auto& rhs) { return lhs.first < rhs.first; });
+			for (auto& [distance, tile] : visible) {
+				requests.push_back({ .tile = tile });
+			}
+		}
+		return requests;
+	}
+
+	double fieldOfView;		// degrees
+	double farDistance;		// fraction of the largest grid dimension
+};
+
+
+inline std::unique_ptr<WorkloadGenerator> createWorkloadGenerator(AccessPattern pattern)
+{
+	switch (pattern) {
+	case AccessPattern::Linear: return std::make_unique<LinearWorkload>();
+	case AccessPattern::Morton: return std::make_unique<MortonWorkload>();
+	case AccessPattern::Random: return std::make_unique<RandomWorkload>();
+	case AccessPattern::Slab: return std::make_unique<SlabWorkload>();
+	case AccessPattern::Camera: return std::make_unique<CameraPathWorkload>();
+	}
+	throw Exception("unknown access pattern");
+}
+
+
+// Precedes every requested tile with the tiles of the coarser mip levels that cover
+// it, coarsest first, the way a renderer has to make a region resident before it can
+// sample it with trilinear filtering. Every coarser tile is requested once, and is
+// not released with the tiles it covers.
+inline std::vector<TileRequest> addMipChain(const std::vector<TileRequest>& requests, const SparsePageTable& pageTable)
+{
+	std::vector<TileRequest> expanded;
+	expanded.reserve(requests.size() + pageTable.tileCount);
+	std::vector<bool> requested(pageTable.tileCount, false);
+	for (auto& request : requests) {
+		if (!request.release) {
+			for (auto mipLevel = static_cast<uint32_t>(pageTable.levels.size()) - 1; mipLevel > request.tile.mipLevel; mipLevel--) {
+				auto& tileGrid = pageTable.levels[mipLevel].tileGrid;
+				auto shift = mipLevel - request.tile.mipLevel;
+				TileCoordinate tile{
+					.x = std::min(request.tile.x >> shift, tileGrid.width - 1),
+					.y = std::min(request.tile.y >> shift, tileGrid.height - 1),
+					.z = std::min(request.tile.z >> shift, tileGrid.depth - 1),
+					.mipLevel = mipLevel,
+				};
+				auto index = pageTable.getTileIndex(tile);
+				if (!requested[index]) {
+					requested[index] = true;
+					expanded.push_back({ .tile = tile });
+				}
+			}
+		}
+		expanded.push_back(request);
+	}
+	return expanded;
+}
+
+
+// Repeats the requests of one image for every one of imageCount images of the same
+// extent, image after image in sequential order, or one request of every image in turn
+// in round-robin order, so that all images fill at the same rate. The images split the
+// configured extent between them and share the pool, and a batch binds the tiles of
+// each of its images in a VkSparseImageMemoryBindInfo of their own.
+inline std::vector<TileRequest> spreadOverImages(const std::vector<TileRequest>& requests, uint32_t imageCount, ImageOrder order)
+{
+	std::vector<TileRequest> spread;
+	spread.reserve(requests.size() * imageCount);
+	if (order == ImageOrder::Sequential) {
+		for (uint32_t image = 0; image < imageCount; image++) {
+			for (auto& request : requests) {
+				spread.push_back(request);
+				spread.back().image = image;
+			}
+		}
+	}
+	else {
+		for (auto& request : requests) {
+			for (uint32_t image = 0; image < imageCount; image++) {
+				spread.push_back(request);
+				spread.back().image = image;
+			}
+		}
+	}
+	return spread;
+}
@@ -1,164 +1,549 @@
-
 #include <VulkanObjects.h>
+#include <BenchmarkConfig.h>
+#include <BenchmarkDevice.h>
+#include <Benchmark.h>
+#include <ContentionBenchmark.h>
+#include <MultiDeviceBenchmark.h>
+#include <DeviceSelection.h>
+#include <Statistics.h>
+#include <ProcessCoordinator.h>
+#include <ResultWriter.h>
+#include <SimulatedDriver.h>
+#include <ThreadAffinity.h>
 
-#include <cmath>
+#include <vector>
 #include <memory>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 
-int main(int, const char* [])
+// "<stem> <suffix>.txt" next to filename
+static std::filesystem::path withSuffix(const std::filesystem::path& filename, const std::string& suffix)
+{
+	auto path = filename;
+	path.replace_filename(filename.stem().string() + " " + suffix + filename.extension().string());
+	return path;
+}
+
+// Makes the Vulkan loader load only the driver with the given ICD manifest, e.g. lavapipe's lvp_icd.x86_64.json
+static void selectDriver(const std::filesystem::path& manifest)
+{
+	auto path = std::filesystem::absolute(manifest).string();
+	// VK_ICD_FILENAMES for loaders older than 1.3.207
+	for (auto variable : { "VK_DRIVER_FILES", "VK_ICD_FILENAMES" }) {
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+		_putenv_s(variable, path.c_str());
+#else
+		setenv(variable, path.c_str(), 1);
+#endif
+	}
+}
+
+// The benchmark devices of a physical device, one per queue family selection of the sweep,
+// created when a combination first needs them
+class DeviceCache {
+public:
+	DeviceCache(std::shared_ptr<VulkanInstance> instance, std::shared_ptr<VulkanPhysicalDevice> physicalDevice, uint32_t workerQueueCount) :
+		instance(std::move(instance)),
+		physicalDevice(std::move(physicalDevice)),
+		workerQueueCount(workerQueueCount)
+	{
+	}
+
+	const BenchmarkDevice& get(const QueueFamilySelection& queueFamily)
+	{
+		for (auto& [selection, benchmarkDevice] : this->devices) {
+			if (selection == queueFamily) {
+				return *benchmarkDevice;
+			}
+		}
+		// BenchmarkDevice adds its queues to the physical device, so every device gets a fresh one
+		auto& benchmarkDevice = *this->devices.emplace_back(queueFamily, std::make_unique<BenchmarkDevice>(this->instance,
+			std::make_shared<VulkanPhysicalDevice>(this->physicalDevice->physicalDevice), this->workerQueueCount, queueFamily)).second;
+		auto family = benchmarkDevice.queue->queueFamilyIndex;
+		std::cout << std::format("{}: binding on queue family {} ({}, {} queues)", this->physicalDevice->deviceName(), family,
+			getQueueFlagsName(this->physicalDevice->physicalDeviceQueueFamilyProperties[family].queueFlags),
+			this->physicalDevice->physicalDeviceQueueFamilyProperties[family].queueCount) << std::endl;
+		return benchmarkDevice;
+	}
+
+	std::shared_ptr<VulkanInstance> instance{ nullptr };
+	std::shared_ptr<VulkanPhysicalDevice> physicalDevice{ nullptr };
+	uint32_t workerQueueCount{ 1 };
+	std::vector<std::pair<QueueFamilySelection, std::unique_ptr<BenchmarkDevice>>> devices;
+};
+
+// a single run keeps the original file name, sweeps get one file per combination
+static std::filesystem::path getResultFilename(const VulkanPhysicalDevice& physicalDevice, const BenchmarkParameters& parameters, size_t combinations)
+{
+	return (combinations == 1) ?
+		std::format("{} {}.txt", physicalDevice.deviceName(), physicalDevice.driverVersion()) :
+		std::format("{} {} {}.txt", physicalDevice.deviceName(), physicalDevice.driverVersion(), parameters.name());
+}
+
+// Writes a synthetic volume with the image extent, tile extent and levels the benchmark
+// resolves for parameters on the device
+static void writeVolume(const BenchmarkDevice& benchmarkDevice, BenchmarkParameters parameters, const std::filesystem::path& path)
+{
+	parameters.volume.clear();
+	parameters.upload = false;
+	SparseBindBenchmark benchmark(benchmarkDevice.device, benchmarkDevice.queue, parameters);
+	auto header = BrickedVolumeWriter::write(path, benchmark.imageExtent, benchmark.parameters.tileExtent,
+		parameters.format, static_cast<uint32_t>(benchmark.layout->levels.size()));
+	std::cout << std::format("Wrote {} tiles of {}x{}x{} {} in {} mip levels, {:.2f} GiB, to {}",
+		header.tileCount, header.tileExtent.width, header.tileExtent.height, header.tileExtent.depth,
+		getFormatName(header.format), header.mipLevels, std::filesystem::file_size(path) / double(1ULL << 30), path.string()) << std::endl;
+}
+
+static BenchmarkResult runSingleThreaded(
+	const BenchmarkDevice& benchmarkDevice,
+	const BenchmarkParameters& parameters,
+	const std::string& device_info,
+	const std::filesystem::path& filename,
+	const std::vector<OutputFormat>& outputFormats,
+	ProcessBarrier* barrier)
+{
+	SparseBindBenchmark benchmark(benchmarkDevice.device, benchmarkDevice.queue, parameters,
+		benchmarkDevice.controlQueue, benchmarkDevice.transferQueue);
+	std::cout << std::format(
+		"Image max extent: ({}, {}, {})",
+		benchmark.imageFormatProperties.maxExtent.width,
+		benchmark.imageFormatProperties.maxExtent.height,
+		benchmark.imageFormatProperties.maxExtent.depth) << std::endl;
+	if (benchmark.images.size() > 1) {
+		std::cout << std::format("{} images of ({}, {}, {}), bound {}", benchmark.images.size(),
+			benchmark.imageExtent.width, benchmark.imageExtent.height, benchmark.imageExtent.depth,
+			getImageOrderName(parameters.imageOrder)) << std::endl;
+	}
+	if (benchmark.buffer) {
+		std::cout << std::format("Sparse buffer: {} tiles of {} bytes",
+			benchmark.layout->tileCount, benchmark.tileSize) << std::endl;
+	}
+	else {
+		auto& sparseMemoryRequirements = benchmark.sparseMemoryRequirements;
+		std::cout << std::format(
+			"Sparse granularity: ({}, {}, {}), mip tail from level {} of {}, {} bytes",
+			sparseMemoryRequirements.formatProperties.imageGranularity.width,
+			sparseMemoryRequirements.formatProperties.imageGranularity.height,
+			sparseMemoryRequirements.formatProperties.imageGranularity.depth,
+			sparseMemoryRequirements.imageMipTailFirstLod,
+			benchmark.mipLevels,
+			sparseMemoryRequirements.imageMipTailSize) << std::endl;
+	}
+
+	if (barrier) {
+		barrier->arriveAndWait();
+	}
+	auto startTime = getWallClockMilliseconds();
+	auto result = benchmark.run();
+	if (barrier) {
+		barrier->writeSummary(filename, result.tilesBound(), startTime, getWallClockMilliseconds());
+	}
+
+	RunDescription run{
+		.physicalDevice = benchmarkDevice.device->physicalDevice,
+		.parameters = benchmark.parameters,
+		.imageExtent = benchmark.imageExtent,
+		.imageFormatProperties = benchmark.imageFormatProperties,
+		.sparseMemoryRequirements = benchmark.sparseMemoryRequirements,
+	};
+	ResultWriter::write(filename, outputFormats, device_info, run, result);
+
+	// in async mode the time spent in vkQueueBindSparse differs from the time to completion
+	if (parameters.bindMode == BindMode::Async) {
+		auto submitFilename = withSuffix(filename, "submit");
+		ResultWriter::writeText(submitFilename, device_info + " (submit)", ResultWriter::getSubmitTimes(result));
+		std::cout << "Wrote submit times to: " << submitFilename << std::endl;
+	}
+	auto tilePoolStatistics = benchmark.tilePool->getStatistics();
+	std::cout << std::format("Tile pool: {} block(s) of {} MiB, occupancy {:.1f}%, fragmentation {:.1f}%",
+		tilePoolStatistics.blocksAllocated,
+		benchmark.tilePool->blockSize >> 20,
+		100.0 * tilePoolStatistics.occupancy(),
+		100.0 * tilePoolStatistics.fragmentation(benchmark.tilePool->pagesPerBlock)) << std::endl;
+	if (parameters.memoryBudget > 0.0) {
+		auto source = benchmark.memoryBudget ?
+			std::format("VK_EXT_memory_budget: budget {} MiB, {} MiB in use", benchmark.memoryBudget->budget >> 20, benchmark.memoryBudget->usage >> 20) :
+			std::string("the heap size, without VK_EXT_memory_budget");
+		std::cout << std::format("Memory budget: pool limited to {} MiB, {} of the {} MiB left on the heap ({})",
+			result.poolLimit >> 20, parameters.memoryBudget, benchmark.memoryAvailable >> 20, source) << std::endl;
+	}
+	if (parameters.elasticPool || parameters.compactThreshold > 0.0) {
+		std::cout << std::format("Pool: peak {} MiB, {} block(s) allocated and {} released during the run, {} allocation(s) failed",
+			result.peakPoolSize >> 20, result.blocksAllocated, result.blocksReleased, result.allocationFailures) << std::endl;
+	}
+	if (parameters.compactThreshold > 0.0) {
+		auto tilesMoved = result.tilesMoved();
+		std::cout << std::format("Compaction: {} compaction(s) moved {} tiles in {:.1f} ms ({:.3f} ms per tile), released {} MiB",
+			result.compactions.size(), tilesMoved, result.compactionTime(),
+			tilesMoved ? result.compactionTime() / tilesMoved : 0.0, result.compactionBytesReleased() >> 20) << std::endl;
+	}
+	if (parameters.coalesce) {
+		size_t bindEntries = 0;
+		for (auto& batch : result.batches) {
+			bindEntries += batch.bindEntries;
+		}
+		auto tiles = result.tilesBound() + result.tilesUnbound();
+		std::cout << std::format("Coalescing: {} tiles in {} binds ({:.1f} tiles per bind)",
+			tiles, bindEntries, bindEntries ? double(tiles) / bindEntries : 0.0) << std::endl;
+	}
+	std::cout << std::format("Sustained: {:.0f} binds/s", result.bindsPerSecond()) << std::endl;
+	auto& tileExtent = benchmark.parameters.tileExtent;
+	std::cout << std::format("Per tile bind: {}x{}x{} texels in {} KiB, {:.0f} MiB/s and {:.1f} Mtexels/s bound",
+		tileExtent.width, tileExtent.height, tileExtent.depth, result.tileSize >> 10,
+		result.bytesPerSecond() / double(1 << 20), result.texelsPerSecond() / 1e6) << std::endl;
+	if (benchmark.images.size() > 1) {
+		// completion times over the coverage of the image bound and of all images
+		auto imageBuckets = ResultWriter::getCoverageBuckets(std::span(&result, 1), true);
+		auto totalBuckets = ResultWriter::getCoverageBuckets(std::span(&result, 1));
+		for (size_t bucket = 0; bucket < imageBuckets.size(); bucket++) {
+			std::cout << std::format("  coverage {:3.0f}-{:3.0f}%: {:.3f} ms per batch by image coverage, {:.3f} ms by total coverage",
+				imageBuckets[bucket].from, imageBuckets[bucket].to,
+				imageBuckets[bucket].completion.mean(), totalBuckets[bucket].completion.mean()) << std::endl;
+		}
+	}
+	if (!result.frames.empty()) {
+		std::cout << std::format("Frame budget {} ms: {} frames, {:.1f}% within budget, {:.1f} tiles/frame",
+			parameters.frameBudget, result.frames.size(), 100.0 * result.budgetHitRate(), result.tilesPerFrame()) << std::endl;
+	}
+	if (parameters.overlap != OverlapMode::None) {
+		std::cout << std::format("Overlap on the {} queue: work {:.3f} ms alone, serialization {:.2f} (0 concurrent, 1 serialized)",
+			getOverlapModeName(parameters.overlap), result.workTime, result.serialization()) << std::endl;
+	}
+	if (parameters.upload) {
+		Statistics latency(result.tileLatencies);
+		std::cout << std::format("Upload: {} tiles, {:.0f} MB/s, request to sampleable mean {:.3f} ms, p50 {:.3f} ms, p99 {:.3f} ms",
+			latency.count(), result.uploadMegabytesPerSecond(), latency.mean(), latency.percentile(50), latency.percentile(99)) << std::endl;
+		auto latencyFilename = withSuffix(filename, "latency");
+		ResultWriter::writeText(latencyFilename, device_info + " (request to sampleable)", result.tileLatencies);
+		std::cout << "Wrote tile latencies to: " << latencyFilename << std::endl;
+		if (!parameters.volume.empty()) {
+			std::cout << std::format("Volume reads ({}): {:.1f} ms on the binding thread, {:.1f}% of the run",
+				getVolumeReaderModeName(parameters.volumeReader), result.readTime,
+				result.totalTime > 0.0 ? 100.0 * result.readTime / result.totalTime : 0.0) << std::endl;
+		}
+	}
+	if (parameters.nullTiles > 0.0) {
+		auto residentTiles = benchmark.residencyManager->pageTable.residentCount;
+		auto residentMemory = VkDeviceSize(residentTiles) * result.tileSize;
+		std::cout << std::format("Null tiles: {} of {} resident tiles share one page, {} promoted on write, {} MiB saved ({:.1f}% of {} MiB)",
+			result.nullTilesResident, residentTiles, result.promotions, result.nullMemorySaved() >> 20,
+			residentMemory ? 100.0 * result.nullMemorySaved() / residentMemory : 0.0, residentMemory >> 20) << std::endl;
+	}
+	if (parameters.residencyMode == ResidencyMode::Churn) {
+		if (result.churnStartTime < 0.0) {
+			std::cout << "Churn: the pool holds every tile, nothing was evicted" << std::endl;
+		}
+		else {
+			std::cout << std::format("Churn: {} tiles evicted, {:.0f} binds/s once the pool was full",
+				result.tilesUnbound(), result.churnBindsPerSecond()) << std::endl;
+		}
+	}
+	std::cout << std::endl;
+	return result;
+}
+
+// Runs the benchmark parameters.repetitions times, each run with a fresh image and pool
+// and its own result files, and summarizes the completion times of all runs per coverage
+static void runRepetitions(
+	const BenchmarkDevice& benchmarkDevice,
+	const BenchmarkParameters& parameters,
+	const std::string& device_info,
+	const std::filesystem::path& filename,
+	const std::vector<OutputFormat>& outputFormats,
+	ProcessBarrier* barrier)
+{
+	if (parameters.repetitions <= 1) {
+		runSingleThreaded(benchmarkDevice, parameters, device_info, filename, outputFormats, barrier);
+		return;
+	}
+
+	std::vector<BenchmarkResult> results;
+	for (uint32_t repetition = 0; repetition < parameters.repetitions; repetition++) {
+		std::cout << std::format("Repetition {} of {}", repetition + 1, parameters.repetitions) << std::endl;
+		results.push_back(runSingleThreaded(benchmarkDevice, parameters, device_info,
+			withSuffix(filename, std::format("rep{}", repetition)), outputFormats, barrier));
+	}
+
+	auto repetitionsFilename = withSuffix(filename, "repetitions");
+	ResultWriter::writeRepetitions(repetitionsFilename, device_info, results);
+
+	std::vector<double> bindsPerSecond;
+	for (auto& result : results) {
+		bindsPerSecond.push_back(result.bindsPerSecond());
+	}
+	Statistics throughput(bindsPerSecond);
+	std::cout << std::format("Repetitions: {:.0f} binds/s +- {:.0f} (95% CI) over {} runs, {} outlier run(s)",
+		throughput.mean(), throughput.confidenceInterval95(), results.size(), throughput.outliers()) << std::endl;
+	for (auto& bucket : ResultWriter::getCoverageBuckets(results)) {
+		if (bucket.completion.count() == 0) {
+			continue;
+		}
+		std::cout << std::format("  coverage {:3.0f}-{:3.0f}%: {:.3f} ms +- {:.3f} per batch, {} of {} batches outliers",
+			bucket.from, bucket.to, bucket.completion.mean(), bucket.completion.confidenceInterval95(),
+			bucket.completion.outliers(), bucket.completion.count()) << std::endl;
+	}
+	std::cout << "Wrote repetitions to: " << repetitionsFilename << std::endl << std::endl;
+}
+
+static void runContention(
+	const BenchmarkDevice& benchmarkDevice,
+	const BenchmarkParameters& parameters,
+	const std::string& device_info,
+	const std::filesystem::path& filename,
+	const std::vector<OutputFormat>& outputFormats,
+	ProcessBarrier* barrier)
+{
+	std::cout << std::format("Binding from {} threads on {} queue(s)", parameters.threads,
+		std::min<size_t>(parameters.threads, benchmarkDevice.workerQueues.size())) << std::endl;
+
+	ContentionBenchmark benchmark(benchmarkDevice, parameters);
+	auto controlFilename = withSuffix(filename, "control");
+	if (barrier) {
+		barrier->arriveAndWait();
+	}
+	auto startTime = getWallClockMilliseconds();
+	auto result = benchmark.run();
+	if (barrier) {
+		size_t tilesBound = 0;
+		for (auto& worker : result.workers) {
+			tilesBound += worker.tilesBound();
+		}
+		barrier->writeSummary(controlFilename, tilesBound, startTime, getWallClockMilliseconds());
+	}
+
+	for (size_t worker = 0; worker < result.workers.size(); worker++) {
+		RunDescription run{
+			.physicalDevice = benchmarkDevice.device->physicalDevice,
+			.parameters = benchmark.workers[worker]->parameters,
+			.imageExtent = benchmark.workers[worker]->imageExtent,
+			.imageFormatProperties = benchmark.workers[worker]->imageFormatProperties,
+			.sparseMemoryRequirements = benchmark.workers[worker]->sparseMemoryRequirements,
+			.label = std::format("worker {}", worker),
+		};
+		ResultWriter::write(withSuffix(filename, std::format("worker{}", worker)), outputFormats,
+			std::format("{} (worker {})", device_info, worker), run, result.workers[worker]);
+	}
+	ResultWriter::writeText(controlFilename, device_info + " (control)", result.controlLatencies);
+
+	Statistics baseline(result.baselineLatencies);
+	Statistics control(result.controlLatencies);
+	std::cout << std::format("Aggregate: {:.0f} binds/s", result.bindsPerSecond()) << std::endl;
+	for (size_t worker = 0; worker < result.workers.size(); worker++) {
+		std::cout << std::format("  worker {}: {:.0f} binds/s", worker, result.workers[worker].bindsPerSecond()) << std::endl;
+	}
+	std::cout << std::format("Control latency: mean {:.3f} ms, p99 {:.3f} ms (baseline mean {:.3f} ms, p99 {:.3f} ms), inflation x{:.2f}",
+		control.mean(), control.percentile(99.0), baseline.mean(), baseline.percentile(99.0), result.latencyInflation()) << std::endl;
+	std::cout << "Wrote control latencies to: " << controlFilename << std::endl << std::endl;
+}
+
+// Runs the combination on every device alone and then on all devices at the same time
+static void runConcurrentDevices(
+	std::vector<DeviceCache>& deviceCaches,
+	const BenchmarkParameters& parameters,
+	size_t combinations,
+	const std::vector<OutputFormat>& outputFormats,
+	ProcessBarrier* barrier)
 {
+	if (parameters.threads > 0) {
+		throw Exception("--concurrent-devices runs the single threaded benchmark, without --threads");
+	}
+	std::vector<const BenchmarkDevice*> benchmarkDevices;
+	std::vector<std::filesystem::path> filenames;
+	for (auto& deviceCache : deviceCaches) {
+		benchmarkDevices.push_back(&deviceCache.get(parameters.queueFamily));
+		auto filename = getResultFilename(*deviceCache.physicalDevice, parameters, combinations);
+		filenames.push_back(barrier ? barrier->getResultPath(filename) : filename);
+	}
+	std::cout << std::format("Binding on {} devices at the same time", benchmarkDevices.size()) << std::endl;
+
+	MultiDeviceBenchmark benchmark(benchmarkDevices, parameters);
+	if (barrier) {
+		barrier->arriveAndWait();
+	}
+	auto startTime = getWallClockMilliseconds();
+	auto result = benchmark.run();
+	if (barrier) {
+		size_t tilesBound = 0;
+		for (auto& deviceResult : result.concurrent) {
+			tilesBound += deviceResult.tilesBound();
+		}
+		barrier->writeSummary(withSuffix(filenames.front(), "devices"), tilesBound, startTime, getWallClockMilliseconds());
+	}
+
+	std::cout << std::format("Aggregate: {:.0f} binds/s", result.bindsPerSecond()) << std::endl;
+	for (size_t device = 0; device < benchmarkDevices.size(); device++) {
+		auto& physicalDevice = benchmarkDevices[device]->device->physicalDevice;
+		auto device_info = std::format("{}, Driver version: {}", physicalDevice->deviceName(), physicalDevice->driverVersion());
+		RunDescription run{
+			.physicalDevice = physicalDevice,
+			.parameters = benchmark.benchmarks[device]->parameters,
+			.imageExtent = benchmark.benchmarks[device]->imageExtent,
+			.imageFormatProperties = benchmark.benchmarks[device]->imageFormatProperties,
+			.sparseMemoryRequirements = benchmark.benchmarks[device]->sparseMemoryRequirements,
+			.label = "alone",
+		};
+		ResultWriter::write(withSuffix(filenames[device], "alone"), outputFormats, device_info + " (alone)", run, result.alone[device]);
+		run.label = "concurrent";
+		ResultWriter::write(withSuffix(filenames[device], "concurrent"), outputFormats, device_info + " (concurrent)", run, result.concurrent[device]);
+		std::cout << std::format("  {}: {:.0f} binds/s alone, {:.0f} binds/s concurrent, slowdown x{:.2f}", physicalDevice->deviceName(),
+			result.alone[device].bindsPerSecond(), result.concurrent[device].bindsPerSecond(), result.slowdown(device)) << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+// Writes the trace, if tracing is on
+static void writeTrace(const std::filesystem::path& path)
+{
+	if (Trace::isEnabled()) {
+		auto events = Trace::write(path);
+		std::cout << std::format("Wrote {} trace events to: {}", events, path.string()) << std::endl;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	std::filesystem::path tracePath;
+	std::optional<ProcessBarrier> barrier;
 	try {
-		THROW_ON_VULKAN_ERROR(volkInitialize());
+		auto config = BenchmarkConfig::parse(argc, argv);
+		if (config.help) {
+			std::cout << BenchmarkConfig::usage;
+			return EXIT_SUCCESS;
+		}
+		auto sweep = config.sweep();
+
+		if (!config.processCounts.empty()) {
+			// the coordinator merges only the plain text results of its children
+			if (std::ranges::any_of(config.outputFormats, [](auto format) { return format != OutputFormat::Text; })) {
+				throw Exception("--processes writes only txt results, --output json and csv are not supported with it");
+			}
+			ProcessCoordinator coordinator(argc, argv, config.processCounts);
+			return coordinator.run();
+		}
+
+		if (config.child >= 0) {
+			barrier.emplace(config.childDirectory, config.child, config.childCount);
+			// child processes pin to consecutive ranges of CPUs, one for the main thread and one per worker
+			for (auto& parameters : sweep) {
+				if (parameters.pinCpu >= 0) {
+					parameters.pinCpu += config.child * static_cast<int32_t>(parameters.threads + 1);
+				}
+			}
+		}
+
+		// child processes write one trace each
+		if (!config.trace.empty()) {
+			tracePath = (config.child >= 0) ? withSuffix(config.trace, std::format("child{}", config.child)) : config.trace;
+			Trace::enable();
+			Trace::setThreadName("main");
+		}
+
+		if (config.simulation.enabled()) {
+			SimulatedDriver::install(config.simulation);
+		}
+		else {
+			if (!config.driver.empty()) {
+				selectDriver(config.driver);
+			}
+			THROW_ON_VULKAN_ERROR(volkInitialize());
+		}
 
 		auto instance = std::make_shared<VulkanInstance>();
 
-		auto physicalDevices = instance->getVulkanPhysicalDevices();
+		auto physicalDevices = selectDevices(instance->getVulkanPhysicalDevices(), config.devices);
 		if (physicalDevices.empty()) {
-			throw Exception("No Vulkan Devices found!");
+			throw Exception(config.devices.empty() ? "No Vulkan Devices found!" : "No Vulkan device matches --device");
 		}
 
+		std::vector<DeviceCache> deviceCaches;
 		for (auto& physicalDevice : physicalDevices) {
-			auto device_info = std::format("{}, Driver version: {}", physicalDevice->deviceName(), physicalDevice->driverVersion());
-			std::cout << device_info << std::endl;
-
-			auto graphicsQueueFamilyIndex = physicalDevice->getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_SPARSE_BINDING_BIT);
-			auto graphicsQueueIndex = physicalDevice->addQueue(graphicsQueueFamilyIndex);
+			deviceCaches.emplace_back(instance, physicalDevice, std::max(config.maxThreads(), 1u));
+		}
+		auto barrierPointer = barrier ? &barrier.value() : nullptr;
 
-			auto device = std::make_shared<VulkanDevice>(instance, physicalDevice, physicalDevice->deviceQueueCreateInfos);
-			auto graphicsQueue = std::make_shared<VulkanQueue>(device, graphicsQueueFamilyIndex, graphicsQueueIndex);
-			auto fence = std::make_shared<VulkanFence>(device);
+		if (config.concurrentDevices && deviceCaches.size() > 1) {
+			for (auto& parameters : sweep) {
+				try {
+					if (sweep.size() > 1) {
+						std::cout << "Parameters: " << parameters.name() << std::endl;
+					}
+					if (parameters.pinCpu >= 0) {
+						pinThread(static_cast<uint32_t>(parameters.pinCpu));
+					}
+					runConcurrentDevices(deviceCaches, parameters, sweep.size(), config.outputFormats, barrierPointer);
+				}
+				catch (const std::exception& e) {
+					// a child that skipped a run would wait for the others at the barrier of the next one
+					if (sweep.size() == 1 || barrier) {
+						throw;
+					}
+					std::cerr << std::format("Skipping {}: {}", parameters.name(), e.what()) << std::endl << std::endl;
+				}
+			}
+			writeTrace(tracePath);
+			return EXIT_SUCCESS;
+		}
 
-			VulkanImage::Config imageConfig{
-				.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT,
-				.imageType = VK_IMAGE_TYPE_3D,
-				.format = VK_FORMAT_R8_SNORM,
-				.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-			};
+		for (auto& deviceCache : deviceCaches) {
+			auto& physicalDevice = deviceCache.physicalDevice;
+			auto device_info = std::format("{}, Driver version: {}", physicalDevice->deviceName(), physicalDevice->driverVersion());
+			std::cout << device_info << std::endl;
 
 			auto sparseAddressSpaceSize = physicalDevice->getSparseAddressSpaceSize();
 			std::cout << std::format("Sparse address space: {} TiB",
 				sparseAddressSpaceSize / double(1ULL << 40)) << std::endl;
 
-			auto imageFormatProperties = physicalDevice->getPhysicalDeviceImageFormatProperties(
-				imageConfig.format,
-				imageConfig.imageType,
-				imageConfig.tiling,
-				imageConfig.usage,
-				imageConfig.flags);
-
-			std::cout << std::format(
-				"Image max extent: ({}, {}, {})",
-				imageFormatProperties.maxExtent.width,
-				imageFormatProperties.maxExtent.height,
-				imageFormatProperties.maxExtent.depth) << std::endl;
-
-			VkExtent3D imageExtent{
-				std::min(imageFormatProperties.maxExtent.width, 4096u),
-				std::min(imageFormatProperties.maxExtent.height, 4096u),
-				std::min(imageFormatProperties.maxExtent.depth, 1024u),
-			};
-
-			auto imageSize =
-				static_cast<VkDeviceSize>(imageExtent.width) *
-				static_cast<VkDeviceSize>(imageExtent.height) *
-				static_cast<VkDeviceSize>(imageExtent.depth);
-
-			if (imageSize > sparseAddressSpaceSize) {
-				throw Exception("not enough sparse address space for image size.");
+			if (!config.writeVolume.empty()) {
+				writeVolume(deviceCache.get(sweep.front().queueFamily), sweep.front(), config.writeVolume);
+				return EXIT_SUCCESS;
 			}
 
-			auto maxExtent = std::max(imageExtent.width, std::max(imageExtent.height, imageExtent.depth));
-			auto numLevels = std::floor(std::log2(maxExtent)) + 1;
-			imageConfig.extent = imageExtent;
-			imageConfig.mipLevels = static_cast<uint32_t>(numLevels);
-
-			auto image = std::make_shared<VulkanImage>(device, imageConfig);
-
-			auto memoryRequirements = device->getMemoryRequirements(image->image);
-			memoryRequirements.size = size_t(1) << 30; // 1 GiB
-			auto memory = std::make_shared<VulkanMemory>(device, memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-			auto tileExtent = VkExtent3D{ 64, 64, 64 };
-			VkDeviceSize tileSize = VkDeviceSize(tileExtent.width) * VkDeviceSize(tileExtent.height) * VkDeviceSize(tileExtent.depth);
-
-			const size_t batchSize = 16;
-			std::vector<double> bindTimes;
-			std::vector<VkSparseImageMemoryBind> sparseImageMemoryBinds;
-			VkSparseImageMemoryBindInfo sparseImageMemoryBindInfo;
-
-			const uint32_t num_tiles_i = imageExtent.width / tileExtent.width;
-			const uint32_t num_tiles_j = imageExtent.height / tileExtent.height;
-			const uint32_t num_tiles_k = imageExtent.depth / tileExtent.depth;
-			const uint32_t numBinds = num_tiles_i * num_tiles_j * num_tiles_k;
-
-			size_t bind = 0;
-			std::cout << "Timing binds";
-			for (uint32_t i = 0; i < num_tiles_i; i++) {
-				for (uint32_t j = 0; j < num_tiles_j; j++) {
-					for (uint32_t k = 0; k < num_tiles_k; k++) {
-
-						sparseImageMemoryBinds.emplace_back(
-							VkSparseImageMemoryBind{
-								.subresource = VkImageSubresource{
-									.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-									.mipLevel = 0,
-									.arrayLayer = 0,
-								},
-								.offset = VkOffset3D{
-									int32_t(i * tileExtent.width),
-									int32_t(j * tileExtent.height),
-									int32_t(k * tileExtent.depth),
-								},
-								.extent = tileExtent,
-								.memory = memory->memory,
-								.memoryOffset = (bind * tileSize) % memoryRequirements.size,
-								.flags = 0,
-							});
-
-						if (sparseImageMemoryBinds.size() % batchSize == 0) {
-							sparseImageMemoryBindInfo = {
-								.image = image->image,
-								.bindCount = static_cast<uint32_t>(sparseImageMemoryBinds.size()),
-								.pBinds = sparseImageMemoryBinds.data(),
-							};
-
-							{
-								Timer timer;
-								graphicsQueue->bindSparse(sparseImageMemoryBindInfo, fence->fence);
-								fence->waitAndReset();
-								bindTimes.push_back(timer.getElapsedTimeMilliseconds());
-							}
-
-							sparseImageMemoryBinds.clear();
-						}
-
-						if (bind % (numBinds / 10) == 0) {
-							std::cout << ".";
-						}
-						bind++;
-					}
+			for (auto& parameters : sweep) {
+				auto filename = getResultFilename(*physicalDevice, parameters, sweep.size());
+				if (barrier) {
+					filename = barrier->getResultPath(filename);
 				}
-			}
-
-			std::filesystem::path filename = std::format("{} {}.txt",
-				physicalDevice->deviceName(), physicalDevice->driverVersion());
 
-			std::ofstream outFile(filename);
-			if (outFile.is_open()) {
-				outFile << device_info << std::endl;
-				for (auto& bindTime : bindTimes) {
-					outFile << bindTime << std::endl;
+				try {
+					if (sweep.size() > 1) {
+						std::cout << "Parameters: " << parameters.name() << std::endl;
+					}
+					auto& benchmarkDevice = deviceCache.get(parameters.queueFamily);
+					if (parameters.pinCpu >= 0) {
+						pinThread(static_cast<uint32_t>(parameters.pinCpu));
+					}
+					if (parameters.threads > 0) {
+						runContention(benchmarkDevice, parameters, device_info, filename, config.outputFormats, barrierPointer);
+					}
+					else {
+						runRepetitions(benchmarkDevice, parameters, device_info, filename, config.outputFormats, barrierPointer);
+					}
+				}
+				catch (const std::exception& e) {
+					if (sweep.size() == 1 || barrier) {
+						throw;
+					}
+					// an unsupported combination should not end the whole sweep
+					std::cerr << std::format("Skipping {}: {}", parameters.name(), e.what()) << std::endl << std::endl;
 				}
 			}
-			std::cout << " Wrote results to: " << filename << std::endl << std::endl;
 		}
+		writeTrace(tracePath);
 		return EXIT_SUCCESS;
 	}
 	catch (const std::exception& e) {
 		std::cerr << e.what();
+		// the other children stop waiting for this one at the barrier
+		if (barrier) {
+			barrier->abort();
+		}
+		// the trace shows what led to the failure
+		writeTrace(tracePath);
 		return EXIT_FAILURE;
 	}
 }